@@ -8,7 +8,10 @@
 
 #include <asm/addrspace.h>
 
-#if defined(CONFIG_MACH_LOONGSON) || defined(CONFIG_MIPS_MALTA)
+#if defined(CONFIG_LOONGSON_MACH3X)
+#define UART_BASE 0x1fe001e0
+#define PORT(offset) (CKSEG1ADDR(UART_BASE) + (offset))
+#elif defined(CONFIG_MACH_LOONGSON) || defined(CONFIG_MIPS_MALTA)
 #define UART_BASE 0x1fd003f8
 #define PORT(offset) (CKSEG1ADDR(UART_BASE) + (offset))
 #endif
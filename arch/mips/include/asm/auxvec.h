@@ -1,4 +1,6 @@
 #ifndef _ASM_AUXVEC_H
 #define _ASM_AUXVEC_H
 
+#define AT_SYSINFO_EHDR		33
+
 #endif /* _ASM_AUXVEC_H */
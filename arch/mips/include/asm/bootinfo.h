@@ -69,7 +69,8 @@
 #define MACH_DEXXON_GDIUM2F10  5
 #define MACH_LEMOTE_NAS        6
 #define MACH_LEMOTE_LL2F       7
-#define MACH_LOONGSON_END      8
+#define MACH_LOONGSON_3A       8
+#define MACH_LOONGSON_END      9
 
 extern char *system_type;
 const char *get_system_type(void);
@@ -119,4 +120,10 @@ extern unsigned long fw_arg0, fw_arg1, fw_arg2, fw_arg3;
  */
 extern void plat_mem_setup(void);
 
+/*
+ * Sets up the bootmem allocator of every node on NUMA platforms other
+ * than the IP27; everything below reserved_end (a pfn) is in use.
+ */
+extern void plat_bootmem_init(unsigned long reserved_end);
+
 #endif /* _ASM_BOOTINFO_H */
@@ -367,4 +367,21 @@ extern int dump_task_fpu(struct task_struct *, elf_fpregset_t *);
 #define ELF_ET_DYN_BASE         (TASK_SIZE / 3 * 2)
 #endif
 
+/*
+ * Only native tasks are told about the vDSO; 32-bit tasks on a 64-bit
+ * kernel just use its signal trampolines.  Update AT_VECTOR_SIZE_ARCH
+ * if the number of NEW_AUX_ENT entries changes.
+ */
+#define ARCH_DLINFO							\
+do {									\
+	if (current->mm->context.vdso)					\
+		NEW_AUX_ENT(AT_SYSINFO_EHDR,				\
+			    (unsigned long)current->mm->context.vdso);	\
+} while (0)
+
+#define ARCH_HAS_SETUP_ADDITIONAL_PAGES 1
+struct linux_binprm;
+extern int arch_setup_additional_pages(struct linux_binprm *bprm,
+				       int uses_interp);
+
 #endif /* _ASM_ELF_H */
@@ -36,6 +36,10 @@
 #define PIC_ICW4_AEOI		2
 
 extern spinlock_t i8259A_lock;
+extern unsigned int cached_irq_mask;
+extern int i8259A_lazy_mask;
+
+extern int i8259A_mask_pending(unsigned int pending);
 
 extern int i8259A_irq_pending(unsigned int irq);
 extern void make_8259A_irq(unsigned int irq);
@@ -0,0 +1,86 @@
+/*
+ * Boot parameters passed by the LEFI firmware of the Loongson 3 machines.
+ *
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ */
+
+#ifndef __ASM_MACH_LOONGSON_BOOT_PARAM_H
+#define __ASM_MACH_LOONGSON_BOOT_PARAM_H
+
+#include <linux/types.h>
+
+#define SYSTEM_RAM_LOW		1
+#define SYSTEM_RAM_HIGH		2
+#define MEM_RESERVED		3
+
+#define LOONGSON3_BOOT_MEM_MAP_MAX	128
+
+struct efi_memory_map_loongson {
+	u16 vers;		/* version of efi_memory_map */
+	u32 nr_map;		/* number of memory_maps */
+	u32 mem_freq;		/* memory frequence */
+	struct mem_map {
+		u32 node_id;	/* node_id which memory attached to */
+		u32 mem_type;	/* system memory, pci memory, pci io, etc. */
+		u64 mem_start;	/* memory map start address */
+		u32 mem_size;	/* each memory_map size, in MB */
+	} map[LOONGSON3_BOOT_MEM_MAP_MAX];
+} __attribute__((packed));
+
+struct efi_cpuinfo_loongson {
+	u16 vers;		/* version of efi_cpuinfo_loongson */
+	u32 processor_id;	/* PRID, e.g. 6305 for Loongson 3A */
+	u32 cputype;		/* Loongson_3A/3B, etc. */
+	u32 total_node;		/* num of total numa nodes */
+	u16 cpu_startup_core_id; /* Boot core id */
+	u16 reserved_cores_mask;
+	u32 cpu_clock_freq;	/* cpu_clock */
+	u32 nr_cpus;
+} __attribute__((packed));
+
+/* all the other tables are given as offsets from this structure */
+struct loongson_params {
+	u64 memory_offset;	/* efi_memory_map_loongson struct offset */
+	u64 cpu_offset;		/* efi_cpuinfo_loongson struct offset */
+	u64 system_offset;	/* system_loongson struct offset */
+	u64 irq_offset;		/* irq_source_routing_table struct offset */
+	u64 interface_offset;	/* interface_info struct offset */
+	u64 special_offset;	/* loongson_special_attribute struct offset */
+	u64 boarddev_table_offset;  /* board_devices offset */
+};
+
+struct smbios_tables {
+	u16 vers;		/* version of smbios */
+	u64 vga_bios;		/* vga_bios address */
+	struct loongson_params lp;
+};
+
+struct efi_reset_system_t {
+	u64 ResetCold;
+	u64 ResetWarm;
+	u64 ResetType;
+	u64 Shutdown;
+	u64 DoSuspend;		/* NULL if not support */
+};
+
+struct efi_loongson {
+	u64 mps;		/* MPS table */
+	u64 acpi;		/* ACPI table (IA64 ext 0.71) */
+	u64 acpi20;		/* ACPI table (ACPI 2.0) */
+	struct smbios_tables smbios;	/* SM BIOS table */
+	u64 sal_systab;		/* SAL system table */
+	u64 boot_info;		/* boot info table */
+};
+
+struct boot_params {
+	struct efi_loongson efi;
+	struct efi_reset_system_t reset_system;
+};
+
+extern struct efi_memory_map_loongson *loongson_memmap;
+extern struct efi_reset_system_t *loongson_reset_system;
+
+#endif /* __ASM_MACH_LOONGSON_BOOT_PARAM_H */
@@ -27,6 +27,15 @@ static inline void __maybe_unused enable_mfgpt0_counter(void)
 #define MFGPT_TICK_RATE 14318000
 #define COMPARE  ((MFGPT_TICK_RATE + HZ/2) / HZ)
 
+/*
+ * One-shot limits, in MFGPT ticks: the counter and comparators are 16 bits
+ * wide, and reprogramming them takes four slow accesses through the south
+ * bridge (~1us each), so don't accept deltas that would expire before the
+ * counter has been restarted.
+ */
+#define MFGPT_MAX_DELTA	0xffff
+#define MFGPT_MIN_DELTA	0x40
+
 #define MFGPT_BASE	mfgpt_base
 #define MFGPT0_CMP2	(MFGPT_BASE + 2)
 #define MFGPT0_CNT	(MFGPT_BASE + 4)
@@ -18,8 +18,15 @@
 extern unsigned char ec_read(unsigned short addr);
 extern void ec_write(unsigned short addr, unsigned char val);
 extern int ec_query_seq(unsigned char cmd);
+extern int ec_query_seq_atomic(unsigned char cmd);
 extern int ec_query_event_num(void);
 extern int ec_get_event_num(void);
+extern int ec_get_event_num_atomic(void);
+extern int ec_cache_register(unsigned short addr);
+extern void ec_cache_unregister_all(void);
+extern void ec_cache_pause(void);
+extern void ec_cache_resume(void);
+extern unsigned char ec_read_cached(unsigned short addr);
 
 typedef int (*sci_handler) (int status);
 extern sci_handler yeeloong_report_lid_status;
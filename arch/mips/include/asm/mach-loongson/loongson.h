@@ -48,6 +48,25 @@ static inline void prom_init_uart_base(void)
 #include <asm/setup.h>
 extern char loongson_cmdline[COMMAND_LINE_SIZE];
 
+/* cpufreq aware clocksource */
+#ifdef CONFIG_CSRC_LOONGSON2F
+extern void __init init_loongson2f_clocksource(void);
+extern int loongson2f_clocksource_in_use;
+/* the count register stops with the core clock, and the time with it */
+static inline int loongson2f_can_stop_clock(void)
+{
+	return !loongson2f_clocksource_in_use;
+}
+#else
+static inline void init_loongson2f_clocksource(void)
+{
+}
+static inline int loongson2f_can_stop_clock(void)
+{
+	return 1;
+}
+#endif
+
 /* irq operation functions */
 extern void bonito_irqdispatch(void);
 extern void __init bonito_irq_init(void);
@@ -69,6 +88,27 @@ extern int mach_i8259_irq(void);
 #define LOONGSON_IRQ_BASE	32
 #define LOONGSON2_PERFCNT_IRQ	(MIPS_CPU_IRQ_BASE + 6) /* cpu perf counter */
 
+/*
+ * Loongson 2 performance counters: two 32-bit counters in one register,
+ * raising LOONGSON2_PERFCNT_IRQ when bit 31 of either gets set, and one
+ * control register with an event field for each.
+ */
+#define LOONGSON2_COUNTER1_EVENT(event)	((event & 0x0f) << 5)
+#define LOONGSON2_COUNTER2_EVENT(event)	((event & 0x0f) << 9)
+
+#define LOONGSON2_PERFCNT_EXL			(1UL	<<  0)
+#define LOONGSON2_PERFCNT_KERNEL		(1UL    <<  1)
+#define LOONGSON2_PERFCNT_SUPERVISOR	(1UL    <<  2)
+#define LOONGSON2_PERFCNT_USER			(1UL    <<  3)
+#define LOONGSON2_PERFCNT_INT_EN		(1UL    <<  4)
+#define LOONGSON2_PERFCNT_OVERFLOW		(1ULL   << 31)
+
+/* Loongson2 performance counter register */
+#define read_c0_perfctrl() __read_64bit_c0_register($24, 0)
+#define write_c0_perfctrl(val) __write_64bit_c0_register($24, 0, val)
+#define read_c0_perfcnt() __read_64bit_c0_register($25, 0)
+#define write_c0_perfcnt(val) __write_64bit_c0_register($25, 0, val)
+
 #define LOONGSON_FLASH_BASE	0x1c000000
 #define LOONGSON_FLASH_SIZE	0x02000000	/* 32M */
 #define LOONGSON_FLASH_TOP	(LOONGSON_FLASH_BASE+LOONGSON_FLASH_SIZE-1)
@@ -98,7 +138,11 @@ extern int mach_i8259_irq(void);
 #define LOONGSON_PCICFG_BASE	0x1fe80000
 #define LOONGSON_PCICFG_SIZE	0x00000800	/* 2K */
 #define LOONGSON_PCICFG_TOP	(LOONGSON_PCICFG_BASE+LOONGSON_PCICFG_SIZE-1)
+#ifdef CONFIG_CPU_LOONGSON3
+#define LOONGSON_PCIIO_BASE	0x18000000
+#else
 #define LOONGSON_PCIIO_BASE	0x1fd00000
+#endif
 #define LOONGSON_PCIIO_SIZE	0x00100000	/* 1M */
 #define LOONGSON_PCIIO_TOP	(LOONGSON_PCIIO_BASE+LOONGSON_PCIIO_SIZE-1)
 
@@ -326,4 +370,71 @@ extern unsigned long _loongson_addrwincfg_base;
 
 #endif	/* ! CONFIG_CPU_SUPPORTS_ADDRWINCFG */
 
+#ifdef CONFIG_CPU_LOONGSON3
+
+/* the node a physical address belongs to */
+#define LOONGSON3_NODE_SHIFT		44
+#define loongson3_pa_to_nid(addr)	((addr) >> LOONGSON3_NODE_SHIFT)
+#define loongson3_nid_to_pa(nid)	((u64)(nid) << LOONGSON3_NODE_SHIFT)
+
+#define LOONGSON3_CORES_PER_NODE	4
+#define loongson3_core_to_nid(core)	((core) / LOONGSON3_CORES_PER_NODE)
+
+/*
+ * per-chip configuration registers of the Loongson 3, every node has its
+ * own block; they are above the 512MB reachable through KSEG1, so they
+ * are accessed uncached through XKPHYS.
+ */
+#define LOONGSON3_REG_BASE		0x3ff00000ul
+#define loongson3_node_regs(nid) \
+	((char *)TO_UNCAC(loongson3_nid_to_pa(nid) | LOONGSON3_REG_BASE))
+#define LOONGSON3_NODE_REG(nid, x) \
+	(*(volatile u32 *)(loongson3_node_regs(nid) + (x)))
+#define LOONGSON3_NODE_REG64(nid, x) \
+	(*(volatile u64 *)(loongson3_node_regs(nid) + (x)))
+
+/* the registers of node 0, which routes the I/O interrupts */
+#define LOONGSON3_REG8(x) \
+	(*(volatile u8 *)(loongson3_node_regs(0) + (x)))
+#define LOONGSON3_REG(x)		LOONGSON3_NODE_REG(0, x)
+#define LOONGSON3_REG64(x)		LOONGSON3_NODE_REG64(0, x)
+
+/* inter-processor interrupts and mailboxes, one block per core of a node */
+#define LOONGSON3_IPI(core, x)		(0x1000 + ((core) << 8) + (x))
+#define LOONGSON3_IPI_STATUS		0x00
+#define LOONGSON3_IPI_EN		0x04
+#define LOONGSON3_IPI_SET		0x08
+#define LOONGSON3_IPI_CLEAR		0x0c
+#define LOONGSON3_IPI_MAILBOX(n)	(0x20 + ((n) << 3))
+
+/* interrupt router of the I/O interrupts */
+#define LOONGSON3_INT_ROUTE(n)		(0x1400 + (n))
+#define LOONGSON3_INT_ISR		0x1420
+#define LOONGSON3_INT_EN		0x1424
+#define LOONGSON3_INT_ENSET		0x1428
+#define LOONGSON3_INT_ENCLR		0x142c
+
+/* route an I/O interrupt to the IP2 line of core 0 */
+#define LOONGSON3_INT_ROUTE_CORE0_IP2	0x11
+
+#define LOONGSON3_UART_INT		0
+#define LOONGSON3_LPC_INT		10
+
+#define LOONGSON3_UART_IRQ		(MIPS_CPU_IRQ_BASE + 2)
+#define LOONGSON3_IPI_IRQ		(MIPS_CPU_IRQ_BASE + 6)
+
+extern unsigned int loongson3_nr_cpus;
+extern unsigned int loongson3_boot_core;
+
+extern void loongson3_ipi_interrupt(void);
+extern struct plat_smp_ops loongson3_smp_ops;
+
+#ifdef CONFIG_NUMA
+extern void __cpuinit loongson3_numa_add_cpu(int cpu, int core);
+#else
+static inline void loongson3_numa_add_cpu(int cpu, int core) {}
+#endif
+
+#endif	/* CONFIG_CPU_LOONGSON3 */
+
 #endif /* __ASM_MACH_LOONGSON_LOONGSON_H */
@@ -24,4 +24,10 @@
 
 #endif
 
+#ifdef CONFIG_LOONGSON_MACH3X
+
+#define LOONGSON_MACHTYPE MACH_LOONGSON_3A
+
+#endif
+
 #endif /* __ASM_MACH_LOONGSON_MACHINE_H */
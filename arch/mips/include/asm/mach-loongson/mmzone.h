@@ -0,0 +1,16 @@
+/*
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ * Every chip of a Loongson 3 machine is a NUMA node.
+ */
+#ifndef __ASM_MACH_LOONGSON_MMZONE_H
+#define __ASM_MACH_LOONGSON_MMZONE_H
+
+extern struct pglist_data __node_data[];
+
+#define NODE_DATA(n)		(&__node_data[(n)])
+
+#endif /* __ASM_MACH_LOONGSON_MMZONE_H */
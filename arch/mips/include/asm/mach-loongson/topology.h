@@ -0,0 +1,50 @@
+/*
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ */
+#ifndef __ASM_MACH_LOONGSON_TOPOLOGY_H
+#define __ASM_MACH_LOONGSON_TOPOLOGY_H
+
+#ifdef CONFIG_NUMA
+
+#include <linux/cpumask.h>
+#include <linux/threads.h>
+
+/* filled in by loongson3_numa_add_cpu() */
+extern unsigned char __cpu_to_node[NR_CPUS];
+extern struct cpumask __node_cpumask[];
+
+#define cpu_to_node(cpu)	(__cpu_to_node[(cpu)])
+#define parent_node(node)	(node)
+#define cpumask_of_node(node)	((node) == -1 ?				\
+				 cpu_all_mask :				\
+				 &__node_cpumask[(node)])
+
+/* there is no PCI on the Loongson 3 machines yet */
+#define pcibus_to_node(bus)	((void)(bus), -1)
+#define cpumask_of_pcibus(bus)	(cpu_online_mask)
+
+/* sched_domains SD_NODE_INIT for Loongson 3 machines */
+#define SD_NODE_INIT (struct sched_domain) {		\
+	.parent			= NULL,			\
+	.child			= NULL,			\
+	.groups			= NULL,			\
+	.min_interval		= 8,			\
+	.max_interval		= 32,			\
+	.busy_factor		= 32,			\
+	.imbalance_pct		= 125,			\
+	.cache_nice_tries	= 1,			\
+	.flags			= SD_LOAD_BALANCE |	\
+				  SD_BALANCE_EXEC,	\
+	.last_balance		= jiffies,		\
+	.balance_interval	= 1,			\
+	.nr_balance_failed	= 0,			\
+}
+
+#endif /* CONFIG_NUMA */
+
+#include <asm-generic/topology.h>
+
+#endif /* __ASM_MACH_LOONGSON_TOPOLOGY_H */
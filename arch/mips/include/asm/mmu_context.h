@@ -104,7 +104,7 @@ extern unsigned long smtc_asid_mask;
 
 #endif
 
-#define cpu_context(cpu, mm)	((mm)->context[cpu])
+#define cpu_context(cpu, mm)	((mm)->context.asid[cpu])
 #define cpu_asid(cpu, mm)	(cpu_context((cpu), (mm)) & ASID_MASK)
 #define asid_cache(cpu)		(cpu_data[cpu].asid_cache)
 
@@ -119,6 +119,18 @@ static inline void enter_lazy_tlb(struct mm_struct *mm, struct task_struct *tsk)
 #define ASID_VERSION_MASK  ((unsigned long)~(ASID_MASK|(ASID_MASK-1)))
 #define ASID_FIRST_VERSION ((unsigned long)(~ASID_VERSION_MASK) + 1)
 
+/*
+ * A context from an older ASID cycle, or none at all, has nothing left in
+ * the TLB: the TLB was flushed when the ASIDs wrapped around, and the mm
+ * gets a new ASID before it runs again.
+ */
+#ifndef CONFIG_MIPS_MT_SMTC
+#define cpu_context_stale(cpu, mm) \
+	((cpu_context((cpu), (mm)) ^ asid_cache(cpu)) & ASID_VERSION_MASK)
+#else
+#define cpu_context_stale(cpu, mm)	(cpu_context((cpu), (mm)) == 0)
+#endif
+
 #ifndef CONFIG_MIPS_MT_SMTC
 /* Normal, classic MIPS get_new_mmu_context */
 static inline void
@@ -172,6 +184,14 @@ static inline void switch_mm(struct mm_struct *prev, struct mm_struct *next,
 	local_irq_save(flags);
 #endif /* CONFIG_MIPS_MT_SMTC */
 
+	/*
+	 * Mark the mm loaded before looking at its context: the TLB flushes
+	 * of other CPUs clear the context of the CPUs that don't have the
+	 * mm loaded instead of interrupting them.
+	 */
+	cpumask_set_cpu(cpu, mm_cpumask(next));
+	smp_mb();
+
 	/* Check if our ASID is of an older version and thus invalid */
 	if ((cpu_context(cpu, next) ^ asid_cache(cpu)) & ASID_VERSION_MASK)
 		get_new_mmu_context(next, cpu);
@@ -208,8 +228,8 @@ static inline void switch_mm(struct mm_struct *prev, struct mm_struct *next,
 	 * Mark current->active_mm as not "active" anymore.
 	 * We don't want to mislead possible IPI tlb flush routines.
 	 */
-	cpumask_clear_cpu(cpu, mm_cpumask(prev));
-	cpumask_set_cpu(cpu, mm_cpumask(next));
+	if (prev != next)
+		cpumask_clear_cpu(cpu, mm_cpumask(prev));
 
 	local_irq_restore(flags);
 }
@@ -242,6 +262,10 @@ activate_mm(struct mm_struct *prev, struct mm_struct *next)
 
 	local_irq_save(flags);
 
+	/* See comments for similar code above */
+	cpumask_set_cpu(cpu, mm_cpumask(next));
+	smp_mb();
+
 	/* Unconditionally get a new ASID.  */
 	get_new_mmu_context(next, cpu);
 
@@ -265,8 +289,8 @@ activate_mm(struct mm_struct *prev, struct mm_struct *next)
 	TLBMISS_HANDLER_SETUP_PGD(next->pgd);
 
 	/* mark mmu ownership change */
-	cpumask_clear_cpu(cpu, mm_cpumask(prev));
-	cpumask_set_cpu(cpu, mm_cpumask(next));
+	if (prev != next)
+		cpumask_clear_cpu(cpu, mm_cpumask(prev));
 
 	local_irq_restore(flags);
 }
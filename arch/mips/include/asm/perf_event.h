@@ -0,0 +1,53 @@
+/*
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ */
+#ifndef __ASM_MIPS_PERF_EVENT_H
+#define __ASM_MIPS_PERF_EVENT_H
+
+struct perf_event;
+struct hw_perf_event;
+
+#define MIPS_MAX_HWEVENTS	4
+
+/*
+ * A CPU's performance counters.  Each counter raises the interrupt when
+ * the overflow bit in it gets set, and may only be able to count some of
+ * the events; event_idx() returns the counter an event code has to go on,
+ * or -1 if any will do.  enable() and disable() only edit the control
+ * word of the CPU, which start() loads into the hardware; stop() halts
+ * all counters.
+ */
+struct mips_pmu {
+	const char	*name;
+	unsigned int	num_events;
+	int		irq;
+	u64		overflow;
+	u64		max_period;
+	int		(*enable)(struct perf_event *, int);
+	void		(*disable)(struct perf_event *, int);
+	void		(*start)(void);
+	void		(*stop)(void);
+	u64		(*read)(int);
+	void		(*write)(int, u64);
+	int		(*event_idx)(u64);
+	int		(*event_map)(int);
+	unsigned int	max_events;
+	unsigned long	raw_event_mask;
+	const int	(*cache_events)[PERF_COUNT_HW_CACHE_MAX]
+				       [PERF_COUNT_HW_CACHE_OP_MAX]
+				       [PERF_COUNT_HW_CACHE_RESULT_MAX];
+};
+
+/* arch/mips/kernel/perf_event.c */
+extern int register_mips_pmu(struct mips_pmu *);
+
+static inline void set_perf_event_pending(void)
+{
+	/* Pending work is picked up from the timer tick */
+}
+
+#define PERF_EVENT_INDEX_OFFSET	0
+
+#endif /* __ASM_MIPS_PERF_EVENT_H */
@@ -20,6 +20,7 @@
 #include <asm/mipsregs.h>
 #include <asm/prefetch.h>
 #include <asm/system.h>
+#include <asm/vdso.h>
 
 /*
  * Return current * instruction pointer ("program counter").
@@ -30,6 +31,7 @@
  * System setup and hardware flags..
  */
 extern void (*cpu_wait)(void);
+extern void cpu_idle_wait(void);
 
 extern unsigned int vced_count, vcei_count;
 
@@ -39,7 +41,7 @@ extern unsigned int vced_count, vcei_count;
  * so don't change it unless you know what you are doing.
  */
 #define TASK_SIZE	0x7fff8000UL
-#define STACK_TOP	TASK_SIZE
+#define STACK_TOP	VDSO_BASE
 
 /*
  * This decides where the kernel will search for a free chunk of vm
@@ -59,7 +61,7 @@ extern unsigned int vced_count, vcei_count;
 #define TASK_SIZE32	0x7fff8000UL
 #define TASK_SIZE	0x10000000000UL
 #define STACK_TOP	\
-      (test_thread_flag(TIF_32BIT_ADDR) ? TASK_SIZE32 : TASK_SIZE)
+      (test_thread_flag(TIF_32BIT_ADDR) ? VDSO_BASE32 : VDSO_BASE)
 
 /*
  * This decides where the kernel will search for a free chunk of vm
@@ -214,6 +216,11 @@ struct thread_struct {
 	unsigned long trap_no;
 	unsigned long irix_trampoline;  /* Wheee... */
 	unsigned long irix_oldctx;
+
+	/* Statistics for /proc/<pid>/status */
+	unsigned long fpu_traps;	/* coprocessor unusable exceptions */
+	unsigned long fpu_preloads;	/* FPU restores when switched in */
+	unsigned long unaligned_fixups;	/* emulated unaligned accesses */
 #ifdef CONFIG_CPU_CAVIUM_OCTEON
     struct octeon_cop2_state cp2 __attribute__ ((__aligned__(128)));
     struct octeon_cvmseg_state cvmseg __attribute__ ((__aligned__(128)));
@@ -309,6 +316,19 @@ extern unsigned long thread_saved_pc(struct task_struct *tsk);
  */
 extern void start_thread(struct pt_regs * regs, unsigned long pc, unsigned long sp);
 
+/*
+ * Print the FPU and unaligned access statistics of task into buffer.
+ * Used in fs/proc/array.c.
+ */
+struct seq_file;
+extern void task_show_stats(struct seq_file *m, struct task_struct *task);
+
+#define GET_UNALIGN_CTL(tsk, adr)	get_unalign_ctl((tsk), (adr))
+#define SET_UNALIGN_CTL(tsk, val)	set_unalign_ctl((tsk), (val))
+
+extern int get_unalign_ctl(struct task_struct *tsk, unsigned long adr);
+extern int set_unalign_ctl(struct task_struct *tsk, unsigned int val);
+
 unsigned long get_wchan(struct task_struct *p);
 
 #define __KSTK_TOS(tsk) ((unsigned long)task_stack_page(tsk) + \
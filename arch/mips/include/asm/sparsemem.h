@@ -7,7 +7,12 @@
  * MAX_PHYSMEM_BITS		2^N: how much memory we can have in that space
  */
 #define SECTION_SIZE_BITS       28
+#ifdef CONFIG_CPU_LOONGSON3
+/* the node number of the Loongson 3 is part of the physical address */
+#define MAX_PHYSMEM_BITS        48
+#else
 #define MAX_PHYSMEM_BITS        35
+#endif
 
 #endif /* CONFIG_SPARSEMEM */
 #endif /* _MIPS_SPARSEMEM_H */
@@ -67,6 +67,19 @@ do {									\
 #define __mips_mt_fpaff_switch_to(prev) do { (void) (prev); } while (0)
 #endif
 
+/*
+ * fpu_counter counts the consecutive timeslices in which the task used
+ * the FPU; past 5 its context is restored by preload_fpu() as soon as it
+ * is switched in, rather than on the next coprocessor unusable exception.
+ */
+extern void preload_fpu(void);
+
+#define __fpu_switch_out(prev)						\
+do {									\
+	if (!test_tsk_thread_flag(prev, TIF_USEDFPU))			\
+		(prev)->fpu_counter = 0;				\
+} while (0)
+
 #define __clear_software_ll_bit()					\
 do {									\
 	if (!__builtin_constant_p(cpu_has_llsc) || !cpu_has_llsc)	\
@@ -76,6 +89,7 @@ do {									\
 #define switch_to(prev, next, last)					\
 do {									\
 	__mips_mt_fpaff_switch_to(prev);				\
+	__fpu_switch_out(prev);						\
 	if (cpu_has_dsp)						\
 		__save_dsp(prev);					\
 	__clear_software_ll_bit();					\
@@ -89,6 +103,8 @@ do {									\
 	if (cpu_has_userlocal)						\
 		write_c0_userlocal(current_thread_info()->tp_value);	\
 	__restore_watch();						\
+	if (current->fpu_counter > 5)					\
+		preload_fpu();						\
 } while (0)
 
 static inline unsigned long __xchg_u32(volatile int * m, unsigned int val)
@@ -232,4 +248,7 @@ extern void per_cpu_trap_init(void);
 
 extern unsigned long arch_align_stack(unsigned long sp);
 
+/* entries in ARCH_DLINFO: */
+#define AT_VECTOR_SIZE_ARCH 1
+
 #endif /* _ASM_SYSTEM_H */
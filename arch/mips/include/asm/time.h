@@ -73,6 +73,7 @@ static inline int mips_clockevent_init(void)
  */
 #ifdef CONFIG_CSRC_R4K_LIB
 extern int init_r4k_clocksource(void);
+extern struct clocksource clocksource_mips;
 #endif
 
 static inline int init_mips_clocksource(void)
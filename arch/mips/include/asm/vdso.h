@@ -0,0 +1,48 @@
+/*
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ */
+#ifndef __ASM_VDSO_H
+#define __ASM_VDSO_H
+
+/*
+ * The vDSO is prelinked to a fixed address right above the stack of
+ * native tasks: the dynamic linker does not relocate it and MIPS code
+ * without PC-relative loads cannot find its data otherwise.  The area
+ * holds the data page followed by the image, and is 64K aligned so that
+ * the data page has the same cache colour for native and 32-bit tasks.
+ */
+#define VDSO_DATA_SIZE		PAGE_SIZE
+#define VDSO_IMAGE_SIZE		0x10000
+#define VDSO_AREA_SIZE		(VDSO_DATA_SIZE + VDSO_IMAGE_SIZE)
+
+#define VDSO_TOP32		0x7fff8000
+#ifdef CONFIG_64BIT
+#define VDSO_TOP		0x10000000000
+#else
+#define VDSO_TOP		VDSO_TOP32
+#endif
+
+#define __VDSO_BASE(top)	(((top) & ~0xffff) - VDSO_AREA_SIZE)
+#define VDSO_BASE		__VDSO_BASE(VDSO_TOP)
+#define VDSO_BASE32		__VDSO_BASE(VDSO_TOP32)
+#define VDSO_IMAGE_BASE		(VDSO_BASE + VDSO_DATA_SIZE)
+
+#ifndef __ASSEMBLY__
+
+/*
+ * Address of the vDSO symbol VDSO_<name>, defined relative to the start
+ * of the image by vdso.lds.S, in a task that has the image at base.
+ */
+#define VDSO_SYMBOL(base, name)						\
+({									\
+	extern const char VDSO_##name[];				\
+	(unsigned long)(base) + (unsigned long)VDSO_##name;		\
+})
+
+extern unsigned int vdso_enabled;
+
+#endif /* !__ASSEMBLY__ */
+
+#endif /* __ASM_VDSO_H */
@@ -0,0 +1,36 @@
+/*
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ */
+#ifndef __ASM_VDSO_DATAPAGE_H
+#define __ASM_VDSO_DATAPAGE_H
+
+#include <linux/types.h>
+#include <linux/seqlock.h>
+
+/* How the vDSO reads the clocksource */
+#define VDSO_CLOCK_NONE		0	/* not at all, use the syscall */
+#define VDSO_CLOCK_R4K		1	/* rdhwr of the count register */
+
+/*
+ * The data page shared with user space, updated by update_vsyscall().
+ * xtime is also what the coarse clocks return.  It has the same layout
+ * for all ABIs a kernel may run.
+ */
+struct vdso_data {
+	seqcount_t	seq;
+	u32		clock_mode;
+	u64		cycle_last;
+	u64		mask;
+	u32		mult;
+	u32		shift;
+	u64		xtime_sec;
+	u64		xtime_nsec;
+	s64		wtm_sec;
+	s64		wtm_nsec;
+	s32		tz_minuteswest;
+	s32		tz_dsttime;
+};
+
+#endif /* __ASM_VDSO_DATAPAGE_H */
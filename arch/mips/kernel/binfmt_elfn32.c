@@ -119,4 +119,7 @@ MODULE_AUTHOR("Ralf Baechle (ralf@linux-mips.org)");
 #undef TASK_SIZE
 #define TASK_SIZE TASK_SIZE32
 
+/* The vDSO is a native image; only its signal trampolines are used */
+#undef ARCH_DLINFO
+
 #include "../../../fs/binfmt_elf.c"
@@ -157,6 +157,10 @@ void loongson2_cpu_wait(void)
 	u32 cpu_freq;
 	unsigned long flags;
 
+	/* the time spent asleep would be lost, just keep polling */
+	if (!loongson2f_can_stop_clock())
+		return;
+
 	spin_lock_irqsave(&loongson2_wait_lock, flags);
 	cpu_freq = LOONGSON_CHIPCFG0;
 	LOONGSON_CHIPCFG0 &= ~0x7;	/* Put CPU into wait mode */
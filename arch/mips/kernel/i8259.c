@@ -53,11 +53,50 @@ static struct irq_chip i8259A_chip = {
 /*
  * This contains the irq mask for both 8259A irq controllers,
  */
-static unsigned int cached_irq_mask = 0xffff;
+unsigned int cached_irq_mask = 0xffff;
 
 #define cached_master_mask	(cached_irq_mask)
 #define cached_slave_mask	(cached_irq_mask >> 8)
 
+/*
+ * With lazy masking, masking an irq only sets its bit in cached_irq_mask
+ * and the IMRs are left alone until the irq actually comes in; the
+ * dispatcher then calls i8259A_mask_pending().  hw_irq_mask is what the
+ * IMRs really hold.
+ */
+int i8259A_lazy_mask __read_mostly;
+static unsigned int hw_irq_mask = 0xffff;
+
+static inline void i8259A_write_imr(unsigned int irq)
+{
+	unsigned int half = (irq & 8) ? 0xff00 : 0x00ff;
+
+	if (irq & 8)
+		outb(cached_slave_mask, PIC_SLAVE_IMR);
+	else
+		outb(cached_master_mask, PIC_MASTER_IMR);
+	hw_irq_mask = (hw_irq_mask & ~half) | (cached_irq_mask & half);
+}
+
+/*
+ * Mask the irqs in @pending that are masked in software but not yet in
+ * the IMRs.  Returns nonzero if there were any.  Called with i8259A_lock
+ * held.
+ */
+int i8259A_mask_pending(unsigned int pending)
+{
+	pending &= cached_irq_mask & ~hw_irq_mask;
+	if (!pending)
+		return 0;
+
+	if (pending & 0x00ff)
+		i8259A_write_imr(0);
+	if (pending & 0xff00)
+		i8259A_write_imr(8);
+
+	return 1;
+}
+
 static void disable_8259A_irq(unsigned int irq)
 {
 	unsigned int mask;
@@ -67,10 +106,8 @@ static void disable_8259A_irq(unsigned int irq)
 	mask = 1 << irq;
 	spin_lock_irqsave(&i8259A_lock, flags);
 	cached_irq_mask |= mask;
-	if (irq & 8)
-		outb(cached_slave_mask, PIC_SLAVE_IMR);
-	else
-		outb(cached_master_mask, PIC_MASTER_IMR);
+	if (!i8259A_lazy_mask)
+		i8259A_write_imr(irq);
 	spin_unlock_irqrestore(&i8259A_lock, flags);
 }
 
@@ -80,13 +117,11 @@ static void enable_8259A_irq(unsigned int irq)
 	unsigned long flags;
 
 	irq -= I8259A_IRQ_BASE;
-	mask = ~(1 << irq);
+	mask = 1 << irq;
 	spin_lock_irqsave(&i8259A_lock, flags);
-	cached_irq_mask &= mask;
-	if (irq & 8)
-		outb(cached_slave_mask, PIC_SLAVE_IMR);
-	else
-		outb(cached_master_mask, PIC_MASTER_IMR);
+	cached_irq_mask &= ~mask;
+	if (hw_irq_mask & mask)
+		i8259A_write_imr(irq);
 	spin_unlock_irqrestore(&i8259A_lock, flags);
 }
 
@@ -173,13 +208,17 @@ static void mask_and_ack_8259A(unsigned int irq)
 
 handle_real_irq:
 	if (irq & 8) {
-		inb(PIC_SLAVE_IMR);	/* DUMMY - (do we need this?) */
-		outb(cached_slave_mask, PIC_SLAVE_IMR);
+		if (!i8259A_lazy_mask) {
+			inb(PIC_SLAVE_IMR);	/* DUMMY - (do we need this?) */
+			i8259A_write_imr(irq);
+		}
 		outb(0x60+(irq&7), PIC_SLAVE_CMD);/* 'Specific EOI' to slave */
 		outb(0x60+PIC_CASCADE_IR, PIC_MASTER_CMD); /* 'Specific EOI' to master-IRQ2 */
 	} else {
-		inb(PIC_MASTER_IMR);	/* DUMMY - (do we need this?) */
-		outb(cached_master_mask, PIC_MASTER_IMR);
+		if (!i8259A_lazy_mask) {
+			inb(PIC_MASTER_IMR);	/* DUMMY - (do we need this?) */
+			i8259A_write_imr(irq);
+		}
 		outb(0x60+irq, PIC_MASTER_CMD);	/* 'Specific EOI to master */
 	}
 	smtc_im_ack_irq(irq);
@@ -297,6 +336,7 @@ static void init_8259A(int auto_eoi)
 
 	outb(cached_master_mask, PIC_MASTER_IMR); /* restore master IRQ mask */
 	outb(cached_slave_mask, PIC_SLAVE_IMR);	  /* restore slave IRQ mask */
+	hw_irq_mask = cached_irq_mask;
 
 	spin_unlock_irqrestore(&i8259A_lock, flags);
 }
@@ -195,6 +195,10 @@ static int kgdb_mips_notify(struct notifier_block *self, unsigned long cmd,
 	if (user_mode(regs))
 		return NOTIFY_DONE;
 
+	/* Page faults are for kprobes, the fixups take care of the rest. */
+	if (cmd == DIE_PAGE_FAULT)
+		return NOTIFY_DONE;
+
 	if (atomic_read(&kgdb_active) != -1)
 		kgdb_nmicallback(smp_processor_id(), regs);
 
@@ -0,0 +1,207 @@
+/*
+ * Performance event callchain support - MIPS architecture code
+ *
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ */
+#include <linux/kernel.h>
+#include <linux/sched.h>
+#include <linux/perf_event.h>
+#include <linux/percpu.h>
+#include <linux/uaccess.h>
+
+#include <asm/inst.h>
+#include <asm/ptrace.h>
+#include <asm/stacktrace.h>
+
+/* How far up the user stack to look for return addresses */
+#define USER_STACK_SCAN		4096
+
+static inline void callchain_store(struct perf_callchain_entry *entry, u64 ip)
+{
+	if (entry->nr < PERF_MAX_STACK_DEPTH)
+		entry->ip[entry->nr++] = ip;
+}
+
+static inline int callchain_full(struct perf_callchain_entry *entry)
+{
+	return entry->nr >= PERF_MAX_STACK_DEPTH;
+}
+
+static void perf_callchain_raw(unsigned long sp,
+			       struct perf_callchain_entry *entry)
+{
+	unsigned long stack_page = (unsigned long)task_stack_page(current);
+	unsigned long *p = (unsigned long *)sp;
+
+	if (!stack_page || sp < stack_page ||
+	    sp > stack_page + THREAD_SIZE - 32)
+		return;
+
+	while (!kstack_end(p) && !callchain_full(entry)) {
+		unsigned long addr = *p++;
+
+		if (__kernel_text_address(addr))
+			callchain_store(entry, addr);
+	}
+}
+
+/*
+ * Follows the frames with unwind_stack() like save_context_stack() in
+ * stacktrace.c, and falls back to picking text addresses off the stack
+ * where that does not work.
+ */
+static void
+perf_callchain_kernel(struct pt_regs *regs, struct perf_callchain_entry *entry)
+{
+	unsigned long sp = regs->regs[29];
+	unsigned long ra = regs->regs[31];
+	unsigned long pc = regs->cp0_epc;
+
+	callchain_store(entry, PERF_CONTEXT_KERNEL);
+
+	if (raw_show_trace || !__kernel_text_address(pc)) {
+		callchain_store(entry, pc);
+		perf_callchain_raw(sp, entry);
+		return;
+	}
+
+	do {
+		callchain_store(entry, pc);
+		pc = unwind_stack(current, &sp, pc, &ra);
+	} while (pc && !callchain_full(entry));
+}
+
+/*
+ * A return address follows the delay slot of a jal, jalr or bal.
+ */
+static int user_call_site(unsigned long ret)
+{
+	union mips_instruction insn;
+
+	if ((ret & 3) || ret < 8 ||
+	    !access_ok(VERIFY_READ, (void __user *)(ret - 8), 4))
+		return 0;
+	if (__copy_from_user_inatomic(&insn.word,
+				      (void __user *)(ret - 8), 4))
+		return 0;
+
+	switch (insn.i_format.opcode) {
+	case jal_op:
+	case jalx_op:
+		return 1;
+	case spec_op:
+		return insn.r_format.func == jalr_op;
+	case bcond_op:
+		switch (insn.i_format.rt) {
+		case bltzal_op:
+		case bgezal_op:
+		case bltzall_op:
+		case bgezall_op:
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int user_stack_word(unsigned long sp, unsigned long *val)
+{
+#ifdef CONFIG_64BIT
+	if (test_thread_flag(TIF_32BIT_REGS)) {
+		u32 word;
+
+		if (__copy_from_user_inatomic(&word, (void __user *)sp, 4))
+			return -EFAULT;
+		*val = word;
+		return 4;
+	}
+#endif
+	if (__copy_from_user_inatomic(val, (void __user *)sp, sizeof(*val)))
+		return -EFAULT;
+	return sizeof(*val);
+}
+
+/*
+ * MIPS code is normally built without frame pointers, and even with
+ * them the saved registers are at the top of a frame of unknown size.
+ * Scan the stack instead, and take every word that points right after
+ * a call instruction to be a return address.  That can pick up stale
+ * addresses from uninitialised locals, but costs nothing in user space.
+ */
+static void
+perf_callchain_user(struct pt_regs *regs, struct perf_callchain_entry *entry)
+{
+	unsigned long sp = regs->regs[29];
+	unsigned long top = sp + USER_STACK_SCAN;
+	unsigned long ra = regs->regs[31];
+
+	callchain_store(entry, PERF_CONTEXT_USER);
+	callchain_store(entry, regs->cp0_epc);
+
+	pagefault_disable();
+
+	/* A leaf function has not saved its return address yet */
+	if (user_call_site(ra))
+		callchain_store(entry, ra);
+
+	while (sp < top && !callchain_full(entry)) {
+		unsigned long addr;
+		int size;
+
+		if (!access_ok(VERIFY_READ, (void __user *)sp, sizeof(addr)))
+			break;
+		size = user_stack_word(sp, &addr);
+		if (size < 0)
+			break;
+		sp += size;
+
+		if (addr != ra && user_call_site(addr))
+			callchain_store(entry, addr);
+	}
+
+	pagefault_enable();
+}
+
+static void
+perf_do_callchain(struct pt_regs *regs, struct perf_callchain_entry *entry)
+{
+	int is_user;
+
+	if (!regs)
+		return;
+
+	is_user = user_mode(regs);
+
+	if (!current || current->pid == 0)
+		return;
+
+	if (is_user && current->state != TASK_RUNNING)
+		return;
+
+	if (!is_user) {
+		perf_callchain_kernel(regs, entry);
+		if (!current->mm)
+			return;
+		regs = task_pt_regs(current);
+	}
+
+	perf_callchain_user(regs, entry);
+}
+
+/*
+ * No need for separate IRQ and NMI entries.
+ */
+static DEFINE_PER_CPU(struct perf_callchain_entry, callchain);
+
+struct perf_callchain_entry *perf_callchain(struct pt_regs *regs)
+{
+	struct perf_callchain_entry *entry = &__get_cpu_var(callchain);
+
+	entry->nr = 0;
+
+	perf_do_callchain(regs, entry);
+
+	return entry;
+}
@@ -0,0 +1,424 @@
+/*
+ * Performance event support for MIPS hardware counters.
+ *
+ * Based on the x86 and SuperH implementations.
+ *
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ */
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/interrupt.h>
+#include <linux/mutex.h>
+#include <linux/perf_event.h>
+
+#include <asm/irq_regs.h>
+
+struct cpu_hw_events {
+	struct perf_event	*events[MIPS_MAX_HWEVENTS];
+	unsigned long		used_mask[BITS_TO_LONGS(MIPS_MAX_HWEVENTS)];
+	unsigned long		active_mask[BITS_TO_LONGS(MIPS_MAX_HWEVENTS)];
+	int			enabled;
+};
+
+static DEFINE_PER_CPU(struct cpu_hw_events, cpu_hw_events);
+
+static struct mips_pmu *mips_pmu __read_mostly;
+
+/* Number of perf_events counting hardware events */
+static atomic_t num_events;
+/* Used to avoid races in calling reserve/release_pmc_hardware */
+static DEFINE_MUTEX(pmc_reserve_mutex);
+
+static irqreturn_t mips_pmu_handle_irq(int irq, void *dev_id);
+
+static int reserve_pmc_hardware(void)
+{
+	return request_irq(mips_pmu->irq, mips_pmu_handle_irq, IRQF_SHARED,
+			   "perf_event", mips_pmu);
+}
+
+static void release_pmc_hardware(void)
+{
+	free_irq(mips_pmu->irq, mips_pmu);
+}
+
+static inline int mips_pmu_initialized(void)
+{
+	return !!mips_pmu;
+}
+
+/*
+ * Release the PMU if this is the last perf_event.
+ */
+static void hw_perf_event_destroy(struct perf_event *event)
+{
+	if (!atomic_add_unless(&num_events, -1, 1)) {
+		mutex_lock(&pmc_reserve_mutex);
+		if (atomic_dec_return(&num_events) == 0)
+			release_pmc_hardware();
+		mutex_unlock(&pmc_reserve_mutex);
+	}
+}
+
+static int hw_perf_cache_event(int config, int *evp)
+{
+	unsigned long type, op, result;
+	int ev;
+
+	if (!mips_pmu->cache_events)
+		return -EINVAL;
+
+	/* unpack config */
+	type = config & 0xff;
+	op = (config >> 8) & 0xff;
+	result = (config >> 16) & 0xff;
+
+	if (type >= PERF_COUNT_HW_CACHE_MAX ||
+	    op >= PERF_COUNT_HW_CACHE_OP_MAX ||
+	    result >= PERF_COUNT_HW_CACHE_RESULT_MAX)
+		return -EINVAL;
+
+	ev = (*mips_pmu->cache_events)[type][op][result];
+	if (ev == 0)
+		return -EOPNOTSUPP;
+	if (ev == -1)
+		return -EINVAL;
+	*evp = ev;
+	return 0;
+}
+
+static int __hw_perf_event_init(struct perf_event *event)
+{
+	struct perf_event_attr *attr = &event->attr;
+	struct hw_perf_event *hwc = &event->hw;
+	int config = -1;
+	int err;
+
+	if (!mips_pmu_initialized())
+		return -ENODEV;
+
+	/*
+	 * See if we need to reserve the counter.
+	 *
+	 * If no events are currently in use, then we have to take a
+	 * mutex to ensure that we don't race with another task doing
+	 * reserve_pmc_hardware or release_pmc_hardware.
+	 */
+	err = 0;
+	if (!atomic_inc_not_zero(&num_events)) {
+		mutex_lock(&pmc_reserve_mutex);
+		if (atomic_read(&num_events) == 0 &&
+		    reserve_pmc_hardware())
+			err = -EBUSY;
+		else
+			atomic_inc(&num_events);
+		mutex_unlock(&pmc_reserve_mutex);
+	}
+
+	if (err)
+		return err;
+
+	event->destroy = hw_perf_event_destroy;
+
+	switch (attr->type) {
+	case PERF_TYPE_RAW:
+		config = attr->config & mips_pmu->raw_event_mask;
+		break;
+	case PERF_TYPE_HW_CACHE:
+		err = hw_perf_cache_event(attr->config, &config);
+		if (err)
+			return err;
+		break;
+	case PERF_TYPE_HARDWARE:
+		if (attr->config >= mips_pmu->max_events)
+			return -EINVAL;
+
+		config = mips_pmu->event_map(attr->config);
+		break;
+	}
+
+	if (config == -1)
+		return -EINVAL;
+
+	hwc->config = config;
+	hwc->idx = mips_pmu->event_idx(config);
+
+	/*
+	 * Counting events still need the overflow interrupt to keep track
+	 * of the counter wrapping around.
+	 */
+	if (!hwc->sample_period) {
+		hwc->sample_period = mips_pmu->max_period;
+		hwc->last_period = hwc->sample_period;
+		atomic64_set(&hwc->period_left, hwc->sample_period);
+	}
+
+	return 0;
+}
+
+/*
+ * Propagate the counter value into the generic event, and return the
+ * new raw count.
+ */
+static u64 mips_perf_event_update(struct perf_event *event,
+				  struct hw_perf_event *hwc, int idx)
+{
+	u64 prev_raw_count, new_raw_count;
+	u64 mask = (mips_pmu->overflow << 1) - 1;
+	s64 delta;
+
+again:
+	prev_raw_count = atomic64_read(&hwc->prev_count);
+	new_raw_count = mips_pmu->read(idx);
+
+	if (atomic64_cmpxchg(&hwc->prev_count, prev_raw_count,
+			     new_raw_count) != prev_raw_count)
+		goto again;
+
+	delta = (new_raw_count - prev_raw_count) & mask;
+
+	atomic64_add(delta, &event->count);
+	atomic64_sub(delta, &hwc->period_left);
+
+	return new_raw_count;
+}
+
+/*
+ * Set the counter up to raise the overflow interrupt once the rest of
+ * the period has gone by.  Returns 1 if a new period was started.
+ */
+static int mips_perf_event_set_period(struct perf_event *event,
+				      struct hw_perf_event *hwc, int idx)
+{
+	s64 left = atomic64_read(&hwc->period_left);
+	s64 period = hwc->sample_period;
+	int ret = 0;
+
+	if (unlikely(left <= -period)) {
+		left = period;
+		atomic64_set(&hwc->period_left, left);
+		hwc->last_period = period;
+		ret = 1;
+	}
+
+	if (unlikely(left <= 0)) {
+		left += period;
+		atomic64_set(&hwc->period_left, left);
+		hwc->last_period = period;
+		ret = 1;
+	}
+
+	if (left > mips_pmu->max_period)
+		left = mips_pmu->max_period;
+
+	atomic64_set(&hwc->prev_count, mips_pmu->overflow - left);
+	mips_pmu->write(idx, mips_pmu->overflow - left);
+
+	perf_event_update_userpage(event);
+
+	return ret;
+}
+
+static int mips_pmu_enable(struct perf_event *event)
+{
+	struct cpu_hw_events *cpuc = &__get_cpu_var(cpu_hw_events);
+	struct hw_perf_event *hwc = &event->hw;
+	int idx = hwc->idx;
+
+	if (idx < 0) {
+		idx = find_first_zero_bit(cpuc->used_mask,
+					  mips_pmu->num_events);
+		if (idx == mips_pmu->num_events)
+			return -EAGAIN;
+	}
+	if (test_and_set_bit(idx, cpuc->used_mask))
+		return -EAGAIN;
+
+	mips_pmu->stop();
+
+	if (mips_pmu->enable(event, idx)) {
+		clear_bit(idx, cpuc->used_mask);
+		if (cpuc->enabled)
+			mips_pmu->start();
+		return -EAGAIN;
+	}
+
+	cpuc->events[idx] = event;
+	set_bit(idx, cpuc->active_mask);
+	mips_perf_event_set_period(event, hwc, idx);
+
+	if (cpuc->enabled)
+		mips_pmu->start();
+
+	return 0;
+}
+
+static void mips_pmu_disable(struct perf_event *event)
+{
+	struct cpu_hw_events *cpuc = &__get_cpu_var(cpu_hw_events);
+	struct hw_perf_event *hwc = &event->hw;
+	int idx;
+
+	for (idx = 0; idx < mips_pmu->num_events; idx++)
+		if (cpuc->events[idx] == event)
+			break;
+	if (WARN_ON(idx == mips_pmu->num_events))
+		return;
+
+	mips_pmu->stop();
+	clear_bit(idx, cpuc->active_mask);
+	mips_pmu->disable(event, idx);
+	if (cpuc->enabled)
+		mips_pmu->start();
+
+	mips_perf_event_update(event, hwc, idx);
+
+	cpuc->events[idx] = NULL;
+	clear_bit(idx, cpuc->used_mask);
+
+	perf_event_update_userpage(event);
+}
+
+static void mips_pmu_read(struct perf_event *event)
+{
+	struct cpu_hw_events *cpuc = &__get_cpu_var(cpu_hw_events);
+	int idx;
+
+	for (idx = 0; idx < mips_pmu->num_events; idx++)
+		if (cpuc->events[idx] == event) {
+			mips_perf_event_update(event, &event->hw, idx);
+			break;
+		}
+}
+
+static void mips_pmu_unthrottle(struct perf_event *event)
+{
+	struct cpu_hw_events *cpuc = &__get_cpu_var(cpu_hw_events);
+	int idx;
+
+	for (idx = 0; idx < mips_pmu->num_events; idx++)
+		if (cpuc->events[idx] == event)
+			break;
+	if (idx == mips_pmu->num_events)
+		return;
+
+	mips_pmu->stop();
+	mips_pmu->enable(event, idx);
+	if (cpuc->enabled)
+		mips_pmu->start();
+}
+
+static irqreturn_t mips_pmu_handle_irq(int irq, void *dev_id)
+{
+	struct cpu_hw_events *cpuc = &__get_cpu_var(cpu_hw_events);
+	struct pt_regs *regs = get_irq_regs();
+	struct perf_sample_data data;
+	irqreturn_t ret = IRQ_NONE;
+	unsigned long flags;
+	int idx;
+
+	data.addr = 0;
+	data.raw = NULL;
+
+	local_irq_save(flags);
+	mips_pmu->stop();
+
+	for (idx = 0; idx < mips_pmu->num_events; idx++) {
+		struct perf_event *event = cpuc->events[idx];
+		struct hw_perf_event *hwc;
+
+		if (!(mips_pmu->read(idx) & mips_pmu->overflow))
+			continue;
+		ret = IRQ_HANDLED;
+
+		/*
+		 * Counters without an event may still count along with
+		 * the others, keep them from interrupting again soon.
+		 */
+		if (!test_bit(idx, cpuc->active_mask)) {
+			mips_pmu->write(idx, 0);
+			continue;
+		}
+
+		hwc = &event->hw;
+		mips_perf_event_update(event, hwc, idx);
+		data.period = hwc->last_period;
+		if (!mips_perf_event_set_period(event, hwc, idx))
+			continue;
+
+		if (perf_event_overflow(event, 0, &data, regs))
+			mips_pmu->disable(event, idx);
+	}
+
+	if (cpuc->enabled)
+		mips_pmu->start();
+	local_irq_restore(flags);
+
+	return ret;
+}
+
+static const struct pmu pmu = {
+	.enable		= mips_pmu_enable,
+	.disable	= mips_pmu_disable,
+	.read		= mips_pmu_read,
+	.unthrottle	= mips_pmu_unthrottle,
+};
+
+const struct pmu *hw_perf_event_init(struct perf_event *event)
+{
+	int err = __hw_perf_event_init(event);
+	if (unlikely(err)) {
+		if (event->destroy)
+			event->destroy(event);
+		return ERR_PTR(err);
+	}
+
+	return &pmu;
+}
+
+void hw_perf_event_setup(int cpu)
+{
+	struct cpu_hw_events *cpuhw = &per_cpu(cpu_hw_events, cpu);
+
+	memset(cpuhw, 0, sizeof(struct cpu_hw_events));
+	cpuhw->enabled = 1;
+}
+
+void hw_perf_enable(void)
+{
+	struct cpu_hw_events *cpuc = &__get_cpu_var(cpu_hw_events);
+
+	if (!mips_pmu_initialized())
+		return;
+
+	cpuc->enabled = 1;
+	barrier();
+	mips_pmu->start();
+}
+
+void hw_perf_disable(void)
+{
+	struct cpu_hw_events *cpuc = &__get_cpu_var(cpu_hw_events);
+
+	if (!mips_pmu_initialized())
+		return;
+
+	cpuc->enabled = 0;
+	barrier();
+	mips_pmu->stop();
+}
+
+int register_mips_pmu(struct mips_pmu *pmu)
+{
+	if (mips_pmu)
+		return -EBUSY;
+	mips_pmu = pmu;
+
+	pr_info("Performance Events: %s support registered\n", pmu->name);
+
+	WARN_ON(pmu->num_events > MIPS_MAX_HWEVENTS);
+
+	return 0;
+}
@@ -0,0 +1,281 @@
+/*
+ * Performance events support for the Loongson 2 counters.
+ *
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ *
+ * Both counters share the mode bits and the interrupt enable, and neither
+ * can be stopped on its own.  Events are therefore only put together when
+ * they count in the same modes, and the counter of an unused event field
+ * keeps counting cycles or instructions.
+ *
+ * Raw event codes are 0x00 - 0x0f for events of the first counter and
+ * 0x10 - 0x1f for those of the second one, as in the oprofile event list.
+ */
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/perf_event.h>
+
+#include <asm/cpu.h>
+#include <asm/cpu-features.h>
+#include <asm/irq.h>
+#include <asm/mipsregs.h>
+
+#include <loongson.h>
+
+#define LOONGSON2_EVENT_COUNTER(ev)	(((ev) >> 4) & 1)
+#define LOONGSON2_EVENT_MASK		0x1f
+
+#define LOONGSON2_PERFCNT_MODE		(LOONGSON2_PERFCNT_EXL |	\
+					 LOONGSON2_PERFCNT_KERNEL |	\
+					 LOONGSON2_PERFCNT_USER)
+
+struct loongson2_cpu_hw {
+	unsigned int	ctrl;
+	unsigned int	used;
+};
+
+static DEFINE_PER_CPU(struct loongson2_cpu_hw, loongson2_cpu_hw);
+
+static const int loongson2_general_events[] = {
+	[PERF_COUNT_HW_CPU_CYCLES]		= 0x00,
+	[PERF_COUNT_HW_INSTRUCTIONS]		= 0x10,
+	[PERF_COUNT_HW_CACHE_REFERENCES]	= -1,
+	[PERF_COUNT_HW_CACHE_MISSES]		= 0x14,	/* D-cache */
+	[PERF_COUNT_HW_BRANCH_INSTRUCTIONS]	= 0x01,
+	[PERF_COUNT_HW_BRANCH_MISSES]		= 0x11,
+	[PERF_COUNT_HW_BUS_CYCLES]		= -1,
+};
+
+static int loongson2_event_map(int event)
+{
+	return loongson2_general_events[event];
+}
+
+#define C(x)	PERF_COUNT_HW_CACHE_##x
+
+static const int loongson2_cache_events
+			[PERF_COUNT_HW_CACHE_MAX]
+			[PERF_COUNT_HW_CACHE_OP_MAX]
+			[PERF_COUNT_HW_CACHE_RESULT_MAX] = {
+	[ C(L1D) ] = {
+		[ C(OP_READ) ] = {
+			[ C(RESULT_ACCESS) ] = -1,
+			[ C(RESULT_MISS)   ] = 0x14,
+		},
+		[ C(OP_WRITE) ] = {
+			[ C(RESULT_ACCESS) ] = -1,
+			[ C(RESULT_MISS)   ] = 0x14,
+		},
+		[ C(OP_PREFETCH) ] = {
+			[ C(RESULT_ACCESS) ] = -1,
+			[ C(RESULT_MISS)   ] = -1,
+		},
+	},
+
+	[ C(L1I) ] = {
+		[ C(OP_READ) ] = {
+			[ C(RESULT_ACCESS) ] = -1,
+			[ C(RESULT_MISS)   ] = 0x04,
+		},
+		[ C(OP_WRITE) ] = {
+			[ C(RESULT_ACCESS) ] = -1,
+			[ C(RESULT_MISS)   ] = -1,
+		},
+		[ C(OP_PREFETCH) ] = {
+			[ C(RESULT_ACCESS) ] = -1,
+			[ C(RESULT_MISS)   ] = -1,
+		},
+	},
+
+	[ C(LL) ] = {
+		[ C(OP_READ) ] = {
+			[ C(RESULT_ACCESS) ] = -1,
+			[ C(RESULT_MISS)   ] = -1,
+		},
+		[ C(OP_WRITE) ] = {
+			[ C(RESULT_ACCESS) ] = -1,
+			[ C(RESULT_MISS)   ] = -1,
+		},
+		[ C(OP_PREFETCH) ] = {
+			[ C(RESULT_ACCESS) ] = -1,
+			[ C(RESULT_MISS)   ] = -1,
+		},
+	},
+
+	[ C(DTLB) ] = {
+		[ C(OP_READ) ] = {
+			[ C(RESULT_ACCESS) ] = -1,
+			[ C(RESULT_MISS)   ] = -1,
+		},
+		[ C(OP_WRITE) ] = {
+			[ C(RESULT_ACCESS) ] = -1,
+			[ C(RESULT_MISS)   ] = -1,
+		},
+		[ C(OP_PREFETCH) ] = {
+			[ C(RESULT_ACCESS) ] = -1,
+			[ C(RESULT_MISS)   ] = -1,
+		},
+	},
+
+	[ C(ITLB) ] = {
+		[ C(OP_READ) ] = {
+			[ C(RESULT_ACCESS) ] = -1,
+			[ C(RESULT_MISS)   ] = 0x1c,
+		},
+		[ C(OP_WRITE) ] = {
+			[ C(RESULT_ACCESS) ] = -1,
+			[ C(RESULT_MISS)   ] = -1,
+		},
+		[ C(OP_PREFETCH) ] = {
+			[ C(RESULT_ACCESS) ] = -1,
+			[ C(RESULT_MISS)   ] = -1,
+		},
+	},
+
+	[ C(BPU) ] = {
+		[ C(OP_READ) ] = {
+			[ C(RESULT_ACCESS) ] = 0x01,
+			[ C(RESULT_MISS)   ] = 0x11,
+		},
+		[ C(OP_WRITE) ] = {
+			[ C(RESULT_ACCESS) ] = -1,
+			[ C(RESULT_MISS)   ] = -1,
+		},
+		[ C(OP_PREFETCH) ] = {
+			[ C(RESULT_ACCESS) ] = -1,
+			[ C(RESULT_MISS)   ] = -1,
+		},
+	},
+};
+
+static int loongson2_event_idx(u64 config)
+{
+	return LOONGSON2_EVENT_COUNTER(config);
+}
+
+static unsigned int loongson2_event_ctrl(u64 config, int idx)
+{
+	return idx ? LOONGSON2_COUNTER2_EVENT(config) :
+		     LOONGSON2_COUNTER1_EVENT(config);
+}
+
+static unsigned int loongson2_event_mode(struct perf_event *event)
+{
+	unsigned int mode = 0;
+
+	if (!event->attr.exclude_kernel)
+		mode |= LOONGSON2_PERFCNT_KERNEL | LOONGSON2_PERFCNT_EXL;
+	if (!event->attr.exclude_user)
+		mode |= LOONGSON2_PERFCNT_USER;
+
+	return mode;
+}
+
+static int loongson2_pmu_enable(struct perf_event *event, int idx)
+{
+	struct loongson2_cpu_hw *cpuhw = &__get_cpu_var(loongson2_cpu_hw);
+	unsigned int mode = loongson2_event_mode(event);
+
+	if ((cpuhw->used & ~(1 << idx)) &&
+	    (cpuhw->ctrl & LOONGSON2_PERFCNT_MODE) != mode)
+		return -EAGAIN;
+
+	cpuhw->ctrl &= ~(LOONGSON2_PERFCNT_MODE |
+			 loongson2_event_ctrl(~0ULL, idx));
+	cpuhw->ctrl |= mode | loongson2_event_ctrl(event->hw.config, idx);
+	cpuhw->used |= 1 << idx;
+
+	return 0;
+}
+
+static void loongson2_pmu_disable(struct perf_event *event, int idx)
+{
+	struct loongson2_cpu_hw *cpuhw = &__get_cpu_var(loongson2_cpu_hw);
+
+	cpuhw->ctrl &= ~loongson2_event_ctrl(~0ULL, idx);
+	cpuhw->used &= ~(1 << idx);
+}
+
+static void loongson2_pmu_start(void)
+{
+	struct loongson2_cpu_hw *cpuhw = &__get_cpu_var(loongson2_cpu_hw);
+
+	if (cpuhw->used)
+		write_c0_perfctrl(cpuhw->ctrl | LOONGSON2_PERFCNT_INT_EN);
+}
+
+static void loongson2_pmu_stop(void)
+{
+	write_c0_perfctrl(0);
+}
+
+static u64 loongson2_pmu_read(int idx)
+{
+	u64 count = read_c0_perfcnt();
+
+	return idx ? count >> 32 : count & 0xffffffff;
+}
+
+static void loongson2_pmu_write(int idx, u64 val)
+{
+	u64 count = read_c0_perfcnt();
+
+	if (idx)
+		count = (count & 0xffffffff) | (val << 32);
+	else
+		count = (count & ~0xffffffffULL) | (val & 0xffffffff);
+	write_c0_perfcnt(count);
+}
+
+static struct mips_pmu loongson2_pmu = {
+	.name		= "Loongson 2",
+	.num_events	= 2,
+	.irq		= LOONGSON2_PERFCNT_IRQ,
+	.overflow	= LOONGSON2_PERFCNT_OVERFLOW,
+	.max_period	= LOONGSON2_PERFCNT_OVERFLOW - 1,
+	.enable		= loongson2_pmu_enable,
+	.disable	= loongson2_pmu_disable,
+	.start		= loongson2_pmu_start,
+	.stop		= loongson2_pmu_stop,
+	.read		= loongson2_pmu_read,
+	.write		= loongson2_pmu_write,
+	.event_idx	= loongson2_event_idx,
+	.event_map	= loongson2_event_map,
+	.max_events	= ARRAY_SIZE(loongson2_general_events),
+	.raw_event_mask	= LOONGSON2_EVENT_MASK,
+	.cache_events	= &loongson2_cache_events,
+};
+
+/*
+ * Emulators tend to ignore writes to the counter register and read it
+ * as zero; leave only the software events there.
+ */
+static int __init loongson2_pmu_probe(void)
+{
+	const u64 pattern = 0x12345678ULL << 32 | 0x07654321;
+	u64 saved, count;
+
+	write_c0_perfctrl(0);
+	saved = read_c0_perfcnt();
+	write_c0_perfcnt(pattern);
+	count = read_c0_perfcnt();
+	write_c0_perfcnt(saved);
+
+	return count == pattern;
+}
+
+static int __init loongson2_pmu_init(void)
+{
+	if (current_cpu_type() != CPU_LOONGSON2)
+		return -ENODEV;
+
+	if (!loongson2_pmu_probe()) {
+		pr_info("Performance Events: no Loongson 2 counters found\n");
+		return -ENODEV;
+	}
+
+	return register_mips_pmu(&loongson2_pmu);
+}
+arch_initcall(loongson2_pmu_init);
@@ -14,6 +14,7 @@
 #include <linux/tick.h>
 #include <linux/kernel.h>
 #include <linux/mm.h>
+#include <linux/pm.h>
 #include <linux/stddef.h>
 #include <linux/unistd.h>
 #include <linux/ptrace.h>
@@ -26,6 +27,7 @@
 #include <linux/completion.h>
 #include <linux/kallsyms.h>
 #include <linux/random.h>
+#include <linux/seq_file.h>
 
 #include <asm/asm.h>
 #include <asm/bootinfo.h>
@@ -43,6 +45,13 @@
 #include <asm/inst.h>
 #include <asm/stacktrace.h>
 
+/*
+ * A cpuidle driver hooks in here; it is entered with interrupts disabled
+ * and has to return with them enabled again.
+ */
+void (*pm_idle)(void);
+EXPORT_SYMBOL(pm_idle);
+
 /*
  * The idle thread. There's no useful work to be done, so just try to conserve
  * power and have a low exit latency (ie sit in a loop waiting for somebody to
@@ -64,7 +73,10 @@ void __noreturn cpu_idle(void)
 
 			smtc_idle_loop_hook();
 #endif
-			if (cpu_wait)
+			if (pm_idle) {
+				local_irq_disable();
+				(*pm_idle)();
+			} else if (cpu_wait)
 				(*cpu_wait)();
 		}
 #ifdef CONFIG_HOTPLUG_CPU
@@ -80,6 +92,50 @@ void __noreturn cpu_idle(void)
 	}
 }
 
+static void do_nothing(void *unused)
+{
+}
+
+/*
+ * cpu_idle_wait - make sure that all the CPUs have stopped using the old
+ * pm_idle handler.
+ *
+ * The caller has to change pm_idle before calling this; the old handler
+ * is not used by any CPU once it returns.
+ */
+void cpu_idle_wait(void)
+{
+	smp_mb();
+	/* kick all the CPUs so that they exit out of pm_idle */
+	smp_call_function(do_nothing, NULL, 1);
+}
+EXPORT_SYMBOL_GPL(cpu_idle_wait);
+
+/*
+ * Called when switching to a task which used the FPU in each of its last
+ * few timeslices: it will almost certainly take the coprocessor unusable
+ * exception again, so the FPU context is restored right away instead.
+ * As fpu_counter keeps counting up, it wraps after a while and the task
+ * has to show again that it still needs the FPU that often.
+ */
+void preload_fpu(void)
+{
+	if (!cpu_has_fpu || !used_math() || __is_fpu_owner())
+		return;
+
+	own_fpu_inatomic(1);
+	current->fpu_counter++;
+	current->thread.fpu_preloads++;
+}
+
+void task_show_stats(struct seq_file *m, struct task_struct *task)
+{
+	seq_printf(m, "fpu_traps:\t%lu\n", task->thread.fpu_traps);
+	seq_printf(m, "fpu_preloads:\t%lu\n", task->thread.fpu_preloads);
+	seq_printf(m, "unaligned_fixups:\t%lu\n",
+		   task->thread.unaligned_fixups);
+}
+
 asmlinkage void ret_from_fork(void);
 
 void start_thread(struct pt_regs * regs, unsigned long pc, unsigned long sp)
@@ -166,6 +222,10 @@ int copy_thread(unsigned long clone_flags, unsigned long usp,
 	childregs->cp0_tcstatus &= ~(ST0_CU2|ST0_CU1);
 #endif
 	clear_tsk_thread_flag(p, TIF_USEDFPU);
+	p->fpu_counter = 0;
+	p->thread.fpu_traps = 0;
+	p->thread.fpu_preloads = 0;
+	p->thread.unaligned_fixups = 0;
 
 #ifdef CONFIG_MIPS_MT_FPAFF
 	clear_tsk_thread_flag(p, TIF_FPUBOUND);
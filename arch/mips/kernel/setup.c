@@ -249,7 +249,23 @@ static void __init bootmem_init(void)
 	finalize_initrd();
 }
 
-#else  /* !CONFIG_SGI_IP27 */
+#elif defined(CONFIG_NEED_MULTIPLE_NODES)
+
+static void __init bootmem_init(void)
+{
+	unsigned long reserved_end;
+
+	reserved_end = max(init_initrd(),
+			   (unsigned long) PFN_UP(__pa_symbol(&_end)));
+	plat_bootmem_init(reserved_end);
+
+	/*
+	 * Reserve initrd memory if needed.
+	 */
+	finalize_initrd();
+}
+
+#else  /* !CONFIG_NEED_MULTIPLE_NODES */
 
 static void __init bootmem_init(void)
 {
@@ -403,7 +419,7 @@ static void __init bootmem_init(void)
 	finalize_initrd();
 }
 
-#endif	/* CONFIG_SGI_IP27 */
+#endif	/* !CONFIG_NEED_MULTIPLE_NODES */
 
 /*
  * arch_mem_init - initialize memory management subsystem
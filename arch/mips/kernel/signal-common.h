@@ -11,6 +11,8 @@
 #ifndef __SIGNAL_COMMON_H
 #define __SIGNAL_COMMON_H
 
+#include <asm/vdso.h>
+
 /* #define DEBUG_SIG */
 
 #ifdef DEBUG_SIG
@@ -31,6 +33,15 @@ extern void __user *get_sigframe(struct k_sigaction *ka, struct pt_regs *regs,
  */
 extern int install_sigtramp(unsigned int __user *tramp, unsigned int syscall);
 
+/*
+ * The trampoline the handler returns to: the vDSO one if the task has
+ * the vDSO mapped, else the copy in the signal frame.
+ */
+#define sigtramp_addr(frame_tramp, name)				\
+	(current->mm->context.vdso ?					\
+	 VDSO_SYMBOL(current->mm->context.vdso, name) :			\
+	 (unsigned long)(frame_tramp))
+
 /* Check and clear pending FPU exceptions in saved CSR */
 extern int fpcsr_pending(unsigned int __user *fpcsr);
 
@@ -240,6 +240,7 @@ void flush_tlb_all(void)
 
 static void flush_tlb_mm_ipi(void *mm)
 {
+	count_vm_tlb_event(NR_TLB_REMOTE_FLUSH_RECEIVED);
 	local_flush_tlb_mm((struct mm_struct *)mm);
 }
 
@@ -269,6 +270,46 @@ static inline void smp_on_each_tlb(void (*func) (void *info), void *info)
 	preempt_enable();
 }
 
+/*
+ * Flush the entries of mm from the TLBs of the other CPUs.  Only the CPUs
+ * that have the mm loaded are interrupted; on the others its context is
+ * just cleared, so that it gets a new ASID if it ever runs there again.
+ *
+ * The context is cleared before mm_cpumask() is looked at again, while
+ * switch_mm() marks the mm loaded before looking at the context: either
+ * the CPU sees the cleared context, or it gets the IPI and finds that the
+ * mm lost its context (see local_tlb_holds_mm() in tlb-r4k.c).
+ */
+static void smp_on_mm_tlbs(struct mm_struct *mm, void (*func) (void *info),
+	void *info)
+{
+#ifndef CONFIG_MIPS_MT_SMTC
+	unsigned int cpu, this_cpu = smp_processor_id();
+	cpumask_t mask;
+
+	cpus_clear(mask);
+	for_each_online_cpu(cpu) {
+		if (cpu == this_cpu)
+			continue;
+		if (!cpumask_test_cpu(cpu, mm_cpumask(mm))) {
+			if (!cpu_context(cpu, mm))
+				continue;
+			cpu_context(cpu, mm) = 0;
+			count_vm_tlb_event(NR_TLB_FLUSH_ASID);
+			smp_mb();
+			if (!cpumask_test_cpu(cpu, mm_cpumask(mm)))
+				continue;
+		}
+		cpu_set(cpu, mask);
+	}
+
+	if (!cpus_empty(mask)) {
+		count_vm_tlb_event(NR_TLB_REMOTE_FLUSH);
+		smp_call_function_many(&mask, func, info, 1);
+	}
+#endif
+}
+
 /*
  * The following tlb flush calls are invoked when old translations are
  * being torn down, or pte attributes are changing. For single threaded
@@ -287,7 +328,7 @@ void flush_tlb_mm(struct mm_struct *mm)
 	preempt_disable();
 
 	if ((atomic_read(&mm->mm_users) != 1) || (current->mm != mm)) {
-		smp_on_other_tlbs(flush_tlb_mm_ipi, mm);
+		smp_on_mm_tlbs(mm, flush_tlb_mm_ipi, mm);
 	} else {
 		cpumask_t mask = cpu_online_map;
 		unsigned int cpu;
@@ -312,6 +353,7 @@ static void flush_tlb_range_ipi(void *info)
 {
 	struct flush_tlb_data *fd = info;
 
+	count_vm_tlb_event(NR_TLB_REMOTE_FLUSH_RECEIVED);
 	local_flush_tlb_range(fd->vma, fd->addr1, fd->addr2);
 }
 
@@ -327,7 +369,7 @@ void flush_tlb_range(struct vm_area_struct *vma, unsigned long start, unsigned l
 			.addr2 = end,
 		};
 
-		smp_on_other_tlbs(flush_tlb_range_ipi, &fd);
+		smp_on_mm_tlbs(mm, flush_tlb_range_ipi, &fd);
 	} else {
 		cpumask_t mask = cpu_online_map;
 		unsigned int cpu;
@@ -362,6 +404,7 @@ static void flush_tlb_page_ipi(void *info)
 {
 	struct flush_tlb_data *fd = info;
 
+	count_vm_tlb_event(NR_TLB_REMOTE_FLUSH_RECEIVED);
 	local_flush_tlb_page(fd->vma, fd->addr1);
 }
 
@@ -374,7 +417,7 @@ void flush_tlb_page(struct vm_area_struct *vma, unsigned long page)
 			.addr1 = page,
 		};
 
-		smp_on_other_tlbs(flush_tlb_page_ipi, &fd);
+		smp_on_mm_tlbs(vma->vm_mm, flush_tlb_page_ipi, &fd);
 	} else {
 		cpumask_t mask = cpu_online_map;
 		unsigned int cpu;
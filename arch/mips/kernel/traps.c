@@ -25,6 +25,7 @@
 #include <linux/ptrace.h>
 #include <linux/kgdb.h>
 #include <linux/kdebug.h>
+#include <linux/kprobes.h>
 #include <linux/notifier.h>
 
 #include <asm/bootinfo.h>
@@ -747,7 +748,7 @@ static void do_trap_or_bp(struct pt_regs *regs, unsigned int code,
 	}
 }
 
-asmlinkage void do_bp(struct pt_regs *regs)
+asmlinkage void __kprobes do_bp(struct pt_regs *regs)
 {
 	unsigned int opcode, bcode;
 
@@ -764,6 +765,23 @@ asmlinkage void do_bp(struct pt_regs *regs)
 	if (bcode >= (1 << 10))
 		bcode >>= 10;
 
+	/*
+	 * notify the kprobe handlers, if instruction is likely to
+	 * pertain to them.
+	 */
+	switch (bcode) {
+	case BRK_KPROBE_BP:
+		if (notify_die(DIE_BREAK, "debug", regs, bcode, 0, SIGTRAP)
+		    == NOTIFY_STOP)
+			return;
+		break;
+	case BRK_KPROBE_SSTEPBP:
+		if (notify_die(DIE_SSTEPBP, "single_step", regs, bcode, 0,
+			       SIGTRAP) == NOTIFY_STOP)
+			return;
+		break;
+	}
+
 	do_trap_or_bp(regs, bcode, "Break");
 	return;
 
@@ -936,6 +954,9 @@ asmlinkage void do_cpu(struct pt_regs *regs)
 		return;
 
 	case 1:
+		current->fpu_counter++;
+		current->thread.fpu_traps++;
+
 		if (used_math())	/* Using the FPU again.  */
 			own_fpu(1);
 		else {			/* First time FPU user.  */
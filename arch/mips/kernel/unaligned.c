@@ -36,6 +36,10 @@
  * ...
  *
  * The argument x is 0 for disabling software emulation, enabled otherwise.
+ * The same can be done with prctl(PR_SET_UNALIGN, x), x being
+ * PR_UNALIGN_SIGBUS to disable it, PR_UNALIGN_NOPRINT to fix up silently
+ * or 0 to fix up and log each access.  The number of fixups done for a
+ * task is shown as unaligned_fixups in /proc/<pid>/status.
  *
  * Below a little program to play around with this feature.
  *
@@ -78,6 +82,7 @@
 #include <linux/smp.h>
 #include <linux/sched.h>
 #include <linux/debugfs.h>
+#include <linux/prctl.h>
 #include <asm/asm.h>
 #include <asm/branch.h>
 #include <asm/byteorder.h>
@@ -89,6 +94,64 @@
 #define STR(x)  __STR(x)
 #define __STR(x)  #x
 
+/*
+ * Word and doubleword accesses through a pair of left/right instructions;
+ * res is set to -EFAULT if either of them faults.
+ */
+#define __load_pair(l, r, loff, roff, addr, value, res)			\
+	__asm__ __volatile__ (						\
+		"1:\t" l "\t%0, " loff "(%2)\n"				\
+		"2:\t" r "\t%0, " roff "(%2)\n\t"			\
+		"li\t%1, 0\n"						\
+		"3:\t.section\t.fixup,\"ax\"\n\t"			\
+		"4:\tli\t%1, %3\n\t"					\
+		"j\t3b\n\t"						\
+		".previous\n\t"						\
+		".section\t__ex_table,\"a\"\n\t"			\
+		STR(PTR)"\t1b, 4b\n\t"					\
+		STR(PTR)"\t2b, 4b\n\t"					\
+		".previous"						\
+		: "=&r" (value), "=r" (res)				\
+		: "r" (addr), "i" (-EFAULT))
+
+#define __store_pair(l, r, loff, roff, addr, value, res)		\
+	__asm__ __volatile__ (						\
+		"1:\t" l "\t%1, " loff "(%2)\n"				\
+		"2:\t" r "\t%1, " roff "(%2)\n\t"			\
+		"li\t%0, 0\n"						\
+		"3:\n\t"						\
+		".section\t.fixup,\"ax\"\n\t"				\
+		"4:\tli\t%0, %3\n\t"					\
+		"j\t3b\n\t"						\
+		".previous\n\t"						\
+		".section\t__ex_table,\"a\"\n\t"			\
+		STR(PTR)"\t1b, 4b\n\t"					\
+		STR(PTR)"\t2b, 4b\n\t"					\
+		".previous"						\
+		: "=r" (res)						\
+		: "r" (value), "r" (addr), "i" (-EFAULT))
+
+#ifdef __BIG_ENDIAN
+#define LoadW(addr, value, res)	\
+	__load_pair("lwl", "lwr", "", "3", addr, value, res)
+#define LoadDW(addr, value, res) \
+	__load_pair("ldl", "ldr", "", "7", addr, value, res)
+#define StoreW(addr, value, res) \
+	__store_pair("swl", "swr", "", "3", addr, value, res)
+#define StoreDW(addr, value, res) \
+	__store_pair("sdl", "sdr", "", "7", addr, value, res)
+#endif
+#ifdef __LITTLE_ENDIAN
+#define LoadW(addr, value, res)	\
+	__load_pair("lwl", "lwr", "3", "", addr, value, res)
+#define LoadDW(addr, value, res) \
+	__load_pair("ldl", "ldr", "7", "", addr, value, res)
+#define StoreW(addr, value, res) \
+	__store_pair("swl", "swr", "3", "", addr, value, res)
+#define StoreDW(addr, value, res) \
+	__store_pair("sdl", "sdr", "7", "", addr, value, res)
+#endif
+
 enum {
 	UNALIGNED_ACTION_QUIET,
 	UNALIGNED_ACTION_SIGNAL,
@@ -186,26 +249,7 @@ static void emulate_load_store_insn(struct pt_regs *regs,
 		if (!access_ok(VERIFY_READ, addr, 4))
 			goto sigbus;
 
-		__asm__ __volatile__ (
-#ifdef __BIG_ENDIAN
-			"1:\tlwl\t%0, (%2)\n"
-			"2:\tlwr\t%0, 3(%2)\n\t"
-#endif
-#ifdef __LITTLE_ENDIAN
-			"1:\tlwl\t%0, 3(%2)\n"
-			"2:\tlwr\t%0, (%2)\n\t"
-#endif
-			"li\t%1, 0\n"
-			"3:\t.section\t.fixup,\"ax\"\n\t"
-			"4:\tli\t%1, %3\n\t"
-			"j\t3b\n\t"
-			".previous\n\t"
-			".section\t__ex_table,\"a\"\n\t"
-			STR(PTR)"\t1b, 4b\n\t"
-			STR(PTR)"\t2b, 4b\n\t"
-			".previous"
-			: "=&r" (value), "=r" (res)
-			: "r" (addr), "i" (-EFAULT));
+		LoadW(addr, value, res);
 		if (res)
 			goto fault;
 		compute_return_epc(regs);
@@ -302,26 +346,7 @@ static void emulate_load_store_insn(struct pt_regs *regs,
 		if (!access_ok(VERIFY_READ, addr, 8))
 			goto sigbus;
 
-		__asm__ __volatile__ (
-#ifdef __BIG_ENDIAN
-			"1:\tldl\t%0, (%2)\n"
-			"2:\tldr\t%0, 7(%2)\n\t"
-#endif
-#ifdef __LITTLE_ENDIAN
-			"1:\tldl\t%0, 7(%2)\n"
-			"2:\tldr\t%0, (%2)\n\t"
-#endif
-			"li\t%1, 0\n"
-			"3:\t.section\t.fixup,\"ax\"\n\t"
-			"4:\tli\t%1, %3\n\t"
-			"j\t3b\n\t"
-			".previous\n\t"
-			".section\t__ex_table,\"a\"\n\t"
-			STR(PTR)"\t1b, 4b\n\t"
-			STR(PTR)"\t2b, 4b\n\t"
-			".previous"
-			: "=&r" (value), "=r" (res)
-			: "r" (addr), "i" (-EFAULT));
+		LoadDW(addr, value, res);
 		if (res)
 			goto fault;
 		compute_return_epc(regs);
@@ -374,27 +399,7 @@ static void emulate_load_store_insn(struct pt_regs *regs,
 			goto sigbus;
 
 		value = regs->regs[insn.i_format.rt];
-		__asm__ __volatile__ (
-#ifdef __BIG_ENDIAN
-			"1:\tswl\t%1,(%2)\n"
-			"2:\tswr\t%1, 3(%2)\n\t"
-#endif
-#ifdef __LITTLE_ENDIAN
-			"1:\tswl\t%1, 3(%2)\n"
-			"2:\tswr\t%1, (%2)\n\t"
-#endif
-			"li\t%0, 0\n"
-			"3:\n\t"
-			".section\t.fixup,\"ax\"\n\t"
-			"4:\tli\t%0, %3\n\t"
-			"j\t3b\n\t"
-			".previous\n\t"
-			".section\t__ex_table,\"a\"\n\t"
-			STR(PTR)"\t1b, 4b\n\t"
-			STR(PTR)"\t2b, 4b\n\t"
-			".previous"
-		: "=r" (res)
-		: "r" (value), "r" (addr), "i" (-EFAULT));
+		StoreW(addr, value, res);
 		if (res)
 			goto fault;
 		compute_return_epc(regs);
@@ -413,27 +418,7 @@ static void emulate_load_store_insn(struct pt_regs *regs,
 			goto sigbus;
 
 		value = regs->regs[insn.i_format.rt];
-		__asm__ __volatile__ (
-#ifdef __BIG_ENDIAN
-			"1:\tsdl\t%1,(%2)\n"
-			"2:\tsdr\t%1, 7(%2)\n\t"
-#endif
-#ifdef __LITTLE_ENDIAN
-			"1:\tsdl\t%1, 7(%2)\n"
-			"2:\tsdr\t%1, (%2)\n\t"
-#endif
-			"li\t%0, 0\n"
-			"3:\n\t"
-			".section\t.fixup,\"ax\"\n\t"
-			"4:\tli\t%0, %3\n\t"
-			"j\t3b\n\t"
-			".previous\n\t"
-			".section\t__ex_table,\"a\"\n\t"
-			STR(PTR)"\t1b, 4b\n\t"
-			STR(PTR)"\t2b, 4b\n\t"
-			".previous"
-		: "=r" (res)
-		: "r" (value), "r" (addr), "i" (-EFAULT));
+		StoreDW(addr, value, res);
 		if (res)
 			goto fault;
 		compute_return_epc(regs);
@@ -484,6 +469,8 @@ static void emulate_load_store_insn(struct pt_regs *regs,
 #ifdef CONFIG_DEBUG_FS
 	unaligned_instructions++;
 #endif
+	if (user_mode(regs))
+		current->thread.unaligned_fixups++;
 
 	return;
 
@@ -508,6 +495,74 @@ sigill:
 	force_sig(SIGILL, current);
 }
 
+/*
+ * Nearly all of the unaligned accesses of user code are plain word and
+ * doubleword loads and stores outside of branch delay slots.  Fix these
+ * up right away, without the set_fs() and the branch emulation needed
+ * for the rest; anything else, faults included, is left to
+ * emulate_load_store_insn().
+ */
+static int fast_fixup_user(struct pt_regs *regs, void __user *addr,
+	unsigned int __user *pc)
+{
+	union mips_instruction insn;
+	unsigned long value;
+	unsigned int res;
+	int rt;
+
+	if (__get_user(insn.word, pc))
+		return 0;
+	rt = insn.i_format.rt;
+
+	switch (insn.i_format.opcode) {
+	case lw_op:
+		if (!access_ok(VERIFY_READ, addr, 4))
+			return 0;
+		LoadW(addr, value, res);
+		if (res)
+			return 0;
+		regs->regs[rt] = value;
+		break;
+
+	case sw_op:
+		if (!access_ok(VERIFY_WRITE, addr, 4))
+			return 0;
+		value = regs->regs[rt];
+		StoreW(addr, value, res);
+		if (res)
+			return 0;
+		break;
+
+#ifdef CONFIG_64BIT
+	case ld_op:
+		if (!access_ok(VERIFY_READ, addr, 8))
+			return 0;
+		LoadDW(addr, value, res);
+		if (res)
+			return 0;
+		regs->regs[rt] = value;
+		break;
+
+	case sd_op:
+		if (!access_ok(VERIFY_WRITE, addr, 8))
+			return 0;
+		value = regs->regs[rt];
+		StoreDW(addr, value, res);
+		if (res)
+			return 0;
+		break;
+#endif /* CONFIG_64BIT */
+
+	default:
+		return 0;
+	}
+
+	regs->regs[0] = 0;
+	regs->cp0_epc += 4;
+
+	return 1;
+}
+
 asmlinkage void do_ade(struct pt_regs *regs)
 {
 	unsigned int __user *pc;
@@ -521,13 +576,29 @@ asmlinkage void do_ade(struct pt_regs *regs)
 		goto sigbus;
 
 	pc = (unsigned int __user *) exception_epc(regs);
-	if (user_mode(regs) && !test_thread_flag(TIF_FIXADE))
-		goto sigbus;
+	if (user_mode(regs)) {
+		if (test_thread_flag(TIF_LOGADE) && printk_ratelimit())
+			printk(KERN_INFO "%s[%d]: unaligned access to 0x%lx "
+			       "at pc 0x%lx\n", current->comm,
+			       task_pid_nr(current), regs->cp0_badvaddr,
+			       regs->cp0_epc);
+		if (!test_thread_flag(TIF_FIXADE))
+			goto sigbus;
+	}
 	if (unaligned_action == UNALIGNED_ACTION_SIGNAL)
 		goto sigbus;
 	else if (unaligned_action == UNALIGNED_ACTION_SHOW)
 		show_registers(regs);
 
+	if (user_mode(regs) && !delay_slot(regs) &&
+	    fast_fixup_user(regs, (void __user *)regs->cp0_badvaddr, pc)) {
+#ifdef CONFIG_DEBUG_FS
+		unaligned_instructions++;
+#endif
+		current->thread.unaligned_fixups++;
+		return;
+	}
+
 	/*
 	 * Do branch emulation only if we didn't forward the exception.
 	 * This is all so but ugly ...
@@ -549,6 +620,39 @@ sigbus:
 	 */
 }
 
+/*
+ * PR_SET_UNALIGN and PR_GET_UNALIGN, the prctl() side of TIF_FIXADE and
+ * TIF_LOGADE.
+ */
+int set_unalign_ctl(struct task_struct *tsk, unsigned int val)
+{
+	if (val & ~(PR_UNALIGN_NOPRINT | PR_UNALIGN_SIGBUS))
+		return -EINVAL;
+
+	if (val & PR_UNALIGN_SIGBUS)
+		clear_tsk_thread_flag(tsk, TIF_FIXADE);
+	else
+		set_tsk_thread_flag(tsk, TIF_FIXADE);
+	if (val & PR_UNALIGN_NOPRINT)
+		clear_tsk_thread_flag(tsk, TIF_LOGADE);
+	else
+		set_tsk_thread_flag(tsk, TIF_LOGADE);
+
+	return 0;
+}
+
+int get_unalign_ctl(struct task_struct *tsk, unsigned long adr)
+{
+	unsigned int val = 0;
+
+	if (!test_tsk_thread_flag(tsk, TIF_FIXADE))
+		val |= PR_UNALIGN_SIGBUS;
+	if (!test_tsk_thread_flag(tsk, TIF_LOGADE))
+		val |= PR_UNALIGN_NOPRINT;
+
+	return put_user(val, (unsigned int __user *)adr);
+}
+
 #ifdef CONFIG_DEBUG_FS
 extern struct dentry *mips_debugfs_dir;
 static int __init debugfs_unaligned(void)
@@ -0,0 +1,211 @@
+/*
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ *
+ * Set up the vDSO: the signal return trampolines, and clock_gettime()
+ * and gettimeofday() that run in user space off a data page the kernel
+ * updates on every tick.
+ */
+#include <linux/binfmts.h>
+#include <linux/clocksource.h>
+#include <linux/elf.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/time.h>
+
+#include <asm/cacheflush.h>
+#include <asm/cpu-features.h>
+#include <asm/page.h>
+#include <asm/time.h>
+#include <asm/vdso.h>
+#include <asm/vdso_datapage.h>
+
+unsigned int vdso_enabled __read_mostly = 1;
+
+extern char vdso_start[], vdso_end[];
+
+/* NULL terminated, as install_special_mapping() wants them */
+static struct page *vdso_data_pages[2];
+static struct page **vdso_pages;
+static unsigned long vdso_size;
+
+static struct vdso_data *vdso_data;
+
+static int __init vdso_setup(char *s)
+{
+	vdso_enabled = simple_strtoul(s, NULL, 0);
+	return 1;
+}
+__setup("vdso=", vdso_setup);
+
+/*
+ * With aliasing caches the kernel has to write the data page through an
+ * address of the same colour as the one user space reads it at, or the
+ * tasks would see stale lines.  Allocate a block with a page of every
+ * colour and keep the right one.
+ */
+static struct page * __init alloc_vdso_data_page(void)
+{
+	unsigned int order = get_order(shm_align_mask + 1);
+	struct page *page, *data_page = NULL;
+	unsigned long i;
+
+	page = alloc_pages(GFP_KERNEL | __GFP_ZERO, order);
+	if (!page)
+		return NULL;
+	split_page(page, order);
+
+	for (i = 0; i < (1UL << order); i++) {
+		if (!data_page &&
+		    !pages_do_alias((unsigned long)page_address(page + i),
+				    VDSO_BASE))
+			data_page = page + i;
+		else
+			__free_page(page + i);
+	}
+
+	return data_page;
+}
+
+static int __init init_vdso(void)
+{
+	unsigned long len = vdso_end - vdso_start;
+	unsigned int i, npages = PAGE_ALIGN(len) >> PAGE_SHIFT;
+
+	if (!vdso_enabled)
+		return 0;
+
+	if (memcmp(vdso_start, ELFMAG, SELFMAG)) {
+		printk(KERN_ERR "vDSO: image is not ELF\n");
+		goto fail;
+	}
+
+	vdso_pages = kcalloc(npages + 1, sizeof(struct page *), GFP_KERNEL);
+	if (!vdso_pages)
+		goto oom;
+
+	for (i = 0; i < npages; i++) {
+		struct page *page = alloc_page(GFP_KERNEL | __GFP_ZERO);
+		unsigned long kaddr;
+
+		if (!page)
+			goto oom;
+		kaddr = (unsigned long)page_address(page);
+		memcpy((void *)kaddr, vdso_start + (i << PAGE_SHIFT),
+		       min_t(unsigned long, len - (i << PAGE_SHIFT), PAGE_SIZE));
+		flush_icache_range(kaddr, kaddr + PAGE_SIZE);
+		vdso_pages[i] = page;
+	}
+	vdso_size = npages << PAGE_SHIFT;
+
+	vdso_data_pages[0] = alloc_vdso_data_page();
+	if (!vdso_data_pages[0])
+		goto oom;
+	vdso_data = page_address(vdso_data_pages[0]);
+	seqcount_init(&vdso_data->seq);
+
+	return 0;
+
+oom:
+	printk(KERN_ERR "vDSO: cannot allocate pages\n");
+fail:
+	vdso_enabled = 0;
+	return -ENOMEM;
+}
+arch_initcall(init_vdso);
+
+/*
+ * Map the data page and the image at the fixed address above the stack
+ * the image is prelinked to.  32-bit tasks on a 64-bit kernel get them
+ * at the same place below 2GB, but only use the signal trampolines.
+ */
+int arch_setup_additional_pages(struct linux_binprm *bprm, int uses_interp)
+{
+	struct mm_struct *mm = current->mm;
+	unsigned long base = STACK_TOP;
+	int ret;
+
+	if (!vdso_enabled)
+		return 0;
+
+	down_write(&mm->mmap_sem);
+
+	ret = install_special_mapping(mm, base, VDSO_DATA_SIZE,
+				      VM_READ | VM_MAYREAD, vdso_data_pages);
+	if (ret)
+		goto out;
+
+	ret = install_special_mapping(mm, base + VDSO_DATA_SIZE, vdso_size,
+				      VM_READ | VM_EXEC |
+				      VM_MAYREAD | VM_MAYWRITE | VM_MAYEXEC |
+				      VM_ALWAYSDUMP,
+				      vdso_pages);
+	if (ret)
+		goto out;
+
+	mm->context.vdso = (void *)(base + VDSO_DATA_SIZE);
+
+out:
+	up_write(&mm->mmap_sem);
+	return ret;
+}
+
+const char *arch_vma_name(struct vm_area_struct *vma)
+{
+	if (vma->vm_mm &&
+	    vma->vm_start == (unsigned long)vma->vm_mm->context.vdso)
+		return "[vdso]";
+	return NULL;
+}
+
+/*
+ * The count register can only be read from user mode on R2 CPUs, where
+ * HWREna is set up to allow it.
+ */
+static inline u32 vdso_clock_mode(struct clocksource *clock)
+{
+#ifdef CONFIG_CSRC_R4K_LIB
+	if (clock == &clocksource_mips && cpu_has_mips_r2)
+		return VDSO_CLOCK_R4K;
+#endif
+	return VDSO_CLOCK_NONE;
+}
+
+/* Called with xtime_lock held for writing */
+void update_vsyscall(struct timespec *ts, struct clocksource *clock, u32 mult)
+{
+	if (!vdso_data)
+		return;
+
+	write_seqcount_begin(&vdso_data->seq);
+	vdso_data->clock_mode = vdso_clock_mode(clock);
+	vdso_data->cycle_last = clock->cycle_last;
+	vdso_data->mask = clock->mask;
+	vdso_data->mult = mult;
+	vdso_data->shift = clock->shift;
+	vdso_data->xtime_sec = ts->tv_sec;
+	vdso_data->xtime_nsec = ts->tv_nsec;
+	vdso_data->wtm_sec = wall_to_monotonic.tv_sec;
+	vdso_data->wtm_nsec = wall_to_monotonic.tv_nsec;
+	write_seqcount_end(&vdso_data->seq);
+}
+
+void update_vsyscall_tz(void)
+{
+	unsigned long flags;
+
+	if (!vdso_data)
+		return;
+
+	write_seqlock_irqsave(&xtime_lock, flags);
+	write_seqcount_begin(&vdso_data->seq);
+	vdso_data->tz_minuteswest = sys_tz.tz_minuteswest;
+	vdso_data->tz_dsttime = sys_tz.tz_dsttime;
+	write_seqcount_end(&vdso_data->seq);
+	write_sequnlock_irqrestore(&xtime_lock, flags);
+}
@@ -0,0 +1,165 @@
+/*
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ *
+ * Benchmark for csum_partial() and csum_partial_copy_nocheck().
+ *
+ * Both are checked against a plain C implementation and timed with the
+ * count register over a range of lengths and source alignments.  The
+ * results are printed in bytes per count register tick; on most CPUs,
+ * Loongson 2 included, the counter runs at half the pipeline clock.
+ */
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/random.h>
+#include <linux/slab.h>
+
+#include <asm/checksum.h>
+#include <asm/cpu-features.h>
+#include <asm/mipsregs.h>
+#include <asm/unaligned.h>
+
+#define BENCH_MAXLEN	4096
+#define BENCH_ALIGNS	8
+#define BENCH_LOOPS	64
+#define BENCH_RUNS	4
+
+static const int bench_lens[] = { 20, 64, 256, 576, 1500, 4096 };
+
+static u32 ref_csum(const unsigned char *buf, int len)
+{
+	u32 sum = 0;
+	int i;
+
+	for (i = 0; i + 1 < len; i += 2)
+		sum += get_unaligned((u16 *)(buf + i));
+	if (len & 1)
+#ifdef __MIPSEL__
+		sum += buf[len - 1];
+#else
+		sum += buf[len - 1] << 8;
+#endif
+	while (sum >> 16)
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	return sum;
+}
+
+/* 0 and 0xffff are both zero in ones' complement */
+static int csum_matches(__wsum csum, u32 ref)
+{
+	u32 folded = (__force u16)~csum_fold(csum);
+
+	return folded % 0xffff == ref % 0xffff;
+}
+
+enum { BENCH_REF, BENCH_CSUM, BENCH_COPY, BENCH_NR };
+
+static const char *bench_names[BENCH_NR] = { "C", "csum", "copy" };
+
+/* Keeps the compiler from dropping the calls being timed */
+static volatile __wsum bench_sink;
+
+static unsigned int bench_one(int which, const unsigned char *src,
+			      unsigned char *dst, int len)
+{
+	unsigned int best = ~0U;
+	unsigned long flags;
+	int run, i;
+
+	for (run = 0; run < BENCH_RUNS; run++) {
+		unsigned int start, ticks;
+
+		local_irq_save(flags);
+		start = read_c0_count();
+		for (i = 0; i < BENCH_LOOPS; i++) {
+			switch (which) {
+			case BENCH_REF:
+				bench_sink = (__force __wsum)ref_csum(src, len);
+				break;
+			case BENCH_CSUM:
+				bench_sink = csum_partial(src, len, 0);
+				break;
+			case BENCH_COPY:
+				bench_sink = csum_partial_copy_nocheck(src, dst,
+								       len, 0);
+				break;
+			}
+		}
+		ticks = read_c0_count() - start;
+		local_irq_restore(flags);
+
+		if (ticks < best)
+			best = ticks;
+	}
+
+	return best;
+}
+
+static int __init csum_bench_init(void)
+{
+	unsigned char *src, *dst;
+	int l, align, which, err = 0;
+
+	if (!cpu_has_counter)
+		return -ENODEV;
+
+	src = kmalloc(BENCH_MAXLEN + BENCH_ALIGNS, GFP_KERNEL);
+	dst = kmalloc(BENCH_MAXLEN + BENCH_ALIGNS, GFP_KERNEL);
+	if (!src || !dst) {
+		err = -ENOMEM;
+		goto out;
+	}
+	get_random_bytes(src, BENCH_MAXLEN + BENCH_ALIGNS);
+
+	for (l = 0; l < ARRAY_SIZE(bench_lens); l++) {
+		int len = bench_lens[l];
+
+		for (align = 0; align < BENCH_ALIGNS; align++) {
+			unsigned char *s = src + align;
+			u32 ref = ref_csum(s, len);
+			char line[80];
+			int n = 0;
+
+			if (!csum_matches(csum_partial(s, len, 0), ref) ||
+			    !csum_matches(csum_partial_copy_nocheck(s, dst, len,
+								    0), ref) ||
+			    memcmp(s, dst, len)) {
+				printk(KERN_ERR "csum_bench: len %d align %d: "
+				       "wrong result\n", len, align);
+				err = -EINVAL;
+				continue;
+			}
+
+			for (which = 0; which < BENCH_NR; which++) {
+				unsigned int ticks;
+				unsigned long rate;
+
+				ticks = bench_one(which, s, dst, len) ? : 1;
+				rate = 100UL * len * BENCH_LOOPS / ticks;
+				n += snprintf(line + n, sizeof(line) - n,
+					      " %s %lu.%02lu", bench_names[which],
+					      rate / 100, rate % 100);
+			}
+			printk(KERN_INFO "csum_bench: len %4d align %d:%s\n",
+			       len, align, line);
+		}
+	}
+
+out:
+	kfree(dst);
+	kfree(src);
+	return err;
+}
+
+static void __exit csum_bench_exit(void)
+{
+}
+
+module_init(csum_bench_init);
+module_exit(csum_bench_exit);
+
+MODULE_DESCRIPTION("MIPS checksum benchmark");
+MODULE_LICENSE("GPL");
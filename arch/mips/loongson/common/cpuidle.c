@@ -0,0 +1,152 @@
+/*
+ * cpuidle driver of the Loongson 2F
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Loongson 2F has no wait instruction; setting the clock divider in
+ * CHIPCFG0 to 0 stops the core clock instead, until the next interrupt
+ * comes in.  That is what loongson2_cpu_wait() does, but waking up from
+ * it takes a while, so a polling state is offered next to it for the
+ * times the menu governor or a PM QoS CPU_DMA_LATENCY request can not
+ * afford that.
+ *
+ * The count register stops with the clock too, so the tick has to come
+ * from the MFGPT, and while the count based clocksource keeps the time
+ * the clock stop is replaced by polling.
+ *
+ * The exit latency of the clock stop is not known in advance: it is
+ * measured each time the sleep is ended by the expiry of the tick device,
+ * whose programmed expiry tells when the wakeup was asked for.
+ */
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/sched.h>
+#include <linux/cpuidle.h>
+#include <linux/ktime.h>
+#include <linux/tick.h>
+#include <linux/clockchips.h>
+
+#include <loongson.h>
+
+/* used until the first samples are in */
+#define CLKOFF_EXIT_LATENCY	10	/* us */
+
+/* anything longer did not come from the clock stop itself */
+#define CLKOFF_SAMPLE_MAX	(1000 * NSEC_PER_USEC)
+
+static s64 clkoff_latency_ns = CLKOFF_EXIT_LATENCY * NSEC_PER_USEC;
+
+static int loongson2_enter_poll(struct cpuidle_device *dev,
+				struct cpuidle_state *state)
+{
+	ktime_t before, after;
+
+	before = ktime_get();
+	local_irq_enable();
+	while (!need_resched())
+		cpu_relax();
+	after = ktime_get();
+
+	return ktime_to_us(ktime_sub(after, before));
+}
+
+static void clkoff_update_latency(struct cpuidle_device *dev,
+				  struct cpuidle_state *state,
+				  ktime_t before, ktime_t after)
+{
+	struct clock_event_device *evt = tick_get_device(dev->cpu)->evtdev;
+	s64 delta;
+
+	if (!evt || evt->mode != CLOCK_EVT_MODE_ONESHOT)
+		return;
+
+	/* only the sleeps which were ended by the timer tell anything */
+	if (ktime_to_ns(ktime_sub(evt->next_event, before)) < 0)
+		return;
+	delta = ktime_to_ns(ktime_sub(after, evt->next_event));
+	if (delta < 0 || delta > CLKOFF_SAMPLE_MAX)
+		return;
+
+	/* running average over the last eight samples or so */
+	clkoff_latency_ns += (delta - clkoff_latency_ns) >> 3;
+
+	state->exit_latency = max_t(unsigned int, 1,
+			DIV_ROUND_UP((u32)clkoff_latency_ns, NSEC_PER_USEC));
+	/* stopping the clock does not pay off for shorter sleeps */
+	state->target_residency = 2 * state->exit_latency;
+}
+
+/* entered with interrupts disabled, the pending one wakes us up */
+static int loongson2_enter_clkoff(struct cpuidle_device *dev,
+				  struct cpuidle_state *state)
+{
+	ktime_t before, after;
+	u32 cfg;
+
+	/* the count based clocksource would lose the time spent asleep */
+	if (!loongson2f_can_stop_clock()) {
+		dev->last_state = &dev->states[0];
+		return loongson2_enter_poll(dev, dev->last_state);
+	}
+
+	before = ktime_get();
+	cfg = LOONGSON_CHIPCFG0;
+	LOONGSON_CHIPCFG0 = cfg & ~0x7;		/* stop the clock */
+	LOONGSON_CHIPCFG0 = cfg;		/* and restore it */
+	after = ktime_get();
+
+	clkoff_update_latency(dev, state, before, after);
+	local_irq_enable();
+
+	return ktime_to_us(ktime_sub(after, before));
+}
+
+static struct cpuidle_device loongson2_cpuidle_device;
+static struct cpuidle_driver loongson2_cpuidle_driver = {
+	.name =		"loongson2_idle",
+	.owner =	THIS_MODULE,
+};
+
+static int __init loongson2_cpuidle_init(void)
+{
+	struct cpuidle_device *dev = &loongson2_cpuidle_device;
+	struct cpuidle_state *state;
+	int ret;
+
+	ret = cpuidle_register_driver(&loongson2_cpuidle_driver);
+	if (ret)
+		return ret;
+
+	state = &dev->states[0];
+	snprintf(state->name, CPUIDLE_NAME_LEN, "C0");
+	strncpy(state->desc, "Polling", CPUIDLE_DESC_LEN);
+	state->exit_latency = 0;
+	state->target_residency = 0;
+	state->power_usage = 3;
+	state->flags = CPUIDLE_FLAG_POLL | CPUIDLE_FLAG_TIME_VALID;
+	state->enter = loongson2_enter_poll;
+
+	dev->safe_state = state;
+
+	state = &dev->states[1];
+	snprintf(state->name, CPUIDLE_NAME_LEN, "C1");
+	strncpy(state->desc, "Core clock stopped", CPUIDLE_DESC_LEN);
+	state->exit_latency = CLKOFF_EXIT_LATENCY;
+	state->target_residency = 2 * CLKOFF_EXIT_LATENCY;
+	state->power_usage = 1;
+	state->flags = CPUIDLE_FLAG_DEEP | CPUIDLE_FLAG_TIME_VALID;
+	state->enter = loongson2_enter_clkoff;
+
+	dev->state_count = 2;
+	dev->cpu = 0;
+
+	ret = cpuidle_register_device(dev);
+	if (ret)
+		cpuidle_unregister_driver(&loongson2_cpuidle_driver);
+
+	return ret;
+}
+device_initcall(loongson2_cpuidle_init);
@@ -72,7 +72,8 @@ static void init_mfgpt_timer(enum clock_event_mode mode,
 		break;
 
 	case CLOCK_EVT_MODE_ONESHOT:
-		/* The oneshot mode have very high deviation, Not use it! */
+		/* stop the periodic tick, mfgpt_next_event() restarts it */
+		disable_mfgpt0_counter();
 		break;
 
 	case CLOCK_EVT_MODE_RESUME:
@@ -82,10 +83,31 @@ static void init_mfgpt_timer(enum clock_event_mode mode,
 	spin_unlock(&mfgpt_lock);
 }
 
+/*
+ * The counter counts up from 0 and is reset when it matches comparator2,
+ * so for a one-shot event it is enough to load the delta into comparator2
+ * and restart the counter from 0. The interrupt handler stops it again.
+ */
+static int mfgpt_next_event(unsigned long delta,
+			    struct clock_event_device *evt)
+{
+	spin_lock(&mfgpt_lock);
+
+	disable_mfgpt0_counter();
+	outw(delta, MFGPT0_CMP2);	/* set comparator2 */
+	outw(0, MFGPT0_CNT);	/* set counter to 0 */
+	enable_mfgpt0_counter();
+
+	spin_unlock(&mfgpt_lock);
+
+	return 0;
+}
+
 static struct clock_event_device mfgpt_clockevent = {
 	.name = "mfgpt",
-	.features = CLOCK_EVT_FEAT_PERIODIC,
+	.features = CLOCK_EVT_FEAT_PERIODIC | CLOCK_EVT_FEAT_ONESHOT,
 	.set_mode = init_mfgpt_timer,
+	.set_next_event = mfgpt_next_event,
 	.irq = CS5536_MFGPT_INTR,
 };
 
@@ -101,8 +123,11 @@ static irqreturn_t timer_interrupt(int irq, void *dev_id)
 	 */
 	_rdmsr(DIVIL_MSR_REG(DIVIL_LBAR_MFGPT), &basehi, &mfgpt_base);
 
-	/* ack */
-	outw(inw(MFGPT0_SETUP) | 0x4000, MFGPT0_SETUP);
+	/* ack, and in one-shot mode stop the counter before it wraps */
+	if (mfgpt_clockevent.mode == CLOCK_EVT_MODE_ONESHOT)
+		outw((inw(MFGPT0_SETUP) | 0x4000) & 0x7fff, MFGPT0_SETUP);
+	else
+		outw(inw(MFGPT0_SETUP) | 0x4000, MFGPT0_SETUP);
 
 	mfgpt_clockevent.event_handler(&mfgpt_clockevent);
 
@@ -127,8 +152,8 @@ void __init setup_mfgpt0_timer(void)
 
 	cd->cpumask = cpumask_of(cpu);
 	clockevent_set_clock(cd, MFGPT_TICK_RATE);
-	cd->max_delta_ns = clockevent_delta2ns(0xffff, cd);
-	cd->min_delta_ns = clockevent_delta2ns(0xf, cd);
+	cd->max_delta_ns = clockevent_delta2ns(MFGPT_MAX_DELTA, cd);
+	cd->min_delta_ns = clockevent_delta2ns(MFGPT_MIN_DELTA, cd);
 
 	/* Enable MFGPT0 Comparator 2 Output to the Interrupt Mapper */
 	_wrmsr(DIVIL_MSR_REG(MFGPT_IRQ), 0, 0x100);
@@ -147,7 +172,11 @@ void __init setup_mfgpt0_timer(void)
 /*
  * Since the MFGPT overflows every tick, its not very useful
  * to just read by itself. So use jiffies to emulate a free
- * running counter:
+ * running counter.
+ *
+ * This only works as long as the clock event device is periodic, which
+ * is why the clocksource is not flagged CLOCK_SOURCE_VALID_FOR_HRES:
+ * while it is in use the tick code does not switch to one-shot mode.
  */
 static cycle_t mfgpt_read(struct clocksource *cs)
 {
@@ -0,0 +1,169 @@
+/*
+ * Cpufreq aware clocksource and sched_clock for Loongson 2F
+ *
+ * The R4K count register of the Loongson 2F runs at half the CPU clock,
+ * which the cpufreq driver changes at runtime. Instead of exporting the
+ * raw count, keep a nanosecond clock that is folded at the old rate and
+ * rescaled to the new one on every frequency transition. Readers are
+ * lockless and only retry if they raced with a rescale.
+ *
+ * The count also stops while the core clock is stopped to idle, so that
+ * is not done while this is the clocksource.
+ *
+ *  This program is free software; you can redistribute  it and/or modify it
+ *  under  the terms of  the GNU General  Public License as published by the
+ *  Free Software Foundation;  either version 2 of the  License, or (at your
+ *  option) any later version.
+ */
+
+#include <linux/init.h>
+#include <linux/timer.h>
+#include <linux/seqlock.h>
+#include <linux/cpufreq.h>
+#include <linux/clocksource.h>
+
+#include <asm/time.h>
+#include <asm/mipsregs.h>
+
+#include <loongson.h>
+
+#define CYC2NS_SHIFT	22
+
+static struct {
+	seqcount_t	seq;
+	u64		base_ns;	/* clock value at base_count */
+	u32		base_count;
+	u32		mult;		/* ns per count, << CYC2NS_SHIFT */
+} cyc2ns __cacheline_aligned;
+
+static inline u64 notrace cyc2ns_read(void)
+{
+	unsigned seq;
+	u32 delta;
+	u64 ns;
+
+	do {
+		seq = read_seqcount_begin(&cyc2ns.seq);
+		delta = read_c0_count() - cyc2ns.base_count;
+		ns = cyc2ns.base_ns +
+			(((u64)delta * cyc2ns.mult) >> CYC2NS_SHIFT);
+	} while (read_seqcount_retry(&cyc2ns.seq, seq));
+
+	return ns;
+}
+
+/*
+ * Account the counts since the last update at the current rate and, if
+ * hz is non-zero, switch to the new one. The 2F is uniprocessor, so
+ * disabling interrupts is enough to keep readers from spinning on us.
+ */
+static void cyc2ns_update(unsigned long hz)
+{
+	unsigned long flags;
+	u32 now;
+
+	local_irq_save(flags);
+	write_seqcount_begin(&cyc2ns.seq);
+
+	now = read_c0_count();
+	cyc2ns.base_ns += ((u64)(now - cyc2ns.base_count) * cyc2ns.mult)
+				>> CYC2NS_SHIFT;
+	cyc2ns.base_count = now;
+	if (hz)
+		cyc2ns.mult = div_u64((u64)NSEC_PER_SEC << CYC2NS_SHIFT, hz);
+
+	write_seqcount_end(&cyc2ns.seq);
+	local_irq_restore(flags);
+}
+
+unsigned long long notrace sched_clock(void)
+{
+	return cyc2ns_read();
+}
+
+/*
+ * The count register wraps after 2^32 counts; fold it well before that
+ * happens at the highest frequency.
+ */
+static struct timer_list cyc2ns_keepwarm_timer;
+
+static void cyc2ns_keepwarm(unsigned long data)
+{
+	cyc2ns_update(0);
+	mod_timer(&cyc2ns_keepwarm_timer, round_jiffies(jiffies + data));
+}
+
+/*
+ * The frequency has already been switched when POSTCHANGE comes in, so
+ * the counts since then are accounted at the old rate. That window is a
+ * few microseconds at most, and the clock stays monotonic either way.
+ */
+static int cyc2ns_cpufreq_notifier(struct notifier_block *nb,
+				   unsigned long val, void *data)
+{
+	struct cpufreq_freqs *freqs = data;
+
+	if (val == CPUFREQ_POSTCHANGE || val == CPUFREQ_RESUMECHANGE)
+		cyc2ns_update(freqs->new * 1000 / 2);
+
+	return 0;
+}
+
+static struct notifier_block cyc2ns_cpufreq_notifier_block = {
+	.notifier_call = cyc2ns_cpufreq_notifier
+};
+
+static cycle_t loongson2f_clock_read(struct clocksource *cs)
+{
+	return cyc2ns_read();
+}
+
+/*
+ * The count register stops whenever CHIPCFG0 stops the core clock, so
+ * the idle code must not do that while the time is kept with it.
+ */
+int loongson2f_clocksource_in_use;
+
+static int loongson2f_clock_enable(struct clocksource *cs)
+{
+	loongson2f_clocksource_in_use = 1;
+	return 0;
+}
+
+static void loongson2f_clock_disable(struct clocksource *cs)
+{
+	loongson2f_clocksource_in_use = 0;
+}
+
+static struct clocksource clocksource_loongson2f = {
+	.name		= "loongson2f",
+	.rating		= 250,
+	.read		= loongson2f_clock_read,
+	.enable		= loongson2f_clock_enable,
+	.disable	= loongson2f_clock_disable,
+	.mask		= CLOCKSOURCE_MASK(64),
+	.flags		= CLOCK_SOURCE_IS_CONTINUOUS,
+};
+
+void __init init_loongson2f_clocksource(void)
+{
+	seqcount_init(&cyc2ns.seq);
+	cyc2ns.base_count = read_c0_count();
+	cyc2ns_update(mips_hpt_frequency);
+
+	clocksource_set_clock(&clocksource_loongson2f, NSEC_PER_SEC);
+	clocksource_register(&clocksource_loongson2f);
+}
+
+static int __init cyc2ns_cpufreq_init(void)
+{
+	unsigned long data;
+
+	data = 0x80000000UL / mips_hpt_frequency * HZ;
+	setup_timer(&cyc2ns_keepwarm_timer, cyc2ns_keepwarm, data);
+	mod_timer(&cyc2ns_keepwarm_timer, round_jiffies(jiffies + data));
+
+	return cpufreq_register_notifier(&cyc2ns_cpufreq_notifier_block,
+					 CPUFREQ_TRANSITION_NOTIFIER);
+}
+arch_initcall(cyc2ns_cpufreq_init);
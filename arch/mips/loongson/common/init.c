@@ -10,6 +10,8 @@
 
 #include <linux/bootmem.h>
 
+#include <asm/smp-ops.h>
+
 #include <loongson.h>
 
 /* Loongson CPU address windows config space base address */
@@ -32,6 +34,10 @@ void __init prom_init(void)
 
 	/*init the uart base address */
 	prom_init_uart_base();
+
+#if defined(CONFIG_CPU_LOONGSON3) && defined(CONFIG_SMP)
+	register_smp_ops(&loongson3_smp_ops);
+#endif
 }
 
 void __init prom_free_prom_memory(void)
@@ -27,6 +27,7 @@ static const char *system_types[] = {
 	[MACH_DEXXON_GDIUM2F10]         "dexxon-gidum-2f-10inches",
 	[MACH_LEMOTE_NAS]		"lemote-nas-2f",
 	[MACH_LEMOTE_LL2F]              "lemote-lynloong-2f",
+	[MACH_LOONGSON_3A]              "loongson-3a",
 	[MACH_LOONGSON_END]             NULL,
 };
 
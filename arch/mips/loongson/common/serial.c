@@ -28,16 +28,18 @@
 	.regshift	= 0,					\
 }
 
-#define PORT_M(int)				\
+#define PORT_M_CLK(int, clk)				\
 {								\
 	.irq		= MIPS_CPU_IRQ_BASE + (int),		\
-	.uartclk	= 3686400,				\
+	.uartclk	= clk,					\
 	.iotype		= UPIO_MEM,				\
 	.membase	= (void __iomem *)NULL,			\
 	.flags		= UPF_BOOT_AUTOCONF | UPF_SKIP_TEST,	\
 	.regshift	= 0,					\
 }
 
+#define PORT_M(int)	PORT_M_CLK(int, 3686400)
+
 static struct plat_serial8250_port uart8250_data[][2] = {
 	[MACH_LOONGSON_UNKNOWN]         {},
 	[MACH_LEMOTE_FL2E]              {PORT(4), {} },
@@ -47,6 +49,7 @@ static struct plat_serial8250_port uart8250_data[][2] = {
 	[MACH_DEXXON_GDIUM2F10]         {PORT_M(3), {} },
 	[MACH_LEMOTE_NAS]               {PORT_M(3), {} },
 	[MACH_LEMOTE_LL2F]              {PORT(3), {} },
+	[MACH_LOONGSON_3A]              {PORT_M_CLK(2, 25000000), {} },
 	[MACH_LOONGSON_END]             {},
 };
 
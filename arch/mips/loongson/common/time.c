@@ -22,6 +22,8 @@ void __init plat_time_init(void)
 	mips_hpt_frequency = cpu_clock_freq / 2;
 
 	setup_mfgpt0_timer();
+
+	init_loongson2f_clocksource();
 }
 
 void read_persistent_clock(struct timespec *ts)
@@ -11,24 +11,49 @@
  */
 
 #include <linux/module.h>
+#include <linux/freezer.h>
+#include <linux/hrtimer.h>
+#include <linux/kthread.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
 #include <linux/spinlock.h>
 #include <linux/delay.h>
 
 #include <ec_kb3310b.h>
 
-static DEFINE_SPINLOCK(index_access_lock);
-static DEFINE_SPINLOCK(port_access_lock);
+/*
+ * Every access to the EC ports, and every update of the register cache
+ * below, is done under ec_lock, so any context may call in.  The lock is
+ * only held for the port accesses themselves.
+ *
+ * The command transactions have to wait for the EC between the port
+ * accesses.  ec_query_seq() and ec_get_event_num() are for process
+ * context, such as the SCI irq thread and the EC ROM driver: they are
+ * serialized by ec_cmd_mutex and sleep while waiting.  The suspend path
+ * runs with interrupts off and uses the _atomic variants, which busy-wait
+ * instead; nothing else runs there.  ec_read() and ec_write(), and so the
+ * cache thread, never wait.
+ */
+static DEFINE_SPINLOCK(ec_lock);
+static DEFINE_MUTEX(ec_cmd_mutex);
+
+static void ec_cache_update(unsigned short addr, unsigned char val);
+
+static unsigned char __ec_read(unsigned short addr)
+{
+	outb((addr & 0xff00) >> 8, EC_IO_PORT_HIGH);
+	outb((addr & 0x00ff), EC_IO_PORT_LOW);
+	return inb(EC_IO_PORT_DATA);
+}
 
 unsigned char ec_read(unsigned short addr)
 {
 	unsigned char value;
 	unsigned long flags;
 
-	spin_lock_irqsave(&index_access_lock, flags);
-	outb((addr & 0xff00) >> 8, EC_IO_PORT_HIGH);
-	outb((addr & 0x00ff), EC_IO_PORT_LOW);
-	value = inb(EC_IO_PORT_DATA);
-	spin_unlock_irqrestore(&index_access_lock, flags);
+	spin_lock_irqsave(&ec_lock, flags);
+	value = __ec_read(addr);
+	spin_unlock_irqrestore(&ec_lock, flags);
 
 	return value;
 }
@@ -38,54 +63,146 @@ void ec_write(unsigned short addr, unsigned char val)
 {
 	unsigned long flags;
 
-	spin_lock_irqsave(&index_access_lock, flags);
+	spin_lock_irqsave(&ec_lock, flags);
 	outb((addr & 0xff00) >> 8, EC_IO_PORT_HIGH);
 	outb((addr & 0x00ff), EC_IO_PORT_LOW);
 	outb(val, EC_IO_PORT_DATA);
 	/*  flush the write action */
 	inb(EC_IO_PORT_DATA);
-	spin_unlock_irqrestore(&index_access_lock, flags);
-
-	return;
+	ec_cache_update(addr, val);
+	spin_unlock_irqrestore(&ec_lock, flags);
 }
 EXPORT_SYMBOL_GPL(ec_write);
 
-/*
- * This function is used for EC command writes and corresponding status queries.
- */
-int ec_query_seq(unsigned char cmd)
+static void ec_delay(int can_sleep)
+{
+	ktime_t expires;
+
+	if (!can_sleep) {
+		udelay(EC_REG_DELAY);
+		return;
+	}
+
+	expires = ktime_set(0, EC_REG_DELAY * NSEC_PER_USEC);
+	__set_current_state(TASK_UNINTERRUPTIBLE);
+	schedule_hrtimeout_range(&expires, EC_REG_DELAY * NSEC_PER_USEC / 4,
+				 HRTIMER_MODE_REL);
+}
+
+static unsigned char ec_read_status(void)
 {
-	int timeout;
 	unsigned char status;
 	unsigned long flags;
-	int ret = 0;
 
-	spin_lock_irqsave(&port_access_lock, flags);
+	spin_lock_irqsave(&ec_lock, flags);
+	status = inb(EC_STS_PORT);
+	spin_unlock_irqrestore(&ec_lock, flags);
 
-	/* make chip goto reset mode */
-	udelay(EC_REG_DELAY);
-	outb(cmd, EC_CMD_PORT);
-	udelay(EC_REG_DELAY);
+	return status;
+}
 
-	/* check if the command is received by ec */
-	timeout = EC_CMD_TIMEOUT;
-	status = inb(EC_STS_PORT);
-	while (timeout-- && (status & (1 << 1))) {
-		status = inb(EC_STS_PORT);
-		udelay(EC_REG_DELAY);
+/*
+ * Wait for the status bits in @mask to become @val, for up to
+ * EC_CMD_TIMEOUT polls.
+ */
+static int ec_wait_status(unsigned char mask, unsigned char val, int can_sleep)
+{
+	int timeout = EC_CMD_TIMEOUT;
+
+	while ((ec_read_status() & mask) != val) {
+		if (!--timeout)
+			return -ETIMEDOUT;
+		ec_delay(can_sleep);
+	}
+
+	return 0;
+}
+
+static int __ec_query_seq(unsigned char cmd, int can_sleep)
+{
+	int timeout = EC_CMD_TIMEOUT;
+	unsigned long flags;
+	int ret = 0;
+
+	/*
+	 * The command is only written once the EC has taken the previous
+	 * one, so that it does not overwrite a command still in the input
+	 * buffer.
+	 */
+	ec_delay(can_sleep);
+	for (;;) {
+		spin_lock_irqsave(&ec_lock, flags);
+		if (!(inb(EC_STS_PORT) & (1 << 1))) {
+			outb(cmd, EC_CMD_PORT);
+			spin_unlock_irqrestore(&ec_lock, flags);
+			break;
+		}
+		spin_unlock_irqrestore(&ec_lock, flags);
+		if (!--timeout) {
+			ret = -ETIMEDOUT;
+			break;
+		}
+		ec_delay(can_sleep);
 	}
+	ec_delay(can_sleep);
 
-	if (timeout <= 0) {
+	/* check if the command is received by ec */
+	if (!ret)
+		ret = ec_wait_status(1 << 1, 0, can_sleep);
+	if (ret) {
 		pr_err("%s: deadable error : timeout...\n", __func__);
 		ret = -EINVAL;
 	}
 
-	spin_unlock_irqrestore(&port_access_lock, flags);
+	return ret;
+}
+
+static int __ec_get_event_num(int can_sleep)
+{
+	unsigned long flags;
+	int ret;
+
+	ec_delay(can_sleep);
+	ret = ec_wait_status(1 << 0, 1 << 0, can_sleep);
+	if (ret) {
+		pr_err("%s: get event number timeout.\n", __func__);
+		return -EINVAL;
+	}
+
+	spin_lock_irqsave(&ec_lock, flags);
+	ret = inb(EC_DAT_PORT);
+	spin_unlock_irqrestore(&ec_lock, flags);
+	ec_delay(can_sleep);
+
+	return ret;
+}
+
+/*
+ * This function is used for EC command writes and corresponding status queries.
+ */
+int ec_query_seq(unsigned char cmd)
+{
+	int ret;
+
+	might_sleep();
+
+	mutex_lock(&ec_cmd_mutex);
+	ret = __ec_query_seq(cmd, 1);
+	mutex_unlock(&ec_cmd_mutex);
 
 	return ret;
 }
 EXPORT_SYMBOL_GPL(ec_query_seq);
 
+/*
+ * Like ec_query_seq(), for callers with interrupts disabled.
+ */
+int ec_query_seq_atomic(unsigned char cmd)
+{
+	return __ec_query_seq(cmd, 0);
+}
+EXPORT_SYMBOL_GPL(ec_query_seq_atomic);
+
 /*
  * Send query command to EC to get the proper event number
  */
@@ -103,24 +220,216 @@ EXPORT_SYMBOL(ec_query_event_num);
  */
 int ec_get_event_num(void)
 {
-	int timeout = 100;
-	unsigned char value;
-	unsigned char status;
+	int ret;
 
-	udelay(EC_REG_DELAY);
-	status = inb(EC_STS_PORT);
-	udelay(EC_REG_DELAY);
-	while (timeout-- && !(status & (1 << 0))) {
-		status = inb(EC_STS_PORT);
-		udelay(EC_REG_DELAY);
+	might_sleep();
+
+	mutex_lock(&ec_cmd_mutex);
+	ret = __ec_get_event_num(1);
+	mutex_unlock(&ec_cmd_mutex);
+
+	return ret;
+}
+EXPORT_SYMBOL(ec_get_event_num);
+
+/*
+ * Like ec_get_event_num(), for callers with interrupts disabled.
+ */
+int ec_get_event_num_atomic(void)
+{
+	return __ec_get_event_num(0);
+}
+EXPORT_SYMBOL_GPL(ec_get_event_num_atomic);
+
+/*
+ * Cache for the registers that are read often but change slowly, such as
+ * the battery and fan status.  A low priority thread refreshes it every
+ * EC_CACHE_INTERVAL, and writes through ec_write() update it right away.
+ * The entries are read and written under ec_lock, together with the EC
+ * access they belong to, so a refresh never stores a value older than
+ * the last write.  ec_cache_mutex serializes the users of the thread.
+ */
+#define EC_CACHE_SIZE		32
+#define EC_CACHE_INTERVAL	HZ
+
+struct ec_cache_entry {
+	unsigned short	addr;
+	unsigned char	val;
+};
+
+static struct ec_cache_entry ec_cache[EC_CACHE_SIZE];
+static int ec_cache_nr;
+static DEFINE_MUTEX(ec_cache_mutex);
+static struct task_struct *ec_cache_thread;
+static int ec_cache_paused;
+
+/* Called with ec_lock held */
+static struct ec_cache_entry *ec_cache_lookup(unsigned short addr)
+{
+	int i;
+
+	for (i = 0; i < ec_cache_nr; i++)
+		if (ec_cache[i].addr == addr)
+			return &ec_cache[i];
+
+	return NULL;
+}
+
+/* Called with ec_lock held */
+static void ec_cache_update(unsigned short addr, unsigned char val)
+{
+	struct ec_cache_entry *entry = ec_cache_lookup(addr);
+
+	if (entry)
+		entry->val = val;
+}
+
+static int ec_cache_refresh(void *unused)
+{
+	set_user_nice(current, 19);
+	set_freezable();
+
+	while (!kthread_should_stop()) {
+		unsigned long flags;
+		int i;
+
+		for (i = 0; ; i++) {
+			spin_lock_irqsave(&ec_lock, flags);
+			if (i >= ec_cache_nr) {
+				spin_unlock_irqrestore(&ec_lock, flags);
+				break;
+			}
+			ec_cache[i].val = __ec_read(ec_cache[i].addr);
+			spin_unlock_irqrestore(&ec_lock, flags);
+		}
+
+		schedule_timeout_interruptible(EC_CACHE_INTERVAL);
+		try_to_freeze();
 	}
-	if (timeout <= 0) {
-		pr_err("%s: get event number timeout.\n", __func__);
-		return -EINVAL;
+
+	return 0;
+}
+
+/* Called with ec_cache_mutex held */
+static int ec_cache_start(void)
+{
+	struct task_struct *t;
+
+	if (ec_cache_thread || ec_cache_paused || !ec_cache_nr)
+		return 0;
+
+	t = kthread_run(ec_cache_refresh, NULL, "kec_cache");
+	if (IS_ERR(t))
+		return PTR_ERR(t);
+	ec_cache_thread = t;
+
+	return 0;
+}
+
+/* Called with ec_cache_mutex held */
+static void ec_cache_stop(void)
+{
+	if (ec_cache_thread) {
+		kthread_stop(ec_cache_thread);
+		ec_cache_thread = NULL;
+	}
+}
+
+/*
+ * Have @addr served from the cache by ec_read_cached().
+ */
+int ec_cache_register(unsigned short addr)
+{
+	unsigned long flags;
+	int ret = 0;
+
+	mutex_lock(&ec_cache_mutex);
+
+	spin_lock_irqsave(&ec_lock, flags);
+	if (ec_cache_lookup(addr)) {
+		spin_unlock_irqrestore(&ec_lock, flags);
+		goto out;
+	}
+	if (ec_cache_nr == EC_CACHE_SIZE) {
+		spin_unlock_irqrestore(&ec_lock, flags);
+		ret = -ENOSPC;
+		goto out;
 	}
-	value = inb(EC_DAT_PORT);
-	udelay(EC_REG_DELAY);
+	ec_cache[ec_cache_nr].addr = addr;
+	ec_cache[ec_cache_nr].val = __ec_read(addr);
+	ec_cache_nr++;
+	spin_unlock_irqrestore(&ec_lock, flags);
+
+	ret = ec_cache_start();
+	if (ret) {
+		spin_lock_irqsave(&ec_lock, flags);
+		ec_cache_nr--;
+		spin_unlock_irqrestore(&ec_lock, flags);
+	}
+out:
+	mutex_unlock(&ec_cache_mutex);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(ec_cache_register);
+
+/*
+ * Drop all the registers from the cache and stop refreshing it.
+ */
+void ec_cache_unregister_all(void)
+{
+	unsigned long flags;
+
+	mutex_lock(&ec_cache_mutex);
+	ec_cache_stop();
+	spin_lock_irqsave(&ec_lock, flags);
+	ec_cache_nr = 0;
+	spin_unlock_irqrestore(&ec_lock, flags);
+	mutex_unlock(&ec_cache_mutex);
+}
+EXPORT_SYMBOL_GPL(ec_cache_unregister_all);
+
+/*
+ * Stop refreshing the cache, e.g. while the EC is being reflashed and
+ * must not be polled.  Calls nest and are undone by ec_cache_resume().
+ */
+void ec_cache_pause(void)
+{
+	mutex_lock(&ec_cache_mutex);
+	ec_cache_paused++;
+	ec_cache_stop();
+	mutex_unlock(&ec_cache_mutex);
+}
+EXPORT_SYMBOL_GPL(ec_cache_pause);
+
+void ec_cache_resume(void)
+{
+	mutex_lock(&ec_cache_mutex);
+	if (!WARN_ON(!ec_cache_paused) && !--ec_cache_paused &&
+	    ec_cache_start())
+		pr_warning("%s: cannot restart the EC cache thread\n",
+			   __func__);
+	mutex_unlock(&ec_cache_mutex);
+}
+EXPORT_SYMBOL_GPL(ec_cache_resume);
+
+/*
+ * Like ec_read(), but returns the cached value for registered registers.
+ */
+unsigned char ec_read_cached(unsigned short addr)
+{
+	struct ec_cache_entry *entry;
+	unsigned char value;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ec_lock, flags);
+	entry = ec_cache_lookup(addr);
+	if (entry)
+		value = entry->val;
+	else
+		value = __ec_read(addr);
+	spin_unlock_irqrestore(&ec_lock, flags);
 
 	return value;
 }
-EXPORT_SYMBOL(ec_get_event_num);
+EXPORT_SYMBOL_GPL(ec_read_cached);
@@ -29,36 +29,48 @@
 
 /*
  * The generic i8259_irq() make the kernel hang on booting.  Since we cannot
- * get the irq via the IRR directly, we access the ISR instead.
+ * get the irq via an interrupt acknowledge cycle, we read the IRR instead.
+ *
+ * The IMRs are not read back, cached_irq_mask has the same and more: with
+ * lazy masking the irqs masked since the last interrupt are only masked
+ * there.  Those that came in anyway get masked in the hardware now, and
+ * -EAGAIN is returned if that was all there was to do.
  */
 int mach_i8259_irq(void)
 {
-	int irq, isr;
-
-	irq = -1;
-
-	if ((LOONGSON_INTISR & LOONGSON_INTEN) & LOONGSON_INT_BIT_INT0) {
-		spin_lock(&i8259A_lock);
-		isr = inb(PIC_MASTER_CMD) &
-			~inb(PIC_MASTER_IMR) & ~(1 << PIC_CASCADE_IR);
-		if (!isr)
-			isr = (inb(PIC_SLAVE_CMD) & ~inb(PIC_SLAVE_IMR)) << 8;
-		irq = ffs(isr) - 1;
-		if (unlikely(irq == 7)) {
-			/*
-			 * This may be a spurious interrupt.
-			 *
-			 * Read the interrupt status register (ISR). If the most
-			 * significant bit is not set then there is no valid
-			 * interrupt.
-			 */
-			outb(0x0B, PIC_MASTER_ISR);	/* ISR register */
-			if (~inb(PIC_MASTER_ISR) & 0x80)
-				irq = -1;
-		}
-		spin_unlock(&i8259A_lock);
+	unsigned int irr, pending;
+	int irq;
+
+	if (!((LOONGSON_INTISR & LOONGSON_INTEN) & LOONGSON_INT_BIT_INT0))
+		return -1;
+
+	spin_lock(&i8259A_lock);
+
+	irr = inb(PIC_MASTER_CMD);
+	if (irr & (1 << PIC_CASCADE_IR))
+		irr |= inb(PIC_SLAVE_CMD) << 8;
+	pending = irr & ~cached_irq_mask & ~(1 << PIC_CASCADE_IR);
+
+	irq = ffs(pending) - 1;
+	if (unlikely(irq == 7)) {
+		/*
+		 * This may be a spurious interrupt.
+		 *
+		 * Read the interrupt status register (ISR). If the most
+		 * significant bit is not set then there is no valid
+		 * interrupt.
+		 */
+		outb(0x0B, PIC_MASTER_ISR);	/* ISR register */
+		if (~inb(PIC_MASTER_ISR) & 0x80)
+			irq = -1;
+		outb(0x0A, PIC_MASTER_ISR);	/* back to the IRR register */
 	}
 
+	if (i8259A_mask_pending(irr) && irq < 0)
+		irq = -EAGAIN;
+
+	spin_unlock(&i8259A_lock);
+
 	return irq;
 }
 EXPORT_SYMBOL(mach_i8259_irq);
@@ -70,7 +82,7 @@ static void i8259_irqdispatch(void)
 	irq = mach_i8259_irq();
 	if (irq >= 0)
 		do_IRQ(irq);
-	else
+	else if (irq != -EAGAIN)
 		spurious_interrupt();
 }
 
@@ -124,6 +136,7 @@ void __init mach_init_irq(void)
 
 	/* Sets the first-level interrupt dispatcher. */
 	mips_cpu_irq_init();
+	i8259A_lazy_mask = 1;
 	init_i8259_irqs();
 	bonito_irq_init();
 
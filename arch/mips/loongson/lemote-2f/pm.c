@@ -106,11 +106,11 @@ int wakeup_loongson(void)
 		return 1;
 	else if (irq == SCI_IRQ_NUM) {
 		int ret, sci_event;
-		/* query the event number */
-		ret = ec_query_seq(CMD_GET_EVENT_NUM);
+		/* query the event number, interrupts are off here */
+		ret = ec_query_seq_atomic(CMD_GET_EVENT_NUM);
 		if (ret < 0)
 			return 0;
-		sci_event = ec_get_event_num();
+		sci_event = ec_get_event_num_atomic();
 		if (sci_event < 0)
 			return 0;
 		if (sci_event == EVENT_LID) {
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2007 Lemote Inc. & Insititute of Computing Technology
+ * Author: Fuxin Zhang, zhangfx@lemote.com
+ *
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ * The Loongson 3 firmware passes the LEFI boot parameters instead of the
+ * PMON environment of the Loongson 2 machines; the command line is still
+ * handed over in the PMON way and taken care of by cmdline.c.
+ */
+#include <linux/module.h>
+
+#include <asm/bootinfo.h>
+
+#include <loongson.h>
+#include <boot_param.h>
+
+unsigned long cpu_clock_freq;
+EXPORT_SYMBOL(cpu_clock_freq);
+
+unsigned int loongson3_nr_cpus = 1;
+unsigned int loongson3_boot_core;
+
+struct efi_memory_map_loongson *loongson_memmap;
+struct efi_reset_system_t *loongson_reset_system;
+
+void __init prom_init_env(void)
+{
+	struct boot_params *boot_p;
+	struct loongson_params *lp;
+	struct efi_cpuinfo_loongson *ecpu;
+
+	/* firmware arguments are initialized in head.S */
+	boot_p = (struct boot_params *)fw_arg2;
+	loongson_reset_system = &boot_p->reset_system;
+
+	lp = &boot_p->efi.smbios.lp;
+	loongson_memmap = (struct efi_memory_map_loongson *)
+		((u64)lp + lp->memory_offset);
+	ecpu = (struct efi_cpuinfo_loongson *)((u64)lp + lp->cpu_offset);
+
+	cpu_clock_freq = ecpu->cpu_clock_freq;
+	if (cpu_clock_freq == 0)
+		cpu_clock_freq = 800000000;
+
+	loongson3_boot_core = ecpu->cpu_startup_core_id;
+	loongson3_nr_cpus = ecpu->nr_cpus;
+	if (loongson3_nr_cpus == 0 || loongson3_nr_cpus > NR_CPUS)
+		loongson3_nr_cpus = NR_CPUS;
+
+	pr_info("cpuclock=%ld, nr_cpus=%d, boot core=%d, nr_map=%d\n",
+		cpu_clock_freq, loongson3_nr_cpus, loongson3_boot_core,
+		loongson_memmap->nr_map);
+}
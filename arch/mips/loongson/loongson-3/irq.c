@@ -0,0 +1,54 @@
+/*
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ */
+#include <linux/interrupt.h>
+
+#include <asm/irq_cpu.h>
+
+#include <loongson.h>
+
+/*
+ * Every core has its own count/compare timer on IP7 and gets the IPIs on
+ * IP6.  The I/O interrupts all go through the interrupt router, which
+ * sends the ones used here to IP2 of core 0.
+ */
+asmlinkage void plat_irq_dispatch(void)
+{
+	unsigned int pending;
+
+	pending = read_c0_cause() & read_c0_status() & ST0_IM;
+
+	if (pending & CAUSEF_IP7)
+		do_IRQ(MIPS_CPU_IRQ_BASE + 7);
+#ifdef CONFIG_SMP
+	else if (pending & CAUSEF_IP6)
+		loongson3_ipi_interrupt();
+#endif
+	else if (pending & CAUSEF_IP2)
+		do_IRQ(LOONGSON3_UART_IRQ);
+	else
+		spurious_interrupt();
+}
+
+void __init arch_init_irq(void)
+{
+	clear_c0_status(ST0_IM | ST0_BEV);
+
+	mips_cpu_irq_init();
+
+	/* route the serial port and the LPC interrupts to core 0 */
+	LOONGSON3_REG(LOONGSON3_INT_ENCLR) = 0xffffffff;
+	LOONGSON3_REG8(LOONGSON3_INT_ROUTE(LOONGSON3_UART_INT)) =
+		LOONGSON3_INT_ROUTE_CORE0_IP2;
+	LOONGSON3_REG8(LOONGSON3_INT_ROUTE(LOONGSON3_LPC_INT)) =
+		LOONGSON3_INT_ROUTE_CORE0_IP2;
+	LOONGSON3_REG(LOONGSON3_INT_ENSET) =
+		(1 << LOONGSON3_UART_INT) | (1 << LOONGSON3_LPC_INT);
+
+#ifdef CONFIG_SMP
+	set_c0_status(STATUSF_IP6);
+#endif
+}
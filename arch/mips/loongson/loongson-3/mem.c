@@ -0,0 +1,51 @@
+/*
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ */
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/numa.h>
+
+#include <asm/bootinfo.h>
+
+#include <loongson.h>
+#include <boot_param.h>
+
+/*
+ * The firmware describes the memory of every node; the node number is
+ * also part of the physical address.  The memory of the other nodes is
+ * far above that of node 0, so it is only used with NUMA support, which
+ * gives every node its own bootmem allocator.
+ */
+void __init prom_init_memory(void)
+{
+	struct efi_memory_map_loongson *emap = loongson_memmap;
+	int i;
+
+	for (i = 0; i < emap->nr_map; i++) {
+		u32 node_id = emap->map[i].node_id;
+		u64 start = emap->map[i].mem_start;
+		u64 size = (u64)emap->map[i].mem_size << 20;
+
+		if (node_id >= MAX_NUMNODES) {
+			pr_info("skipping %lluMB at 0x%llx on node %u, "
+				"only %d node(s) supported\n",
+				size >> 20, start, node_id, MAX_NUMNODES);
+			continue;
+		}
+
+		start |= loongson3_nid_to_pa(node_id);
+
+		switch (emap->map[i].mem_type) {
+		case SYSTEM_RAM_LOW:
+		case SYSTEM_RAM_HIGH:
+			add_memory_region(start, size, BOOT_MEM_RAM);
+			break;
+		case MEM_RESERVED:
+			add_memory_region(start, size, BOOT_MEM_RESERVED);
+			break;
+		}
+	}
+}
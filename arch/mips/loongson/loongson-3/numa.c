@@ -0,0 +1,163 @@
+/*
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ * NUMA support of the Loongson 3.
+ *
+ * Every chip is a node with its own memory controllers, cores and
+ * configuration registers; the node number is in bits 44 and up of the
+ * physical address, so the memory of the nodes is far apart and every
+ * node gets a bootmem allocator of its own.
+ */
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <linux/mmzone.h>
+#include <linux/module.h>
+#include <linux/nodemask.h>
+#include <linux/swap.h>
+#include <linux/bootmem.h>
+#include <linux/pfn.h>
+#include <linux/highmem.h>
+
+#include <asm/bootinfo.h>
+#include <asm/dma.h>
+#include <asm/page.h>
+#include <asm/pgalloc.h>
+#include <asm/sections.h>
+
+#include <loongson.h>
+
+struct pglist_data __node_data[MAX_NUMNODES];
+EXPORT_SYMBOL(__node_data);
+
+unsigned char __cpu_to_node[NR_CPUS];
+EXPORT_SYMBOL(__cpu_to_node);
+
+struct cpumask __node_cpumask[MAX_NUMNODES];
+EXPORT_SYMBOL(__node_cpumask);
+
+void __cpuinit loongson3_numa_add_cpu(int cpu, int core)
+{
+	int node = loongson3_core_to_nid(core);
+
+	/* the cores of a chip without memory are given to node 0 */
+	if (!node_online(node))
+		node = 0;
+
+	__cpu_to_node[cpu] = node;
+	cpumask_set_cpu(cpu, &__node_cpumask[node]);
+}
+
+static void __init node_mem_init(int node, unsigned long reserved_end)
+{
+	unsigned long start_pfn, end_pfn, mapstart, bootmap_size;
+
+	get_pfn_range_for_nid(node, &start_pfn, &end_pfn);
+
+	NODE_DATA(node)->bdata = &bootmem_node_data[node];
+	NODE_DATA(node)->node_start_pfn = start_pfn;
+	NODE_DATA(node)->node_spanned_pages = end_pfn - start_pfn;
+
+	/*
+	 * The kernel and the initrd are on node 0, its bootmap goes right
+	 * behind them and nothing below is handed out, as without NUMA.
+	 */
+	mapstart = start_pfn;
+	if (reserved_end > start_pfn && reserved_end < end_pfn)
+		mapstart = reserved_end;
+
+	bootmap_size = init_bootmem_node(NODE_DATA(node), mapstart,
+					 start_pfn, end_pfn);
+	free_bootmem_with_active_regions(node, end_pfn);
+	reserve_bootmem_node(NODE_DATA(node), PFN_PHYS(start_pfn),
+			     PFN_PHYS(mapstart - start_pfn) + bootmap_size,
+			     BOOTMEM_DEFAULT);
+	sparse_memory_present_with_active_regions(node);
+}
+
+void __init plat_bootmem_init(unsigned long reserved_end)
+{
+	int i, node;
+
+	min_low_pfn = ARCH_PFN_OFFSET;
+	max_low_pfn = 0;
+
+	for (i = 0; i < boot_mem_map.nr_map; i++) {
+		unsigned long start, end;
+
+		if (boot_mem_map.map[i].type != BOOT_MEM_RAM)
+			continue;
+
+		start = PFN_UP(boot_mem_map.map[i].addr);
+		end = PFN_DOWN(boot_mem_map.map[i].addr
+				+ boot_mem_map.map[i].size);
+		if (start >= end)
+			continue;
+
+		node = loongson3_pa_to_nid(boot_mem_map.map[i].addr);
+		node_set_online(node);
+		add_active_range(node, start, end);
+
+		if (end > max_low_pfn)
+			max_low_pfn = end;
+	}
+	max_pfn = max_low_pfn;
+
+	for_each_online_node(node)
+		node_mem_init(node, reserved_end);
+
+	loongson3_numa_add_cpu(0, loongson3_boot_core);
+}
+
+extern unsigned long setup_zero_pages(void);
+
+void __init paging_init(void)
+{
+	unsigned long max_zone_pfns[MAX_NR_ZONES] = { 0, };
+
+	pagetable_init();
+
+#ifdef CONFIG_ZONE_DMA
+	max_zone_pfns[ZONE_DMA] = MAX_DMA_PFN;
+#endif
+#ifdef CONFIG_ZONE_DMA32
+	max_zone_pfns[ZONE_DMA32] = MAX_DMA32_PFN;
+#endif
+	max_zone_pfns[ZONE_NORMAL] = max_low_pfn;
+
+	free_area_init_nodes(max_zone_pfns);
+}
+
+void __init mem_init(void)
+{
+	unsigned long codesize, datasize, initsize, tmp;
+	int node;
+
+	high_memory = (void *) __va(max_low_pfn << PAGE_SHIFT);
+
+	num_physpages = 0;
+	for_each_online_node(node) {
+		totalram_pages += free_all_bootmem_node(NODE_DATA(node));
+		num_physpages += NODE_DATA(node)->node_present_pages;
+	}
+
+	totalram_pages -= setup_zero_pages();	/* This comes from node 0 */
+
+	codesize =  (unsigned long) &_etext - (unsigned long) &_text;
+	datasize =  (unsigned long) &_edata - (unsigned long) &_etext;
+	initsize =  (unsigned long) &__init_end - (unsigned long) &__init_begin;
+
+	tmp = nr_free_pages();
+	printk(KERN_INFO "Memory: %luk/%luk available (%ldk kernel code, "
+	       "%ldk reserved, %ldk data, %ldk init, %ldk highmem)\n",
+	       tmp << (PAGE_SHIFT-10),
+	       num_physpages << (PAGE_SHIFT-10),
+	       codesize >> 10,
+	       (num_physpages - tmp) << (PAGE_SHIFT-10),
+	       datasize >> 10,
+	       initsize >> 10,
+	       totalhigh_pages << (PAGE_SHIFT-10));
+}
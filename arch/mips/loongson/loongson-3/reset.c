@@ -0,0 +1,30 @@
+/*
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ */
+#include <linux/init.h>
+
+#include <loongson.h>
+#include <boot_param.h>
+
+/* The firmware provides the reset and power off entries */
+static void loongson3_firmware_call(u64 entry)
+{
+	if (entry)
+		((void (*)(void))(unsigned long)entry)();
+}
+
+void mach_prepare_reboot(void)
+{
+	loongson3_firmware_call(loongson_reset_system->ResetWarm);
+}
+
+void mach_prepare_shutdown(void)
+{
+	loongson3_firmware_call(loongson_reset_system->Shutdown);
+
+	while (1)
+		;
+}
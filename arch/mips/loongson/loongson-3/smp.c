@@ -0,0 +1,171 @@
+/*
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ * SMP support of the Loongson 3.
+ *
+ * Every core has a block of IPI registers: a status register with one bit
+ * per IPI, set and clear registers to raise and acknowledge them, and four
+ * mailboxes.  The firmware parks the secondary cores in a loop polling the
+ * first mailbox, and starts them at the address found there, with sp, gp
+ * and a1 taken from the other three.
+ */
+#include <linux/init.h>
+#include <linux/smp.h>
+#include <linux/kernel_stat.h>
+#include <linux/sched.h>
+
+#include <asm/mmu_context.h>
+#include <asm/smp-ops.h>
+
+#include <loongson.h>
+
+/* the IPI registers of a core are found in the register block of its node */
+#define ipi_off(core, x) \
+	LOONGSON3_IPI((core) % LOONGSON3_CORES_PER_NODE, x)
+#define ipi_reg(core, x) \
+	LOONGSON3_NODE_REG(loongson3_core_to_nid(core), ipi_off(core, x))
+#define ipi_mailbox(core, n) \
+	LOONGSON3_NODE_REG64(loongson3_core_to_nid(core), \
+			     ipi_off(core, LOONGSON3_IPI_MAILBOX(n)))
+
+static void loongson3_send_ipi_single(int cpu, unsigned int action)
+{
+	ipi_reg(cpu_logical_map(cpu), LOONGSON3_IPI_SET) = action;
+}
+
+static void loongson3_send_ipi_mask(const struct cpumask *mask,
+				    unsigned int action)
+{
+	unsigned int i;
+
+	for_each_cpu(i, mask)
+		loongson3_send_ipi_single(i, action);
+}
+
+void loongson3_ipi_interrupt(void)
+{
+	int core = cpu_logical_map(smp_processor_id());
+	unsigned int action;
+
+	kstat_incr_irqs_this_cpu(LOONGSON3_IPI_IRQ,
+				 irq_to_desc(LOONGSON3_IPI_IRQ));
+
+	/* Load the IPI status to figure out what we're supposed to do */
+	action = ipi_reg(core, LOONGSON3_IPI_STATUS);
+
+	/* Clear the IPIs to clear the interrupt */
+	ipi_reg(core, LOONGSON3_IPI_CLEAR) = action;
+
+	/*
+	 * Nothing to do for SMP_RESCHEDULE_YOURSELF; returning from the
+	 * interrupt will do the reschedule for us
+	 */
+
+	if (action & SMP_CALL_FUNCTION)
+		smp_call_function_interrupt();
+}
+
+static void __cpuinit loongson3_ipi_init(int core)
+{
+	ipi_reg(core, LOONGSON3_IPI_CLEAR) = 0xffffffff;
+	ipi_reg(core, LOONGSON3_IPI_EN) = 0xffffffff;
+}
+
+/*
+ * Code to run on secondary just after probing the CPU; the count/compare
+ * timer of the core has already been set up by start_secondary().
+ */
+static void __cpuinit loongson3_init_secondary(void)
+{
+	int core = cpu_logical_map(smp_processor_id());
+
+	loongson3_ipi_init(core);
+
+	/* Set interrupt mask, but don't enable */
+	change_c0_status(ST0_IM, STATUSF_IP6 | STATUSF_IP7);
+}
+
+/*
+ * Do any tidying up before marking online and running the idle
+ * loop
+ */
+static void __cpuinit loongson3_smp_finish(void)
+{
+	int core = cpu_logical_map(smp_processor_id());
+
+	/* Keep the core from starting again if the mailbox is looked at */
+	ipi_mailbox(core, 0) = 0;
+
+	local_irq_enable();
+}
+
+/*
+ * Final cleanup after all secondaries booted
+ */
+static void loongson3_cpus_done(void)
+{
+}
+
+/*
+ * Setup the PC, SP, and GP of a secondary processor and start it
+ * running!
+ */
+static void __cpuinit loongson3_boot_secondary(int cpu,
+					       struct task_struct *idle)
+{
+	int core = cpu_logical_map(cpu);
+
+	pr_debug("Booting CPU#%d (core %d)...\n", cpu, core);
+
+	ipi_mailbox(core, 3) = 0;
+	ipi_mailbox(core, 2) = (unsigned long)task_thread_info(idle);
+	ipi_mailbox(core, 1) = __KSTK_TOS(idle);
+	wmb();
+	ipi_mailbox(core, 0) = (unsigned long)&smp_bootstrap;
+	wmb();
+}
+
+/*
+ * The firmware tells how many cores are there and which one is booting;
+ * the boot core becomes CPU 0, the others follow in order.
+ *
+ * Common setup before any secondaries are started
+ */
+static void __init loongson3_smp_setup(void)
+{
+	int i, num;
+
+	cpus_clear(cpu_possible_map);
+	cpu_set(0, cpu_possible_map);
+	__cpu_number_map[loongson3_boot_core] = 0;
+	__cpu_logical_map[0] = loongson3_boot_core;
+
+	for (i = 0, num = 0; i < loongson3_nr_cpus; i++) {
+		if (i == loongson3_boot_core)
+			continue;
+		cpu_set(++num, cpu_possible_map);
+		__cpu_number_map[i] = num;
+		__cpu_logical_map[num] = i;
+		loongson3_numa_add_cpu(num, i);
+	}
+	pr_info("Detected %i available secondary CPU(s)\n", num);
+}
+
+static void __init loongson3_prepare_cpus(unsigned int max_cpus)
+{
+	loongson3_ipi_init(loongson3_boot_core);
+}
+
+struct plat_smp_ops loongson3_smp_ops = {
+	.send_ipi_single	= loongson3_send_ipi_single,
+	.send_ipi_mask		= loongson3_send_ipi_mask,
+	.init_secondary		= loongson3_init_secondary,
+	.smp_finish		= loongson3_smp_finish,
+	.cpus_done		= loongson3_cpus_done,
+	.boot_secondary		= loongson3_boot_secondary,
+	.smp_setup		= loongson3_smp_setup,
+	.prepare_cpus		= loongson3_prepare_cpus,
+};
@@ -0,0 +1,19 @@
+/*
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ */
+#include <asm/time.h>
+
+#include <loongson.h>
+
+/*
+ * Every core runs the count/compare timer set up by cevt-r4k on its own;
+ * there is no CMOS clock that can be safely reached yet, so the default
+ * read_persistent_clock() is used.
+ */
+void __init plat_time_init(void)
+{
+	mips_hpt_frequency = cpu_clock_freq / 2;
+}
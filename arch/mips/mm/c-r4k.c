@@ -55,7 +55,12 @@ static inline void r4k_on_each_cpu(void (*func) (void *info), void *info,
 	preempt_enable();
 }
 
-#if defined(CONFIG_MIPS_CMP)
+/*
+ * Index cacheops only act on the caches of the local core.  On Loongson 3
+ * the other cores may hold the same lines; hit cacheops are kept coherent
+ * by the hardware.
+ */
+#if defined(CONFIG_MIPS_CMP) || defined(CONFIG_CPU_LOONGSON3)
 #define cpu_has_safe_index_cacheops 0
 #else
 #define cpu_has_safe_index_cacheops 1
@@ -530,6 +535,10 @@ static void r4k_flush_cache_page(struct vm_area_struct *vma,
 {
 	struct flush_cache_page_args args;
 
+	/* Without aliases only the I-cache of executable mappings matters */
+	if (!cpu_has_dc_aliases && !(vma->vm_flags & VM_EXEC))
+		return;
+
 	args.vma = vma;
 	args.addr = addr;
 	args.pfn = pfn;
@@ -928,6 +937,33 @@ static void __cpuinit probe_pcache(void)
 		c->dcache.waybit = 0;
 		break;
 
+	case CPU_LOONGSON3:
+		/*
+		 * The primary caches are described in config1 like on
+		 * MIPS64 CPUs, but the way is selected by the low bits
+		 * of the index.
+		 */
+		config1 = read_c0_config1();
+
+		lsize = (config1 >> 19) & 7;
+		c->icache.linesz = lsize ? 2 << lsize : 0;
+		c->icache.sets = 64 << ((config1 >> 22) & 7);
+		c->icache.ways = 1 + ((config1 >> 16) & 7);
+		icache_size = c->icache.sets *
+		              c->icache.ways *
+		              c->icache.linesz;
+		c->icache.waybit = 0;
+
+		lsize = (config1 >> 10) & 7;
+		c->dcache.linesz = lsize ? 2 << lsize : 0;
+		c->dcache.sets = 64 << ((config1 >> 13) & 7);
+		c->dcache.ways = 1 + ((config1 >> 7) & 7);
+		dcache_size = c->dcache.sets *
+		              c->dcache.ways *
+		              c->dcache.linesz;
+		c->dcache.waybit = 0;
+		break;
+
 	default:
 		if (!(config & MIPS_CONF_M))
 			panic("Don't know how to probe P-caches on this cpu.");
@@ -1146,6 +1182,29 @@ static void __init loongson2_sc_init(void)
 }
 #endif
 
+#if defined(CONFIG_CPU_LOONGSON3)
+static void __init loongson3_sc_init(void)
+{
+	struct cpuinfo_mips *c = &current_cpu_data;
+	unsigned int config2, lsize;
+
+	config2 = read_c0_config2();
+	lsize = (config2 >> 4) & 15;
+	c->scache.linesz = lsize ? 2 << lsize : 0;
+	c->scache.sets = 64 << ((config2 >> 8) & 15);
+	c->scache.ways = 1 + (config2 & 15);
+	c->scache.waybit = 0;
+	c->scache.waysize = c->scache.sets * c->scache.linesz;
+
+	/* config2 describes one of the four banks shared by all cores */
+	scache_size = c->scache.sets * c->scache.ways * c->scache.linesz * 4;
+	pr_info("Unified secondary cache %ldkB %d-way, linesize %d bytes.\n",
+		scache_size >> 10, c->scache.ways, c->scache.linesz);
+
+	c->options |= MIPS_CPU_INCLUSIVE_CACHES;
+}
+#endif
+
 extern int r5k_sc_init(void);
 extern int rm7k_sc_init(void);
 extern int mips_sc_init(void);
@@ -1201,6 +1260,12 @@ static void __cpuinit setup_scache(void)
 		return;
 #endif
 
+#if defined(CONFIG_CPU_LOONGSON3)
+	case CPU_LOONGSON3:
+		loongson3_sc_init();
+		return;
+#endif
+
 	default:
 		if (c->isa_level == MIPS_CPU_ISA_M32R1 ||
 		    c->isa_level == MIPS_CPU_ISA_M32R2 ||
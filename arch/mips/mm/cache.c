@@ -6,6 +6,7 @@
  * Copyright (C) 1994 - 2003, 06, 07 by Ralf Baechle (ralf@linux-mips.org)
  * Copyright (C) 2007 MIPS Technologies, Inc.
  */
+#include <linux/debugfs.h>
 #include <linux/fs.h>
 #include <linux/fcntl.h>
 #include <linux/init.h>
@@ -72,6 +73,18 @@ SYSCALL_DEFINE3(cacheflush, unsigned long, addr, unsigned long, bytes,
 	return 0;
 }
 
+/*
+ * Page cache pages that are not mapped into user space only get marked
+ * PG_dcache_dirty here; __update_cache() does the flush once the page is
+ * faulted in, and only if the user address aliases the kernel one or the
+ * mapping is executable.  Writers hold the page lock like the fault path
+ * does, so page_mapped() cannot change under us.  Any user mapping that
+ * went away before was flushed by flush_cache_range() or
+ * flush_cache_page() at unmap time.
+ */
+static u32 dcache_flushes_deferred;
+static u32 dcache_flushes_avoided;
+
 void __flush_dcache_page(struct page *page)
 {
 	struct address_space *mapping = page_mapping(page);
@@ -79,8 +92,12 @@ void __flush_dcache_page(struct page *page)
 
 	if (PageHighMem(page))
 		return;
-	if (mapping && !mapping_mapped(mapping)) {
-		SetPageDcacheDirty(page);
+	if (mapping && (!mapping_mapped(mapping) || !page_mapped(page))) {
+		if (!Page_dcache_dirty(page)) {
+			SetPageDcacheDirty(page);
+			dcache_flushes_deferred++;
+		} else
+			dcache_flushes_avoided++;
 		return;
 	}
 
@@ -128,10 +145,33 @@ void __update_cache(struct vm_area_struct *vma, unsigned long address,
 		addr = (unsigned long) page_address(page);
 		if (exec || pages_do_alias(addr, address & PAGE_MASK))
 			flush_data_cache_page(addr);
+		else
+			dcache_flushes_avoided++;
 		ClearPageDcacheDirty(page);
 	}
 }
 
+#ifdef CONFIG_DEBUG_FS
+extern struct dentry *mips_debugfs_dir;
+static int __init debugfs_dcache_flushes(void)
+{
+	struct dentry *d;
+
+	if (!mips_debugfs_dir)
+		return -ENODEV;
+	d = debugfs_create_u32("dcache_flushes_deferred", S_IRUGO,
+			       mips_debugfs_dir, &dcache_flushes_deferred);
+	if (!d)
+		return -ENOMEM;
+	d = debugfs_create_u32("dcache_flushes_avoided", S_IRUGO,
+			       mips_debugfs_dir, &dcache_flushes_avoided);
+	if (!d)
+		return -ENOMEM;
+	return 0;
+}
+__initcall(debugfs_dcache_flushes);
+#endif
+
 unsigned long _page_cachable_default;
 EXPORT_SYMBOL_GPL(_page_cachable_default);
 
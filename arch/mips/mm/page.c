@@ -147,6 +147,23 @@ pg_addiu(u32 **buf, unsigned int reg1, unsigned int reg2, unsigned int off)
 	}
 }
 
+/*
+ * Loongson 2 has no pref instruction, but treats a load to $zero as a
+ * prefetch that does not stall the pipeline.  Unlike pref it faults like
+ * any other load, which is fine here as we never prefetch beyond the
+ * page being cleared or copied.
+ */
+#define cpu_has_ld_zero_prefetch()	(current_cpu_type() == CPU_LOONGSON2)
+
+static inline void __cpuinit
+build_pref(u32 **buf, unsigned int mode, int off, unsigned int reg)
+{
+	if (cpu_has_ld_zero_prefetch())
+		uasm_i_ld(buf, ZERO, off, reg);
+	else
+		uasm_i_pref(buf, mode, off, reg);
+}
+
 static void __cpuinit set_prefetch_parameters(void)
 {
 	if (cpu_has_64bit_gp_regs || cpu_has_64bit_zero_reg)
@@ -166,13 +183,23 @@ static void __cpuinit set_prefetch_parameters(void)
 	 * to make sense in terms of reducing cache pollution, but I've no real
 	 * performance data to back this up.
 	 */
-	if (cpu_has_prefetch) {
+	if (cpu_has_prefetch || cpu_has_ld_zero_prefetch()) {
 		/*
 		 * XXX: Most prefetch bias values in here are based on
 		 * guesswork.
 		 */
 		cache_line_size = cpu_dcache_line_size();
 		switch (current_cpu_type()) {
+		case CPU_LOONGSON2:
+			/*
+			 * Only a few lines ahead: the loads to $zero occupy
+			 * miss queue entries until the line arrives.
+			 */
+			pref_bias_clear_store = 128;
+			pref_bias_copy_load = 256;
+			pref_bias_copy_store = 128;
+			break;
+
 		case CPU_R5500:
 		case CPU_TX49XX:
 			/* These processors only support the Pref_Load. */
@@ -262,8 +289,8 @@ static inline void __cpuinit build_clear_pref(u32 **buf, int off)
 		return;
 
 	if (pref_bias_clear_store) {
-		uasm_i_pref(buf, pref_dst_mode, pref_bias_clear_store + off,
-			    A0);
+		build_pref(buf, pref_dst_mode, pref_bias_clear_store + off,
+			   A0);
 	} else if (cache_line_size == (half_clear_loop_size << 1)) {
 		if (cpu_has_cache_cdex_s) {
 			uasm_i_cache(buf, Create_Dirty_Excl_SD, off, A0);
@@ -395,7 +422,7 @@ static inline void build_copy_load_pref(u32 **buf, int off)
 		return;
 
 	if (pref_bias_copy_load)
-		uasm_i_pref(buf, pref_src_mode, pref_bias_copy_load + off, A1);
+		build_pref(buf, pref_src_mode, pref_bias_copy_load + off, A1);
 }
 
 static inline void build_copy_store_pref(u32 **buf, int off)
@@ -404,8 +431,8 @@ static inline void build_copy_store_pref(u32 **buf, int off)
 		return;
 
 	if (pref_bias_copy_store) {
-		uasm_i_pref(buf, pref_dst_mode, pref_bias_copy_store + off,
-			    A0);
+		build_pref(buf, pref_dst_mode, pref_bias_copy_store + off,
+			   A0);
 	} else if (cache_line_size == (half_copy_loop_size << 1)) {
 		if (cpu_has_cache_cdex_s) {
 			uasm_i_cache(buf, Create_Dirty_Excl_SD, off, A0);
@@ -13,6 +13,7 @@
 #include <linux/smp.h>
 #include <linux/mm.h>
 #include <linux/hugetlb.h>
+#include <linux/vmalloc.h>
 
 #include <asm/cpu.h>
 #include <asm/bootinfo.h>
@@ -50,7 +51,7 @@ extern void build_tlb_refill_handler(void);
 
 #endif /* CONFIG_MIPS_MT_SMTC */
 
-#if defined(CONFIG_CPU_LOONGSON2)
+#if defined(CONFIG_CPU_LOONGSON2) || defined(CONFIG_CPU_LOONGSON3)
 /*
  * LOONGSON2 has a 4 entry itlb which is a subset of dtlb,
  * unfortrunately, itlb is not totally transparent to software.
@@ -93,6 +94,25 @@ void local_flush_tlb_all(void)
 	write_c0_entryhi(old_ctx);
 	FLUSH_ITLB;
 	EXIT_CRITICAL(flags);
+	count_vm_tlb_event(NR_TLB_LOCAL_FLUSH_ALL);
+}
+
+/*
+ * Nothing is left in the TLB of a stale context, except when the mm is
+ * loaded here: then it may have lost its context to a flush on another
+ * CPU while still running with the ASID it had, and must get a new one.
+ * Returns non-zero if the TLB may still hold entries for the context.
+ */
+static int local_tlb_holds_mm(struct mm_struct *mm, int cpu)
+{
+	if (!cpu_context_stale(cpu, mm))
+		return 1;
+
+	if (cpumask_test_cpu(cpu, mm_cpumask(mm))) {
+		drop_mmu_context(mm, cpu);
+		count_vm_tlb_event(NR_TLB_FLUSH_ASID);
+	}
+	return 0;
 }
 
 /* All entries common to a mm share an asid.  To effectively flush
@@ -105,54 +125,78 @@ void local_flush_tlb_mm(struct mm_struct *mm)
 
 	cpu = smp_processor_id();
 
-	if (cpu_context(cpu, mm) != 0) {
+	if (local_tlb_holds_mm(mm, cpu)) {
 		drop_mmu_context(mm, cpu);
+		count_vm_tlb_event(NR_TLB_FLUSH_ASID);
 	}
 
 	preempt_enable();
 }
 
+/*
+ * Beyond these many even/odd page pairs, probing for the entries of a range
+ * one pair at a time costs more than giving the mm a new ASID, or flushing
+ * the whole TLB for kernel ranges, and refilling what was lost.  They start
+ * out at half the TLB size and are tuned at boot by tlb_tune_range_flush().
+ */
+static unsigned int tlb_range_pairs __read_mostly;
+static unsigned int tlb_kernel_range_pairs __read_mostly;
+
+/*
+ * Invalidate the entries for the page pairs from start to end which match
+ * asid or are global.  EntryHi is left for the caller to restore.
+ */
+static void local_flush_tlb_pairs(unsigned long start, unsigned long end,
+	int asid)
+{
+	unsigned long pairs = 0;
+
+	start &= (PAGE_MASK << 1);
+	end += ((PAGE_SIZE << 1) - 1);
+	end &= (PAGE_MASK << 1);
+	while (start < end) {
+		int idx;
+
+		write_c0_entryhi(start | asid);
+		start += (PAGE_SIZE << 1);
+		pairs++;
+		mtc0_tlbw_hazard();
+		tlb_probe();
+		tlb_probe_hazard();
+		idx = read_c0_index();
+		write_c0_entrylo0(0);
+		write_c0_entrylo1(0);
+		if (idx < 0)
+			continue;
+		/* Make sure all entries differ. */
+		write_c0_entryhi(UNIQUE_ENTRYHI(idx));
+		mtc0_tlbw_hazard();
+		tlb_write_indexed();
+	}
+	tlbw_use_hazard();
+	count_vm_tlb_events(NR_TLB_LOCAL_FLUSH_ONE, pairs);
+}
+
 void local_flush_tlb_range(struct vm_area_struct *vma, unsigned long start,
 	unsigned long end)
 {
 	struct mm_struct *mm = vma->vm_mm;
 	int cpu = smp_processor_id();
 
-	if (cpu_context(cpu, mm) != 0) {
+	if (local_tlb_holds_mm(mm, cpu)) {
 		unsigned long size, flags;
 
 		ENTER_CRITICAL(flags);
 		size = (end - start + (PAGE_SIZE - 1)) >> PAGE_SHIFT;
 		size = (size + 1) >> 1;
-		if (size <= current_cpu_data.tlbsize/2) {
+		if (size <= tlb_range_pairs) {
 			int oldpid = read_c0_entryhi();
-			int newpid = cpu_asid(cpu, mm);
-
-			start &= (PAGE_MASK << 1);
-			end += ((PAGE_SIZE << 1) - 1);
-			end &= (PAGE_MASK << 1);
-			while (start < end) {
-				int idx;
-
-				write_c0_entryhi(start | newpid);
-				start += (PAGE_SIZE << 1);
-				mtc0_tlbw_hazard();
-				tlb_probe();
-				tlb_probe_hazard();
-				idx = read_c0_index();
-				write_c0_entrylo0(0);
-				write_c0_entrylo1(0);
-				if (idx < 0)
-					continue;
-				/* Make sure all entries differ. */
-				write_c0_entryhi(UNIQUE_ENTRYHI(idx));
-				mtc0_tlbw_hazard();
-				tlb_write_indexed();
-			}
-			tlbw_use_hazard();
+
+			local_flush_tlb_pairs(start, end, cpu_asid(cpu, mm));
 			write_c0_entryhi(oldpid);
 		} else {
 			drop_mmu_context(mm, cpu);
+			count_vm_tlb_event(NR_TLB_FLUSH_ASID);
 		}
 		FLUSH_ITLB;
 		EXIT_CRITICAL(flags);
@@ -166,32 +210,10 @@ void local_flush_tlb_kernel_range(unsigned long start, unsigned long end)
 	ENTER_CRITICAL(flags);
 	size = (end - start + (PAGE_SIZE - 1)) >> PAGE_SHIFT;
 	size = (size + 1) >> 1;
-	if (size <= current_cpu_data.tlbsize / 2) {
+	if (size <= tlb_kernel_range_pairs) {
 		int pid = read_c0_entryhi();
 
-		start &= (PAGE_MASK << 1);
-		end += ((PAGE_SIZE << 1) - 1);
-		end &= (PAGE_MASK << 1);
-
-		while (start < end) {
-			int idx;
-
-			write_c0_entryhi(start);
-			start += (PAGE_SIZE << 1);
-			mtc0_tlbw_hazard();
-			tlb_probe();
-			tlb_probe_hazard();
-			idx = read_c0_index();
-			write_c0_entrylo0(0);
-			write_c0_entrylo1(0);
-			if (idx < 0)
-				continue;
-			/* Make sure all entries differ. */
-			write_c0_entryhi(UNIQUE_ENTRYHI(idx));
-			mtc0_tlbw_hazard();
-			tlb_write_indexed();
-		}
-		tlbw_use_hazard();
+		local_flush_tlb_pairs(start, end, 0);
 		write_c0_entryhi(pid);
 	} else {
 		local_flush_tlb_all();
@@ -204,7 +226,7 @@ void local_flush_tlb_page(struct vm_area_struct *vma, unsigned long page)
 {
 	int cpu = smp_processor_id();
 
-	if (cpu_context(cpu, vma->vm_mm) != 0) {
+	if (local_tlb_holds_mm(vma->vm_mm, cpu)) {
 		unsigned long flags;
 		int oldpid, newpid, idx;
 
@@ -519,5 +541,91 @@ void __cpuinit tlb_init(void)
 			printk("Ignoring invalid argument ntlb=%d\n", ntlb);
 	}
 
+	if (!tlb_range_pairs) {
+		tlb_range_pairs = current_cpu_data.tlbsize / 2;
+		tlb_kernel_range_pairs = current_cpu_data.tlbsize / 2;
+	}
+
 	build_tlb_refill_handler();
 }
+
+#define TLB_TUNE_PAIRS	8
+
+static unsigned int __init tlb_tune_touch(volatile char *p, int pairs)
+{
+	unsigned int start = read_c0_count();
+	int i;
+
+	for (i = 0; i < pairs; i++)
+		(void)p[i * (PAGE_SIZE << 1)];
+
+	return read_c0_count() - start;
+}
+
+/*
+ * Time with the count register what probing for a page pair costs, what
+ * refilling one costs and what flushing the whole TLB costs, using a few
+ * vmalloc()ed pages.  Giving the mm a new ASID costs nothing by itself
+ * but loses its entries, about half the TLB, and flushing all entries
+ * loses those of everybody else too; that is weighed against probing
+ * for every pair of the range.
+ */
+static int __init tlb_tune_range_flush(void)
+{
+	unsigned int tlbsize = current_cpu_data.tlbsize;
+	unsigned int hit, miss, probe, all, refill;
+	unsigned int range_pairs, kernel_range_pairs;
+	unsigned long flags, addr;
+	volatile char *p;
+	void *buf;
+	int pairs, pid;
+
+	pairs = min_t(int, TLB_TUNE_PAIRS, tlbsize / 4);
+	if (!cpu_has_counter || pairs < 1)
+		return 0;
+
+	buf = vmalloc((pairs + 1) * (PAGE_SIZE << 1));
+	if (!buf)
+		return -ENOMEM;
+	addr = ALIGN((unsigned long)buf, PAGE_SIZE << 1);
+	p = (volatile char *)addr;
+
+	/* Take any vmalloc faults before interrupts are off */
+	tlb_tune_touch(p, pairs);
+
+	ENTER_CRITICAL(flags);
+	tlb_tune_touch(p, pairs);
+	hit = tlb_tune_touch(p, pairs);
+
+	probe = read_c0_count();
+	pid = read_c0_entryhi();
+	local_flush_tlb_pairs(addr, addr + pairs * (PAGE_SIZE << 1) - 1, 0);
+	write_c0_entryhi(pid);
+	probe = read_c0_count() - probe;
+
+	miss = tlb_tune_touch(p, pairs);
+
+	all = read_c0_count();
+	local_flush_tlb_all();
+	all = read_c0_count() - all;
+	EXIT_CRITICAL(flags);
+
+	vfree(buf);
+
+	refill = miss > hit ? (miss - hit) / pairs : 1;
+	probe = max(probe / pairs, 1U);
+
+	range_pairs = refill * (tlbsize / 2) / probe;
+	kernel_range_pairs = (all + refill * (tlbsize / 2)) / probe;
+
+	tlb_range_pairs = clamp(range_pairs, tlbsize / 8, tlbsize * 2);
+	tlb_kernel_range_pairs = clamp(kernel_range_pairs, tlbsize / 8,
+				       tlbsize * 2);
+
+	pr_info("TLB range flush: probe %u, refill %u, flush all %u count "
+		"ticks; probing up to %u user/%u kernel page pairs\n",
+		probe, refill, all, tlb_range_pairs, tlb_kernel_range_pairs);
+
+	return 0;
+}
+arch_initcall(tlb_tune_range_flush);
@@ -322,6 +322,7 @@ static void __cpuinit build_tlb_write_entry(u32 **p, struct uasm_label **l,
 	case CPU_BCM3302:
 	case CPU_BCM4710:
 	case CPU_LOONGSON2:
+	case CPU_LOONGSON3:
 	case CPU_BCM6338:
 	case CPU_BCM6345:
 	case CPU_BCM6348:
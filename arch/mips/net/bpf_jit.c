@@ -0,0 +1,803 @@
+/*
+ * Just-In-Time compiler for BPF filters on MIPS64
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * The filter is compiled to a function of the kernel (n64) ABI, taking
+ * the skb in a0 and returning the length to keep in v0:
+ *
+ *	s0	skb
+ *	s1	A
+ *	s2	X
+ *	s3	skb->data
+ *	s4	skb_headlen(skb)
+ *
+ * A and X are kept sign extended, as the 32-bit instructions want them;
+ * the unsigned compares of BPF work on these just the same.  The scratch
+ * memory and the callee saved registers live in a stack frame.
+ *
+ * Packet loads from the linear data are done inline, byte by byte, which
+ * takes care of both the alignment and the network byte order.  The other
+ * ones, and most of the ancillary data, are left to sk_filter_load_slow().
+ * Anything else which can not be compiled makes the filter fall back to
+ * the interpreter.
+ */
+#include <linux/kernel.h>
+#include <linux/errno.h>
+#include <linux/filter.h>
+#include <linux/log2.h>
+#include <linux/moduleloader.h>
+#include <linux/netdevice.h>
+#include <linux/skbuff.h>
+#include <linux/slab.h>
+#include <linux/workqueue.h>
+
+#include <asm/cacheflush.h>
+
+int bpf_jit_enable __read_mostly;
+
+/* registers */
+#define r_zero		0
+#define r_at		1
+#define r_v0		2
+#define r_a0		4
+#define r_a1		5
+#define r_a2		6
+#define r_a3		7
+#define r_a4		8
+#define r_a5		9
+#define r_t0		12
+#define r_t1		13
+#define r_t2		14
+#define r_t3		15
+#define r_skb		16
+#define r_A		17
+#define r_X		18
+#define r_skb_data	19
+#define r_skb_hl	20
+#define r_t9		25
+#define r_sp		29
+#define r_ra		31
+
+/* the stack frame */
+#define FRAME_MEM	0			/* BPF_MEMWORDS words */
+#define FRAME_RES	(4 * BPF_MEMWORDS)	/* sk_filter_load_slow() result */
+#define FRAME_RA	(FRAME_RES + 8)
+#define FRAME_S(n)	(FRAME_RA + 8 + 8 * (n))	/* s0 - s4 */
+#define FRAME_SIZE	ALIGN(FRAME_S(5), 16)
+
+/* what the filter needs, sets the prologue and the epilogue */
+#define SEEN_SKB	(1 << 0)	/* skb kept in s0 */
+#define SEEN_X		(1 << 1)
+#define SEEN_DATA	(1 << 2)	/* data and headlen kept in s3, s4 */
+#define SEEN_CALL	(1 << 3)	/* calls sk_filter_load_slow() */
+
+/* opcodes */
+#define OP_REGIMM	0x01
+#define OP_BEQ		0x04
+#define OP_BNE		0x05
+#define OP_ADDIU	0x09
+#define OP_ANDI		0x0c
+#define OP_ORI		0x0d
+#define OP_LUI		0x0f
+#define OP_DADDIU	0x19
+#define OP_LBU		0x24
+#define OP_LW		0x23
+#define OP_SW		0x2b
+#define OP_LD		0x37
+#define OP_SD		0x3f
+
+#define RT_BLTZ		0x00
+
+#define FN_SLL		0x00
+#define FN_SRL		0x02
+#define FN_SLLV		0x04
+#define FN_SRLV		0x06
+#define FN_JR		0x08
+#define FN_JALR		0x09
+#define FN_MFLO		0x12
+#define FN_DSLL		0x38
+#define FN_MULTU	0x19
+#define FN_DIVU		0x1b
+#define FN_ADDU		0x21
+#define FN_SUBU		0x23
+#define FN_AND		0x24
+#define FN_OR		0x25
+#define FN_SLTU		0x2b
+#define FN_DADDU	0x2d
+
+#define I_TYPE(op, rs, rt, imm) \
+	(((u32)(op) << 26) | ((rs) << 21) | ((rt) << 16) | ((imm) & 0xffff))
+#define R_TYPE(rs, rt, rd, sa, fn) \
+	(((rs) << 21) | ((rt) << 16) | ((rd) << 11) | ((sa) << 6) | (fn))
+
+struct jit_ctx {
+	const struct sk_filter *skf;
+	u32 *target;		/* NULL while sizing */
+	unsigned int idx;	/* next instruction, in words */
+	unsigned int *offsets;	/* where each BPF instruction starts */
+	unsigned int ret0;	/* loads v0 with 0 and falls in the epilogue */
+	unsigned int epilogue;
+	u32 seen;
+	int error;		/* a branch is out of range */
+};
+
+static inline void emit(u32 insn, struct jit_ctx *ctx)
+{
+	if (ctx->target)
+		ctx->target[ctx->idx] = insn;
+	ctx->idx++;
+}
+
+#define emit_addu(d, s, t, ctx)		emit(R_TYPE(s, t, d, 0, FN_ADDU), ctx)
+#define emit_subu(d, s, t, ctx)		emit(R_TYPE(s, t, d, 0, FN_SUBU), ctx)
+#define emit_daddu(d, s, t, ctx)	emit(R_TYPE(s, t, d, 0, FN_DADDU), ctx)
+#define emit_and(d, s, t, ctx)		emit(R_TYPE(s, t, d, 0, FN_AND), ctx)
+#define emit_or(d, s, t, ctx)		emit(R_TYPE(s, t, d, 0, FN_OR), ctx)
+#define emit_sltu(d, s, t, ctx)		emit(R_TYPE(s, t, d, 0, FN_SLTU), ctx)
+#define emit_move(d, s, ctx)		emit_daddu(d, s, r_zero, ctx)
+#define emit_sll(d, t, sa, ctx)		emit(R_TYPE(0, t, d, sa, FN_SLL), ctx)
+#define emit_srl(d, t, sa, ctx)		emit(R_TYPE(0, t, d, sa, FN_SRL), ctx)
+#define emit_dsll(d, t, sa, ctx)	emit(R_TYPE(0, t, d, sa, FN_DSLL), ctx)
+#define emit_sllv(d, t, s, ctx)		emit(R_TYPE(s, t, d, 0, FN_SLLV), ctx)
+#define emit_srlv(d, t, s, ctx)		emit(R_TYPE(s, t, d, 0, FN_SRLV), ctx)
+#define emit_jr(s, ctx)						\
+do {									\
+	emit_fix_jump(s, ctx);						\
+	emit(R_TYPE(s, 0, 0, 0, FN_JR), ctx);				\
+} while (0)
+#define emit_jalr(s, ctx)						\
+do {									\
+	emit_fix_jump(s, ctx);						\
+	emit(R_TYPE(s, 0, r_ra, 0, FN_JALR), ctx);			\
+} while (0)
+#define emit_addiu(t, s, imm, ctx)	emit(I_TYPE(OP_ADDIU, s, t, imm), ctx)
+#define emit_daddiu(t, s, imm, ctx)	emit(I_TYPE(OP_DADDIU, s, t, imm), ctx)
+#define emit_andi(t, s, imm, ctx)	emit(I_TYPE(OP_ANDI, s, t, imm), ctx)
+#define emit_ori(t, s, imm, ctx)	emit(I_TYPE(OP_ORI, s, t, imm), ctx)
+#define emit_lui(t, imm, ctx)		emit(I_TYPE(OP_LUI, 0, t, imm), ctx)
+#define emit_lbu(t, off, b, ctx)	emit(I_TYPE(OP_LBU, b, t, off), ctx)
+#define emit_lw(t, off, b, ctx)		emit(I_TYPE(OP_LW, b, t, off), ctx)
+#define emit_sw(t, off, b, ctx)		emit(I_TYPE(OP_SW, b, t, off), ctx)
+#define emit_ld(t, off, b, ctx)		emit(I_TYPE(OP_LD, b, t, off), ctx)
+#define emit_sd(t, off, b, ctx)		emit(I_TYPE(OP_SD, b, t, off), ctx)
+
+#ifdef CONFIG_CPU_LOONGSON2F
+/*
+ * The rest of the kernel is built with -mfix-loongson2f-nop and
+ * -mfix-loongson2f-jump for the errata of the 2F, so do as the assembler
+ * does: nops are "or at, at, zero", and the target of a jump register
+ * has bits 28 and 29 cleared, which keeps the speculative instruction
+ * fetches away from the I/O space.
+ */
+#define emit_nop(ctx)			emit_or(r_at, r_at, r_zero, ctx)
+
+static void emit_fix_jump(unsigned int s, struct jit_ctx *ctx)
+{
+	emit_lui(r_at, 0xcfff, ctx);
+	emit_ori(r_at, r_at, 0xffff, ctx);
+	emit_and(s, s, r_at, ctx);
+}
+#else
+#define emit_nop(ctx)			emit(0, ctx)
+
+static inline void emit_fix_jump(unsigned int s, struct jit_ctx *ctx)
+{
+}
+#endif
+
+/*
+ * Reading LO is followed by two instructions which do not write it, for
+ * the multiplication or division of the next BPF instruction.
+ */
+static void emit_mflo(unsigned int dst, struct jit_ctx *ctx)
+{
+	emit(R_TYPE(0, 0, dst, 0, FN_MFLO), ctx);
+	emit_nop(ctx);
+	emit_nop(ctx);
+}
+
+static void emit_multu(unsigned int dst, unsigned int src, struct jit_ctx *ctx)
+{
+	emit(R_TYPE(dst, src, 0, 0, FN_MULTU), ctx);
+	emit_mflo(dst, ctx);
+}
+
+static void emit_divu(unsigned int dst, unsigned int src, struct jit_ctx *ctx)
+{
+	emit(R_TYPE(dst, src, 0, 0, FN_DIVU), ctx);
+	emit_mflo(dst, ctx);
+}
+
+/* branch with a nop in its delay slot to the instruction at word @to */
+static void emit_bcond(unsigned int op, unsigned int rs, unsigned int rt,
+		       unsigned int to, struct jit_ctx *ctx)
+{
+	long off = (long)to - (ctx->idx + 1);
+
+	if (ctx->target && (off < -32768 || off > 32767))
+		ctx->error = 1;
+	emit(I_TYPE(op, rs, rt, off), ctx);
+	emit_nop(ctx);
+}
+
+/*
+ * A short forward branch within the code of one BPF instruction, the
+ * offset is filled in by fixup_branch() at its target.
+ */
+static unsigned int emit_bcond_fwd(unsigned int op, unsigned int rs,
+				   unsigned int rt, struct jit_ctx *ctx)
+{
+	unsigned int at = ctx->idx;
+
+	emit(I_TYPE(op, rs, rt, 0), ctx);
+	emit_nop(ctx);
+
+	return at;
+}
+
+static void fixup_branch(unsigned int at, struct jit_ctx *ctx)
+{
+	if (ctx->target)
+		ctx->target[at] |= (ctx->idx - (at + 1)) & 0xffff;
+}
+
+#define emit_beq(s, t, to, ctx)		emit_bcond(OP_BEQ, s, t, to, ctx)
+#define emit_bne(s, t, to, ctx)		emit_bcond(OP_BNE, s, t, to, ctx)
+#define emit_b(to, ctx)			emit_beq(r_zero, r_zero, to, ctx)
+
+/* loads a 32-bit constant, sign extended */
+static void emit_load_imm(unsigned int dst, u32 imm, struct jit_ctx *ctx)
+{
+	if ((s32)imm >= -32768 && (s32)imm <= 32767) {
+		emit_addiu(dst, r_zero, imm, ctx);
+	} else if (imm <= 0xffff) {
+		emit_ori(dst, r_zero, imm, ctx);
+	} else {
+		emit_lui(dst, imm >> 16, ctx);
+		if (imm & 0xffff)
+			emit_ori(dst, dst, imm & 0xffff, ctx);
+	}
+}
+
+static void emit_load_ptr(unsigned int dst, unsigned long addr,
+			  struct jit_ctx *ctx)
+{
+	if (addr == (unsigned long)(long)(s32)addr) {
+		emit_lui(dst, addr >> 16, ctx);
+		emit_ori(dst, dst, addr & 0xffff, ctx);
+		return;
+	}
+
+	emit_lui(dst, addr >> 48, ctx);
+	emit_ori(dst, dst, (addr >> 32) & 0xffff, ctx);
+	emit_dsll(dst, dst, 16, ctx);
+	emit_ori(dst, dst, (addr >> 16) & 0xffff, ctx);
+	emit_dsll(dst, dst, 16, ctx);
+	emit_ori(dst, dst, addr & 0xffff, ctx);
+}
+
+/*
+ * Loads @size bytes in network byte order from @off(@base) into @dst; the
+ * bytes are loaded one by one, the packet data need not be aligned.
+ */
+static void emit_load_bytes(unsigned int dst, unsigned int base, int off,
+			    unsigned int size, struct jit_ctx *ctx)
+{
+	switch (size) {
+	case 1:
+		emit_lbu(dst, off, base, ctx);
+		break;
+	case 2:
+		emit_lbu(r_t1, off, base, ctx);
+		emit_lbu(r_t2, off + 1, base, ctx);
+		emit_sll(r_t1, r_t1, 8, ctx);
+		emit_or(dst, r_t1, r_t2, ctx);
+		break;
+	case 4:
+		emit_lbu(r_t1, off, base, ctx);
+		emit_lbu(r_t2, off + 1, base, ctx);
+		emit_sll(r_t1, r_t1, 24, ctx);
+		emit_sll(r_t2, r_t2, 16, ctx);
+		emit_or(r_t1, r_t1, r_t2, ctx);
+		emit_lbu(r_t2, off + 2, base, ctx);
+		emit_sll(r_t2, r_t2, 8, ctx);
+		emit_or(r_t1, r_t1, r_t2, ctx);
+		emit_lbu(r_t2, off + 3, base, ctx);
+		emit_or(dst, r_t1, r_t2, ctx);
+		break;
+	}
+}
+
+/*
+ * Calls sk_filter_load_slow() for a load at the offset in a1, and returns
+ * 0 from the filter if it fails.
+ */
+static void emit_load_slow(unsigned int dst, unsigned int size,
+			   struct jit_ctx *ctx)
+{
+	ctx->seen |= SEEN_SKB | SEEN_CALL;
+
+	emit_move(r_a0, r_skb, ctx);
+	emit_addiu(r_a2, r_zero, size, ctx);
+	emit_move(r_a3, r_A, ctx);
+	emit_move(r_a4, (ctx->seen & SEEN_X) ? r_X : r_zero, ctx);
+	emit_daddiu(r_a5, r_sp, FRAME_RES, ctx);
+	emit_load_ptr(r_t9, (unsigned long)sk_filter_load_slow, ctx);
+	emit_jalr(r_t9, ctx);
+	emit_nop(ctx);
+	emit_bne(r_v0, r_zero, ctx->ret0, ctx);
+	emit_lw(dst, FRAME_RES, r_sp, ctx);
+}
+
+/* the ancillary data which are not worth a call */
+static int emit_load_ancillary(int k, struct jit_ctx *ctx)
+{
+	switch (k - SKF_AD_OFF) {
+	case SKF_AD_MARK:
+		BUILD_BUG_ON(FIELD_SIZEOF(struct sk_buff, mark) != 4);
+		ctx->seen |= SEEN_SKB;
+		emit_lw(r_A, offsetof(struct sk_buff, mark), r_skb, ctx);
+		return 0;
+	case SKF_AD_IFINDEX:
+		BUILD_BUG_ON(FIELD_SIZEOF(struct net_device, ifindex) != 4);
+		ctx->seen |= SEEN_SKB;
+		emit_ld(r_t0, offsetof(struct sk_buff, dev), r_skb, ctx);
+		emit_lw(r_A, offsetof(struct net_device, ifindex), r_t0, ctx);
+		return 0;
+	}
+
+	return -1;
+}
+
+/* BPF_LD|BPF_ABS and BPF_LDX|BPF_B|BPF_MSH */
+static void emit_load_abs(unsigned int dst, int k, unsigned int size,
+			  struct jit_ctx *ctx)
+{
+	unsigned int slow, done;
+
+	/* only the linear data is worth a fast path */
+	if (k < 0 || k > 0x7fff0000) {
+		emit_load_imm(r_a1, k, ctx);
+		emit_load_slow(dst, size, ctx);
+		return;
+	}
+
+	ctx->seen |= SEEN_DATA;
+
+	emit_load_imm(r_t0, k + size, ctx);
+	emit_sltu(r_t0, r_skb_hl, r_t0, ctx);
+	slow = emit_bcond_fwd(OP_BNE, r_t0, r_zero, ctx);
+	if (k + size - 1 <= 32767) {
+		emit_load_bytes(dst, r_skb_data, k, size, ctx);
+	} else {
+		emit_load_imm(r_t3, k, ctx);
+		emit_daddu(r_t3, r_skb_data, r_t3, ctx);
+		emit_load_bytes(dst, r_t3, 0, size, ctx);
+	}
+	done = emit_bcond_fwd(OP_BEQ, r_zero, r_zero, ctx);
+
+	fixup_branch(slow, ctx);
+	emit_load_imm(r_a1, k, ctx);
+	emit_load_slow(dst, size, ctx);
+	fixup_branch(done, ctx);
+}
+
+/* BPF_LD|BPF_IND: the offset is X + k */
+static void emit_load_ind(int k, unsigned int size, struct jit_ctx *ctx)
+{
+	unsigned int slow, slow2, done;
+
+	ctx->seen |= SEEN_X | SEEN_DATA;
+
+	if (k >= -32768 && k <= 32767) {
+		emit_addiu(r_a1, r_X, k, ctx);
+	} else {
+		emit_load_imm(r_t0, k, ctx);
+		emit_addu(r_a1, r_X, r_t0, ctx);
+	}
+
+	slow = emit_bcond_fwd(OP_REGIMM, r_a1, RT_BLTZ, ctx);
+	emit_daddiu(r_t0, r_a1, size, ctx);
+	emit_sltu(r_t0, r_skb_hl, r_t0, ctx);
+	slow2 = emit_bcond_fwd(OP_BNE, r_t0, r_zero, ctx);
+	emit_daddu(r_t3, r_skb_data, r_a1, ctx);
+	emit_load_bytes(r_A, r_t3, 0, size, ctx);
+	done = emit_bcond_fwd(OP_BEQ, r_zero, r_zero, ctx);
+
+	fixup_branch(slow, ctx);
+	fixup_branch(slow2, ctx);
+	emit_load_slow(r_A, size, ctx);
+	fixup_branch(done, ctx);
+}
+
+static void build_prologue(struct jit_ctx *ctx)
+{
+	emit_daddiu(r_sp, r_sp, -FRAME_SIZE, ctx);
+
+	if (ctx->seen & SEEN_CALL)
+		emit_sd(r_ra, FRAME_RA, r_sp, ctx);
+	if (ctx->seen & SEEN_SKB)
+		emit_sd(r_skb, FRAME_S(0), r_sp, ctx);
+	emit_sd(r_A, FRAME_S(1), r_sp, ctx);
+	if (ctx->seen & SEEN_X)
+		emit_sd(r_X, FRAME_S(2), r_sp, ctx);
+	if (ctx->seen & SEEN_DATA) {
+		emit_sd(r_skb_data, FRAME_S(3), r_sp, ctx);
+		emit_sd(r_skb_hl, FRAME_S(4), r_sp, ctx);
+	}
+
+	if (ctx->seen & SEEN_SKB)
+		emit_move(r_skb, r_a0, ctx);
+	if (ctx->seen & SEEN_DATA) {
+		emit_ld(r_skb_data, offsetof(struct sk_buff, data), r_a0, ctx);
+		emit_lw(r_t0, offsetof(struct sk_buff, len), r_a0, ctx);
+		emit_lw(r_t1, offsetof(struct sk_buff, data_len), r_a0, ctx);
+		emit_subu(r_skb_hl, r_t0, r_t1, ctx);
+	}
+
+	emit_move(r_A, r_zero, ctx);
+	if (ctx->seen & SEEN_X)
+		emit_move(r_X, r_zero, ctx);
+}
+
+static void build_epilogue(struct jit_ctx *ctx)
+{
+	ctx->ret0 = ctx->idx;
+	emit_move(r_v0, r_zero, ctx);
+
+	ctx->epilogue = ctx->idx;
+	if (ctx->seen & SEEN_CALL)
+		emit_ld(r_ra, FRAME_RA, r_sp, ctx);
+	if (ctx->seen & SEEN_SKB)
+		emit_ld(r_skb, FRAME_S(0), r_sp, ctx);
+	emit_ld(r_A, FRAME_S(1), r_sp, ctx);
+	if (ctx->seen & SEEN_X)
+		emit_ld(r_X, FRAME_S(2), r_sp, ctx);
+	if (ctx->seen & SEEN_DATA) {
+		emit_ld(r_skb_data, FRAME_S(3), r_sp, ctx);
+		emit_ld(r_skb_hl, FRAME_S(4), r_sp, ctx);
+	}
+	emit_jr(r_ra, ctx);
+	emit_daddiu(r_sp, r_sp, FRAME_SIZE, ctx);
+}
+
+/*
+ * A conditional jump: @cmp_op branches when the condition holds, @rs and
+ * @rt are what it compares.
+ */
+static void emit_jump(const struct sock_filter *inst, unsigned int i,
+		      unsigned int cmp_op, unsigned int rs, unsigned int rt,
+		      struct jit_ctx *ctx)
+{
+	unsigned int *offsets = ctx->offsets;
+	unsigned int inv_op = (cmp_op == OP_BEQ) ? OP_BNE : OP_BEQ;
+
+	if (inst->jt == inst->jf) {
+		if (inst->jt)
+			emit_b(offsets[i + 1 + inst->jt], ctx);
+	} else if (inst->jf == 0) {
+		emit_bcond(cmp_op, rs, rt, offsets[i + 1 + inst->jt], ctx);
+	} else if (inst->jt == 0) {
+		emit_bcond(inv_op, rs, rt, offsets[i + 1 + inst->jf], ctx);
+	} else {
+		emit_bcond(cmp_op, rs, rt, offsets[i + 1 + inst->jt], ctx);
+		emit_b(offsets[i + 1 + inst->jf], ctx);
+	}
+}
+
+static int build_body(struct jit_ctx *ctx)
+{
+	const struct sk_filter *prog = ctx->skf;
+	unsigned int i;
+
+	for (i = 0; i < prog->len; i++) {
+		const struct sock_filter *inst = &prog->insns[i];
+		u32 k = inst->k;
+		unsigned int src;
+
+		ctx->offsets[i] = ctx->idx;
+
+		switch (inst->code) {
+		case BPF_ALU|BPF_ADD|BPF_K:
+			if ((s32)k >= -32768 && (s32)k <= 32767) {
+				emit_addiu(r_A, r_A, k, ctx);
+			} else {
+				emit_load_imm(r_t0, k, ctx);
+				emit_addu(r_A, r_A, r_t0, ctx);
+			}
+			break;
+		case BPF_ALU|BPF_ADD|BPF_X:
+			ctx->seen |= SEEN_X;
+			emit_addu(r_A, r_A, r_X, ctx);
+			break;
+		case BPF_ALU|BPF_SUB|BPF_K:
+			if ((s32)k > -32768 && (s32)k <= 32768) {
+				emit_addiu(r_A, r_A, -k, ctx);
+			} else {
+				emit_load_imm(r_t0, k, ctx);
+				emit_subu(r_A, r_A, r_t0, ctx);
+			}
+			break;
+		case BPF_ALU|BPF_SUB|BPF_X:
+			ctx->seen |= SEEN_X;
+			emit_subu(r_A, r_A, r_X, ctx);
+			break;
+		case BPF_ALU|BPF_MUL|BPF_K:
+			emit_load_imm(r_t0, k, ctx);
+			emit_multu(r_A, r_t0, ctx);
+			break;
+		case BPF_ALU|BPF_MUL|BPF_X:
+			ctx->seen |= SEEN_X;
+			emit_multu(r_A, r_X, ctx);
+			break;
+		case BPF_ALU|BPF_DIV|BPF_K:
+			/* sk_chk_filter() refuses k == 0 */
+			if (k == 1)
+				break;
+			if (is_power_of_2(k)) {
+				emit_srl(r_A, r_A, ilog2(k), ctx);
+				break;
+			}
+			emit_load_imm(r_t0, k, ctx);
+			emit_divu(r_A, r_t0, ctx);
+			break;
+		case BPF_ALU|BPF_DIV|BPF_X:
+			ctx->seen |= SEEN_X;
+			emit_beq(r_X, r_zero, ctx->ret0, ctx);
+			emit_divu(r_A, r_X, ctx);
+			break;
+		case BPF_ALU|BPF_AND|BPF_K:
+			if (k <= 0xffff) {
+				emit_andi(r_A, r_A, k, ctx);
+			} else {
+				emit_load_imm(r_t0, k, ctx);
+				emit_and(r_A, r_A, r_t0, ctx);
+			}
+			break;
+		case BPF_ALU|BPF_AND|BPF_X:
+			ctx->seen |= SEEN_X;
+			emit_and(r_A, r_A, r_X, ctx);
+			break;
+		case BPF_ALU|BPF_OR|BPF_K:
+			if (k <= 0xffff) {
+				emit_ori(r_A, r_A, k, ctx);
+			} else {
+				emit_load_imm(r_t0, k, ctx);
+				emit_or(r_A, r_A, r_t0, ctx);
+			}
+			break;
+		case BPF_ALU|BPF_OR|BPF_X:
+			ctx->seen |= SEEN_X;
+			emit_or(r_A, r_A, r_X, ctx);
+			break;
+		case BPF_ALU|BPF_LSH|BPF_K:
+			emit_sll(r_A, r_A, k & 31, ctx);
+			break;
+		case BPF_ALU|BPF_LSH|BPF_X:
+			ctx->seen |= SEEN_X;
+			emit_sllv(r_A, r_A, r_X, ctx);
+			break;
+		case BPF_ALU|BPF_RSH|BPF_K:
+			emit_srl(r_A, r_A, k & 31, ctx);
+			break;
+		case BPF_ALU|BPF_RSH|BPF_X:
+			ctx->seen |= SEEN_X;
+			emit_srlv(r_A, r_A, r_X, ctx);
+			break;
+		case BPF_ALU|BPF_NEG:
+			emit_subu(r_A, r_zero, r_A, ctx);
+			break;
+
+		case BPF_JMP|BPF_JA:
+			if (k)
+				emit_b(ctx->offsets[i + 1 + k], ctx);
+			break;
+		case BPF_JMP|BPF_JEQ|BPF_K:
+		case BPF_JMP|BPF_JGT|BPF_K:
+		case BPF_JMP|BPF_JGE|BPF_K:
+		case BPF_JMP|BPF_JSET|BPF_K:
+			if (inst->jt == inst->jf) {
+				emit_jump(inst, i, OP_BEQ, r_zero, r_zero, ctx);
+				break;
+			}
+			src = r_zero;
+			if (k) {
+				emit_load_imm(r_t1, k, ctx);
+				src = r_t1;
+			}
+			goto cond_jump;
+		case BPF_JMP|BPF_JEQ|BPF_X:
+		case BPF_JMP|BPF_JGT|BPF_X:
+		case BPF_JMP|BPF_JGE|BPF_X:
+		case BPF_JMP|BPF_JSET|BPF_X:
+			ctx->seen |= SEEN_X;
+			if (inst->jt == inst->jf) {
+				emit_jump(inst, i, OP_BEQ, r_zero, r_zero, ctx);
+				break;
+			}
+			src = r_X;
+cond_jump:
+			switch (BPF_OP(inst->code)) {
+			case BPF_JEQ:
+				emit_jump(inst, i, OP_BEQ, r_A, src, ctx);
+				break;
+			case BPF_JGT:
+				/* A > src if src < A */
+				emit_sltu(r_t0, src, r_A, ctx);
+				emit_jump(inst, i, OP_BNE, r_t0, r_zero, ctx);
+				break;
+			case BPF_JGE:
+				/* A >= src unless A < src */
+				emit_sltu(r_t0, r_A, src, ctx);
+				emit_jump(inst, i, OP_BEQ, r_t0, r_zero, ctx);
+				break;
+			case BPF_JSET:
+				emit_and(r_t0, r_A, src, ctx);
+				emit_jump(inst, i, OP_BNE, r_t0, r_zero, ctx);
+				break;
+			}
+			break;
+
+		case BPF_LD|BPF_W|BPF_ABS:
+		case BPF_LD|BPF_H|BPF_ABS:
+		case BPF_LD|BPF_B|BPF_ABS:
+			if ((int)k >= SKF_AD_OFF && (int)k < 0 &&
+			    emit_load_ancillary(k, ctx) == 0)
+				break;
+			emit_load_abs(r_A, k, BPF_SIZE(inst->code) == BPF_W ? 4 :
+				      BPF_SIZE(inst->code) == BPF_H ? 2 : 1, ctx);
+			break;
+		case BPF_LD|BPF_W|BPF_IND:
+		case BPF_LD|BPF_H|BPF_IND:
+		case BPF_LD|BPF_B|BPF_IND:
+			emit_load_ind(k, BPF_SIZE(inst->code) == BPF_W ? 4 :
+				      BPF_SIZE(inst->code) == BPF_H ? 2 : 1, ctx);
+			break;
+		case BPF_LDX|BPF_B|BPF_MSH:
+			ctx->seen |= SEEN_X;
+			/* no ancillary data here, the interpreter returns 0 */
+			if ((int)k >= SKF_AD_OFF && (int)k < 0) {
+				emit_b(ctx->ret0, ctx);
+				break;
+			}
+			emit_load_abs(r_X, k, 1, ctx);
+			emit_andi(r_X, r_X, 0xf, ctx);
+			emit_sll(r_X, r_X, 2, ctx);
+			break;
+		case BPF_LD|BPF_W|BPF_LEN:
+			ctx->seen |= SEEN_SKB;
+			emit_lw(r_A, offsetof(struct sk_buff, len), r_skb, ctx);
+			break;
+		case BPF_LDX|BPF_W|BPF_LEN:
+			ctx->seen |= SEEN_SKB | SEEN_X;
+			emit_lw(r_X, offsetof(struct sk_buff, len), r_skb, ctx);
+			break;
+		case BPF_LD|BPF_IMM:
+			emit_load_imm(r_A, k, ctx);
+			break;
+		case BPF_LDX|BPF_IMM:
+			ctx->seen |= SEEN_X;
+			emit_load_imm(r_X, k, ctx);
+			break;
+		case BPF_LD|BPF_MEM:
+			emit_lw(r_A, FRAME_MEM + 4 * k, r_sp, ctx);
+			break;
+		case BPF_LDX|BPF_MEM:
+			ctx->seen |= SEEN_X;
+			emit_lw(r_X, FRAME_MEM + 4 * k, r_sp, ctx);
+			break;
+		case BPF_ST:
+			emit_sw(r_A, FRAME_MEM + 4 * k, r_sp, ctx);
+			break;
+		case BPF_STX:
+			ctx->seen |= SEEN_X;
+			emit_sw(r_X, FRAME_MEM + 4 * k, r_sp, ctx);
+			break;
+		case BPF_MISC|BPF_TAX:
+			ctx->seen |= SEEN_X;
+			emit_move(r_X, r_A, ctx);
+			break;
+		case BPF_MISC|BPF_TXA:
+			ctx->seen |= SEEN_X;
+			emit_move(r_A, r_X, ctx);
+			break;
+
+		case BPF_RET|BPF_K:
+			emit_load_imm(r_v0, k, ctx);
+			emit_b(ctx->epilogue, ctx);
+			break;
+		case BPF_RET|BPF_A:
+			emit_move(r_v0, r_A, ctx);
+			emit_b(ctx->epilogue, ctx);
+			break;
+
+		default:
+			/* leave it to the interpreter */
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+void bpf_jit_compile(struct sk_filter *fp)
+{
+	struct jit_ctx ctx;
+	unsigned int size;
+	int pass;
+
+	if (!bpf_jit_enable)
+		return;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.skf = fp;
+	ctx.offsets = kcalloc(fp->len, sizeof(*ctx.offsets), GFP_KERNEL);
+	if (ctx.offsets == NULL)
+		return;
+
+	/*
+	 * The first pass finds out what the filter needs, which sets the
+	 * size of the prologue, the second one where everything goes.
+	 * Nothing depends on the branch offsets, so that is final.
+	 */
+	for (pass = 0; pass < 2; pass++) {
+		ctx.idx = 0;
+		build_prologue(&ctx);
+		if (build_body(&ctx))
+			goto out;
+		build_epilogue(&ctx);
+	}
+
+	/* it becomes a work_struct once freed, see bpf_jit_free() */
+	size = max_t(unsigned int, ctx.idx * 4, sizeof(struct work_struct));
+	ctx.target = module_alloc(size);
+	if (ctx.target == NULL)
+		goto out;
+
+	ctx.idx = 0;
+	build_prologue(&ctx);
+	build_body(&ctx);
+	build_epilogue(&ctx);
+
+	if (ctx.error) {
+		module_free(NULL, ctx.target);
+		goto out;
+	}
+
+	flush_icache_range((unsigned long)ctx.target,
+			   (unsigned long)&ctx.target[ctx.idx]);
+
+	if (bpf_jit_enable > 1) {
+		pr_err("flen=%d proglen=%u image=%p\n",
+		       fp->len, ctx.idx * 4, ctx.target);
+		print_hex_dump(KERN_ERR, "JIT code: ", DUMP_PREFIX_ADDRESS,
+			       16, 4, ctx.target, ctx.idx * 4, false);
+	}
+
+	fp->bpf_func = (void *)ctx.target;
+out:
+	kfree(ctx.offsets);
+}
+
+static void bpf_jit_free_worker(struct work_struct *work)
+{
+	module_free(NULL, work);
+}
+
+/*
+ * Called when the last reference to the filter goes away, which may be
+ * from an RCU callback, where the image can not be vfree()d.
+ */
+void bpf_jit_free(struct sk_filter *fp)
+{
+	if (fp->bpf_func != sk_run_filter) {
+		struct work_struct *work = (struct work_struct *)fp->bpf_func;
+
+		INIT_WORK(work, bpf_jit_free_worker);
+		schedule_work(work);
+	}
+}
@@ -0,0 +1,179 @@
+/*
+ * User space clock_gettime() and gettimeofday() for the MIPS vDSO.
+ *
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ *
+ * The kernel keeps a copy of its timekeeping state in the vDSO data page.
+ * When the clocksource is the count register and user mode may read it
+ * with rdhwr, the high resolution clocks are computed right here; the
+ * coarse clocks only need the data page.  Anything else is passed on to
+ * the real system call.
+ */
+
+#include <linux/compiler.h>
+#include <linux/time.h>
+#include <linux/seqlock.h>
+
+#include <asm/page.h>
+#include <asm/unistd.h>
+#include <asm/vdso.h>
+#include <asm/vdso_datapage.h>
+
+/* The image is prelinked right above its data page */
+static __always_inline const struct vdso_data *get_vdso_data(void)
+{
+	return (const struct vdso_data *)VDSO_BASE;
+}
+
+static __always_inline long syscall2(long nr, long arg0, long arg1)
+{
+	register long a0 asm("a0") = arg0;
+	register long a1 asm("a1") = arg1;
+	register long v0 asm("v0") = nr;
+	register long a3 asm("a3");
+
+	asm volatile(
+	"	syscall					\n"
+	: "+r" (v0), "=r" (a3)
+	: "r" (a0), "r" (a1)
+	: "$1", "$3", "$8", "$9", "$10", "$11", "$12", "$13", "$14",
+	  "$15", "$24", "$25", "hi", "lo", "memory");
+
+	return a3 ? -v0 : v0;
+}
+
+static __always_inline u32 read_r4k_count(void)
+{
+	u32 count;
+
+	__asm__ __volatile__(
+	"	.set	push				\n"
+	"	.set	mips32r2			\n"
+	"	rdhwr	%0, $2				\n"
+	"	.set	pop				\n"
+	: "=r" (count));
+
+	return count;
+}
+
+static __always_inline u64 vgetns(const struct vdso_data *vd)
+{
+	u64 cycles = (read_r4k_count() - vd->cycle_last) & vd->mask;
+
+	return (cycles * vd->mult) >> vd->shift;
+}
+
+static __always_inline int do_realtime(const struct vdso_data *vd,
+				       struct timespec *ts)
+{
+	unsigned seq;
+	u64 ns;
+
+	do {
+		seq = read_seqcount_begin(&vd->seq);
+		if (vd->clock_mode != VDSO_CLOCK_R4K)
+			return -1;
+		ts->tv_sec = vd->xtime_sec;
+		ns = vd->xtime_nsec + vgetns(vd);
+	} while (read_seqcount_retry(&vd->seq, seq));
+
+	ts->tv_nsec = 0;
+	timespec_add_ns(ts, ns);
+	return 0;
+}
+
+static __always_inline int do_monotonic(const struct vdso_data *vd,
+					struct timespec *ts)
+{
+	unsigned seq;
+	u64 ns;
+
+	do {
+		seq = read_seqcount_begin(&vd->seq);
+		if (vd->clock_mode != VDSO_CLOCK_R4K)
+			return -1;
+		ts->tv_sec = vd->xtime_sec + vd->wtm_sec;
+		ns = vd->xtime_nsec + vd->wtm_nsec + vgetns(vd);
+	} while (read_seqcount_retry(&vd->seq, seq));
+
+	ts->tv_nsec = 0;
+	timespec_add_ns(ts, ns);
+	return 0;
+}
+
+static __always_inline void do_realtime_coarse(const struct vdso_data *vd,
+					       struct timespec *ts)
+{
+	unsigned seq;
+
+	do {
+		seq = read_seqcount_begin(&vd->seq);
+		ts->tv_sec = vd->xtime_sec;
+		ts->tv_nsec = vd->xtime_nsec;
+	} while (read_seqcount_retry(&vd->seq, seq));
+}
+
+static __always_inline void do_monotonic_coarse(const struct vdso_data *vd,
+						struct timespec *ts)
+{
+	unsigned seq;
+	u64 ns;
+
+	do {
+		seq = read_seqcount_begin(&vd->seq);
+		ts->tv_sec = vd->xtime_sec + vd->wtm_sec;
+		ns = vd->xtime_nsec + vd->wtm_nsec;
+	} while (read_seqcount_retry(&vd->seq, seq));
+
+	ts->tv_nsec = 0;
+	timespec_add_ns(ts, ns);
+}
+
+int __vdso_clock_gettime(clockid_t clock, struct timespec *ts)
+{
+	const struct vdso_data *vd = get_vdso_data();
+
+	switch (clock) {
+	case CLOCK_REALTIME:
+		if (!do_realtime(vd, ts))
+			return 0;
+		break;
+	case CLOCK_MONOTONIC:
+		if (!do_monotonic(vd, ts))
+			return 0;
+		break;
+	case CLOCK_REALTIME_COARSE:
+		do_realtime_coarse(vd, ts);
+		return 0;
+	case CLOCK_MONOTONIC_COARSE:
+		do_monotonic_coarse(vd, ts);
+		return 0;
+	}
+
+	return syscall2(__NR_clock_gettime, clock, (long)ts);
+}
+int clock_gettime(clockid_t, struct timespec *)
+	__attribute__((weak, alias("__vdso_clock_gettime")));
+
+int __vdso_gettimeofday(struct timeval *tv, struct timezone *tz)
+{
+	const struct vdso_data *vd = get_vdso_data();
+	struct timespec ts;
+
+	if (likely(tv != NULL)) {
+		if (do_realtime(vd, &ts))
+			return syscall2(__NR_gettimeofday, (long)tv, (long)tz);
+		tv->tv_sec = ts.tv_sec;
+		tv->tv_usec = ts.tv_nsec / NSEC_PER_USEC;
+	}
+	if (unlikely(tz != NULL)) {
+		tz->tz_minuteswest = vd->tz_minuteswest;
+		tz->tz_dsttime = vd->tz_dsttime;
+	}
+
+	return 0;
+}
+int gettimeofday(struct timeval *, struct timezone *)
+	__attribute__((weak, alias("__vdso_gettimeofday")));
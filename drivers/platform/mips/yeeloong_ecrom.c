@@ -834,7 +834,9 @@ static int misc_ioctl(struct inode *inode, struct file *filp, u_int cmd,
 		}
 
 		/* use ec_program_rom to write serial No */
+		ec_cache_pause();
 		ec_program_rom(&ecinfo, PROGRAM_FLAG_IE);
+		ec_cache_resume();
 
 		kfree(ecinfo.buf);
 		ecinfo.buf = NULL;
@@ -862,7 +864,10 @@ static int misc_ioctl(struct inode *inode, struct file *filp, u_int cmd,
 			return -EFAULT;
 		}
 
+		/* the EC must not be polled while it is being flashed */
+		ec_cache_pause();
 		ec_program_rom(&ecinfo, PROGRAM_FLAG_ROM);
+		ec_cache_resume();
 
 		kfree(ecinfo.buf);
 		ecinfo.buf = NULL;
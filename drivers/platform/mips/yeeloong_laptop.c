@@ -130,7 +130,7 @@ static int yeeloong_get_ac_props(struct power_supply *psy,
 {
 	switch (psp) {
 	case POWER_SUPPLY_PROP_ONLINE:
-		val->intval = ((ec_read(REG_BAT_POWER)) & BIT_BAT_POWER_ACIN) ?
+		val->intval = ((ec_read_cached(REG_BAT_POWER)) & BIT_BAT_POWER_ACIN) ?
 			AC_ONLINE : AC_OFFLINE;
 		break;
 	default:
@@ -156,15 +156,15 @@ static struct power_supply yeeloong_ac = {
 #define BAT_CAP_HIGH     99
 
 #define get_bat_info(type) \
-	((ec_read(REG_BAT_##type##_HIGH) << 8) | \
-	 (ec_read(REG_BAT_##type##_LOW)))
+	((ec_read_cached(REG_BAT_##type##_HIGH) << 8) | \
+	 (ec_read_cached(REG_BAT_##type##_LOW)))
 
 static int yeeloong_bat_get_ex_property(enum power_supply_property psp,
 				     union power_supply_propval *val)
 {
 	int bat_in, curr_cap, cap_level, status, charge, health;
 
-	status = ec_read(REG_BAT_STATUS);
+	status = ec_read_cached(REG_BAT_STATUS);
 	bat_in = status & BIT_BAT_STATUS_IN;
 	curr_cap = get_bat_info(RELATIVE_CAP);
 	if (status & BIT_BAT_STATUS_FULL)
@@ -205,7 +205,7 @@ static int yeeloong_bat_get_ex_property(enum power_supply_property psp,
 				break;
 			}
 
-			charge = ec_read(REG_BAT_CHARGE);
+			charge = ec_read_cached(REG_BAT_CHARGE);
 			if (charge & FLAG_BAT_CHARGE_DISCHARGE)
 				charge = POWER_SUPPLY_STATUS_DISCHARGING;
 			else if (charge & FLAG_BAT_CHARGE_CHARGE)
@@ -223,7 +223,7 @@ static int yeeloong_bat_get_ex_property(enum power_supply_property psp,
 			if (status &
 				(BIT_BAT_STATUS_DESTROY | BIT_BAT_STATUS_LOW))
 				health = POWER_SUPPLY_HEALTH_DEAD;
-			if (ec_read(REG_BAT_CHARGE_STATUS) &
+			if (ec_read_cached(REG_BAT_CHARGE_STATUS) &
 				BIT_BAT_CHARGE_STATUS_OVERTEMP)
 				health = POWER_SUPPLY_HEALTH_OVERHEAT;
 		}
@@ -281,7 +281,7 @@ static int yeeloong_get_bat_props(struct power_supply *psy,
 		val->intval = get_bat_info(FULLCHG_CAP) * 1000;	/* µAh */
 		break;
 	case POWER_SUPPLY_PROP_MANUFACTURER:
-		val->strval = (ec_read(REG_BAT_VENDOR) ==
+		val->strval = (ec_read_cached(REG_BAT_VENDOR) ==
 				FLAG_BAT_VENDOR_SANYO) ? "SANYO" : "SIMPLO";
 		break;
 	/* Dynamic information */
@@ -329,9 +329,30 @@ static struct power_supply yeeloong_bat = {
 
 static int ac_bat_initialized;
 
+/* Served from the EC cache, the battery status changes slowly */
+static const unsigned short yeeloong_bat_regs[] = {
+	REG_BAT_POWER, REG_BAT_STATUS, REG_BAT_CHARGE, REG_BAT_CHARGE_STATUS,
+	REG_BAT_VENDOR,
+	REG_BAT_RELATIVE_CAP_HIGH, REG_BAT_RELATIVE_CAP_LOW,
+	REG_BAT_FULLCHG_CAP_HIGH, REG_BAT_FULLCHG_CAP_LOW,
+	REG_BAT_DESIGN_CAP_HIGH, REG_BAT_DESIGN_CAP_LOW,
+	REG_BAT_DESIGN_VOL_HIGH, REG_BAT_DESIGN_VOL_LOW,
+	REG_BAT_CURRENT_HIGH, REG_BAT_CURRENT_LOW,
+	REG_BAT_VOLTAGE_HIGH, REG_BAT_VOLTAGE_LOW,
+	REG_BAT_TEMPERATURE_HIGH, REG_BAT_TEMPERATURE_LOW,
+};
+
 static int yeeloong_bat_init(void)
 {
-	int ret;
+	int i, ret;
+
+	for (i = 0; i < ARRAY_SIZE(yeeloong_bat_regs); i++) {
+		ret = ec_cache_register(yeeloong_bat_regs[i]);
+		if (ret)
+			pr_warning("Fail to cache EC register 0x%x (%d), "
+				   "reading it directly\n",
+				   yeeloong_bat_regs[i], ret);
+	}
 
 	ret = power_supply_register(NULL, &yeeloong_ac);
 	if (ret)
@@ -421,8 +442,8 @@ static int get_fan_rpm(void)
 	int value;
 
 	value = FAN_SPEED_DIVIDER /
-	    (((ec_read(REG_FAN_SPEED_HIGH) & 0x0f) << 8) |
-	     ec_read(REG_FAN_SPEED_LOW));
+	    (((ec_read_cached(REG_FAN_SPEED_HIGH) & 0x0f) << 8) |
+	     ec_read_cached(REG_FAN_SPEED_LOW));
 
 	return value;
 }
@@ -431,7 +452,7 @@ static int get_cpu_temp(void)
 {
 	s8 value;
 
-	value = ec_read(REG_TEMPERATURE_VALUE);
+	value = ec_read_cached(REG_TEMPERATURE_VALUE);
 
 	return value * 1000;
 }
@@ -445,7 +466,7 @@ static int get_battery_temp_alarm(void)
 {
 	int status;
 
-	status = (ec_read(REG_BAT_CHARGE_STATUS) &
+	status = (ec_read_cached(REG_BAT_CHARGE_STATUS) &
 			BIT_BAT_CHARGE_STATUS_OVERTEMP);
 
 	return !!status;
@@ -527,9 +548,22 @@ static struct attribute_group hwmon_attribute_group = {
 
 static struct device *yeeloong_hwmon_dev;
 
+/* Served from the EC cache as well */
+static const unsigned short yeeloong_hwmon_regs[] = {
+	REG_TEMPERATURE_VALUE, REG_FAN_SPEED_HIGH, REG_FAN_SPEED_LOW,
+};
+
 static int yeeloong_hwmon_init(void)
 {
-	int ret;
+	int i, ret;
+
+	for (i = 0; i < ARRAY_SIZE(yeeloong_hwmon_regs); i++) {
+		ret = ec_cache_register(yeeloong_hwmon_regs[i]);
+		if (ret)
+			pr_warning("Fail to cache EC register 0x%x (%d), "
+				   "reading it directly\n",
+				   yeeloong_hwmon_regs[i], ret);
+	}
 
 	yeeloong_hwmon_dev = hwmon_device_register(NULL);
 	if (IS_ERR(yeeloong_hwmon_dev)) {
@@ -918,15 +952,21 @@ static void do_event_action(int event)
  * SCI(system control interrupt) main interrupt routine
  *
  * We will do the query and get event number together so the interrupt routine
- * should be longer than 120us now at least 3ms elpase for it.
+ * should be longer than 120us now at least 3ms elpase for it.  That is done
+ * in the irq thread, where the EC accesses can sleep.
  */
-static irqreturn_t sci_irq_handler(int irq, void *dev_id)
+static irqreturn_t sci_irq_quick_handler(int irq, void *dev_id)
 {
-	int ret, event;
-
 	if (SCI_IRQ_NUM != irq)
 		return IRQ_NONE;
 
+	return IRQ_WAKE_THREAD;
+}
+
+static irqreturn_t sci_irq_handler(int irq, void *dev_id)
+{
+	int ret, event;
+
 	/* Query the event number */
 	ret = ec_query_event_num();
 	if (ret < 0)
@@ -1003,9 +1043,11 @@ static int sci_irq_init(void)
 }
 
 static struct irqaction sci_irqaction = {
-	.handler = sci_irq_handler,
+	.handler = sci_irq_quick_handler,
+	.thread_fn = sci_irq_handler,
 	.name = "sci",
-	.flags = IRQF_SHARED,
+	/* The SCI line is not shared; IRQF_ONESHOT does not allow that */
+	.flags = IRQF_ONESHOT,
 };
 
 static int yeeloong_hotkey_init(void)
@@ -1186,6 +1228,7 @@ static void __exit yeeloong_exit(void)
 	yeeloong_hwmon_exit();
 	yeeloong_bat_exit();
 	yeeloong_backlight_exit();
+	ec_cache_unregister_all();
 	platform_driver_unregister(&platform_driver);
 
 	pr_info("Unload YeeLoong Platform Specific Driver.\n");
@@ -355,6 +355,8 @@ int proc_pid_status(struct seq_file *m, struct pid_namespace *ns,
 	cpuset_task_status_allowed(m, task);
 #if defined(CONFIG_S390)
 	task_show_regs(m, task);
+#elif defined(CONFIG_MIPS)
+	task_show_stats(m, task);
 #endif
 	task_context_switch_counts(m, task);
 	return 0;
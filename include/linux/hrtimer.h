@@ -312,6 +312,8 @@ static inline int hrtimer_is_hres_active(struct hrtimer *timer)
 
 extern ktime_t ktime_get(void);
 extern ktime_t ktime_get_real(void);
+extern u64 ktime_get_mono_fast_ns(void);
+extern u64 ktime_get_real_fast_ns(void);
 
 
 DECLARE_PER_CPU(struct tick_device, tick_cpu_device);
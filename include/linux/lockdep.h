@@ -390,11 +390,53 @@ do {								\
 #define lock_contended(lockdep_map, ip) do {} while (0)
 #define lock_acquired(lockdep_map, ip) do {} while (0)
 
+#ifdef CONFIG_LOCK_EVENTS
+
+/*
+ * Lightweight lock tracing for kernels without lockdep: the lock
+ * primitives report acquire/contended/acquired/release keyed by the
+ * lock address, but only while somebody is listening on the lock
+ * tracepoints.
+ */
+extern int lock_events_enabled;
+
+extern void __lock_event_acquire(void *lock, unsigned long ip);
+extern void __lock_event_contended(void *lock, unsigned long ip);
+extern void __lock_event_acquired(void *lock, unsigned long ip);
+extern void __lock_event_release(void *lock, unsigned long ip);
+
+#define lock_event(name, _lock, ip)				\
+do {								\
+	if (unlikely(lock_events_enabled))			\
+		__lock_event_##name((_lock), (ip));		\
+} while (0)
+
+#define LOCK_CONTENDED(_lock, try, lock)			\
+do {								\
+	lock_event(acquire, (_lock), _RET_IP_);			\
+	if (!try(_lock)) {					\
+		lock_event(contended, (_lock), _RET_IP_);	\
+		lock(_lock);					\
+	}							\
+	lock_event(acquired, (_lock), _RET_IP_);		\
+} while (0)
+
+#define LOCK_RELEASED(_lock)					\
+	lock_event(release, (_lock), _RET_IP_)
+
+#else /* CONFIG_LOCK_EVENTS */
+
 #define LOCK_CONTENDED(_lock, try, lock) \
 	lock(_lock)
 
+#endif /* CONFIG_LOCK_EVENTS */
+
 #endif /* CONFIG_LOCK_STAT */
 
+#ifndef CONFIG_LOCK_EVENTS
+#define LOCK_RELEASED(_lock) do { } while (0)
+#endif
+
 #ifdef CONFIG_LOCKDEP
 
 /*
@@ -405,6 +447,18 @@ do {								\
 #define LOCK_CONTENDED_FLAGS(_lock, try, lock, lockfl, flags) \
 	LOCK_CONTENDED((_lock), (try), (lock))
 
+#elif defined(CONFIG_LOCK_EVENTS)
+
+#define LOCK_CONTENDED_FLAGS(_lock, try, lock, lockfl, flags)	\
+do {								\
+	lock_event(acquire, (_lock), _RET_IP_);			\
+	if (!try(_lock)) {					\
+		lock_event(contended, (_lock), _RET_IP_);	\
+		lockfl((_lock), (flags));			\
+	}							\
+	lock_event(acquired, (_lock), _RET_IP_);		\
+} while (0)
+
 #else /* CONFIG_LOCKDEP */
 
 #define LOCK_CONTENDED_FLAGS(_lock, try, lock, lockfl, flags) \
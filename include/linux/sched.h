@@ -1359,6 +1359,10 @@ struct task_struct {
 
 	struct task_cputime cputime_expires;
 	struct list_head cpu_timers[3];
+#ifdef CONFIG_POSIX_CPU_TIMERS_THREAD
+	/* next task queued for the posixcputmr thread, NULL if not queued */
+	struct task_struct *posix_timer_list;
+#endif
 
 /* process credentials */
 	const struct cred *real_cred;	/* objective and real subjective task
@@ -1835,6 +1839,7 @@ static inline void rcu_copy_process(struct task_struct *p)
 #ifdef CONFIG_SMP
 extern int set_cpus_allowed_ptr(struct task_struct *p,
 				const struct cpumask *new_mask);
+extern int cpu_isolated(int cpu);
 #else
 static inline int set_cpus_allowed_ptr(struct task_struct *p,
 				       const struct cpumask *new_mask)
@@ -1843,6 +1848,10 @@ static inline int set_cpus_allowed_ptr(struct task_struct *p,
 		return -EINVAL;
 	return 0;
 }
+static inline int cpu_isolated(int cpu)
+{
+	return 0;
+}
 #endif
 
 #ifndef CONFIG_CPUMASK_OFFSTACK
@@ -150,6 +150,18 @@ static inline int read_seqcount_retry(const seqcount_t *s, unsigned start)
 	return s->sequence != start;
 }
 
+/*
+ * Start of read of data latched with raw_write_seqcount_latch(); unlike
+ * read_seqcount_begin(), it does not wait for the writer to be done.
+ */
+static inline unsigned raw_read_seqcount(const seqcount_t *s)
+{
+	unsigned ret = ACCESS_ONCE(s->sequence);
+
+	smp_rmb();
+	return ret;
+}
+
 
 /*
  * Sequence counter only version assumes that callers are using their
@@ -167,6 +179,19 @@ static inline void write_seqcount_end(seqcount_t *s)
 	s->sequence++;
 }
 
+/*
+ * Latch version: the data is kept twice, and readers use the copy picked
+ * by the low bit of the sequence count.  The writer calls this before
+ * updating each copy, which steers the readers to the other one, so that
+ * they never wait for it, even when interrupting it.
+ */
+static inline void raw_write_seqcount_latch(seqcount_t *s)
+{
+	smp_wmb();	/* prior stores before incrementing "sequence" */
+	s->sequence++;
+	smp_wmb();	/* increment "sequence" before following stores */
+}
+
 /*
  * Possible sw/hw IRQ protected versions of the interfaces.
  */
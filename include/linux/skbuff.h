@@ -1859,7 +1859,7 @@ static inline void skb_get_timestampns(const struct sk_buff *skb,
 
 static inline void __net_timestamp(struct sk_buff *skb)
 {
-	skb->tstamp = ktime_get_real();
+	skb->tstamp = ns_to_ktime(ktime_get_real_fast_ns());
 }
 
 static inline ktime_t net_timedelta(ktime_t t)
@@ -2,12 +2,13 @@
 #define _LINUX_TRACE_CLOCK_H
 
 /*
- * 3 trace clock variants, with differing scalability/precision
+ * 4 trace clock variants, with differing scalability/precision
  * tradeoffs:
  *
  *  -   local: CPU-local trace clock
  *  -  medium: scalable global clock with some jitter
  *  -  global: globally monotonic, serialized clock
+ *  -    mono: the monotonic clock of the timekeeping code
  */
 #include <linux/compiler.h>
 #include <linux/types.h>
@@ -15,5 +16,6 @@
 extern u64 notrace trace_clock_local(void);
 extern u64 notrace trace_clock(void);
 extern u64 notrace trace_clock_global(void);
+extern u64 notrace trace_clock_mono(void);
 
 #endif /* _LINUX_TRACE_CLOCK_H */
@@ -1052,8 +1052,10 @@ extern void sock_init_data(struct socket *sock, struct sock *sk);
 
 static inline void sk_filter_release(struct sk_filter *fp)
 {
-	if (atomic_dec_and_test(&fp->refcnt))
+	if (atomic_dec_and_test(&fp->refcnt)) {
+		bpf_jit_free(fp);
 		kfree(fp);
+	}
 }
 
 static inline void sk_filter_uncharge(struct sock *sk, struct sk_filter *fp)
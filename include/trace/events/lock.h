@@ -20,11 +20,15 @@ TRACE_EVENT(lock_acquire,
 	TP_STRUCT__entry(
 		__field(unsigned int, flags)
 		__string(name, lock->name)
+		__field(void *, lockdep_addr)
+		__field(unsigned long, ip)
 	),
 
 	TP_fast_assign(
 		__entry->flags = (trylock ? 1 : 0) | (read ? 2 : 0);
 		__assign_str(name, lock->name);
+		__entry->lockdep_addr = lock;
+		__entry->ip = ip;
 	),
 
 	TP_printk("%s%s%s", (__entry->flags & 1) ? "try " : "",
@@ -40,10 +44,14 @@ TRACE_EVENT(lock_release,
 
 	TP_STRUCT__entry(
 		__string(name, lock->name)
+		__field(void *, lockdep_addr)
+		__field(unsigned long, ip)
 	),
 
 	TP_fast_assign(
 		__assign_str(name, lock->name);
+		__entry->lockdep_addr = lock;
+		__entry->ip = ip;
 	),
 
 	TP_printk("%s", __get_str(name))
@@ -59,10 +67,14 @@ TRACE_EVENT(lock_contended,
 
 	TP_STRUCT__entry(
 		__string(name, lock->name)
+		__field(void *, lockdep_addr)
+		__field(unsigned long, ip)
 	),
 
 	TP_fast_assign(
 		__assign_str(name, lock->name);
+		__entry->lockdep_addr = lock;
+		__entry->ip = ip;
 	),
 
 	TP_printk("%s", __get_str(name))
@@ -75,11 +87,15 @@ TRACE_EVENT(lock_acquired,
 
 	TP_STRUCT__entry(
 		__string(name, lock->name)
+		__field(void *, lockdep_addr)
+		__field(unsigned long, ip)
 		__field(unsigned long, wait_usec)
 		__field(unsigned long, wait_nsec_rem)
 	),
 	TP_fast_assign(
 		__assign_str(name, lock->name);
+		__entry->lockdep_addr = lock;
+		__entry->ip = ip;
 		__entry->wait_nsec_rem = do_div(waittime, NSEC_PER_USEC);
 		__entry->wait_usec = (unsigned long) waittime;
 	),
@@ -88,6 +104,104 @@ TRACE_EVENT(lock_acquired,
 );
 
 #endif
+
+#elif defined(CONFIG_LOCK_EVENTS)
+
+/*
+ * Without lockdep there is no lock class to report: the locks are
+ * identified by their address only, and the events are fired from
+ * the LOCK_CONTENDED() and LOCK_RELEASED() hooks in the lock
+ * primitives. See kernel/lock_events.c.
+ */
+extern void lock_events_regfunc(void);
+extern void lock_events_unregfunc(void);
+
+TRACE_EVENT_FN(lock_acquire,
+
+	TP_PROTO(void *lock, unsigned long ip),
+
+	TP_ARGS(lock, ip),
+
+	TP_STRUCT__entry(
+		__field(unsigned int, flags)
+		__field(void *, lockdep_addr)
+		__field(unsigned long, ip)
+	),
+
+	TP_fast_assign(
+		__entry->flags = 0;
+		__entry->lockdep_addr = lock;
+		__entry->ip = ip;
+	),
+
+	TP_printk("%p %pS", __entry->lockdep_addr, (void *)__entry->ip),
+
+	lock_events_regfunc, lock_events_unregfunc
+);
+
+TRACE_EVENT_FN(lock_release,
+
+	TP_PROTO(void *lock, unsigned long ip),
+
+	TP_ARGS(lock, ip),
+
+	TP_STRUCT__entry(
+		__field(void *, lockdep_addr)
+		__field(unsigned long, ip)
+	),
+
+	TP_fast_assign(
+		__entry->lockdep_addr = lock;
+		__entry->ip = ip;
+	),
+
+	TP_printk("%p %pS", __entry->lockdep_addr, (void *)__entry->ip),
+
+	lock_events_regfunc, lock_events_unregfunc
+);
+
+TRACE_EVENT_FN(lock_contended,
+
+	TP_PROTO(void *lock, unsigned long ip),
+
+	TP_ARGS(lock, ip),
+
+	TP_STRUCT__entry(
+		__field(void *, lockdep_addr)
+		__field(unsigned long, ip)
+	),
+
+	TP_fast_assign(
+		__entry->lockdep_addr = lock;
+		__entry->ip = ip;
+	),
+
+	TP_printk("%p %pS", __entry->lockdep_addr, (void *)__entry->ip),
+
+	lock_events_regfunc, lock_events_unregfunc
+);
+
+TRACE_EVENT_FN(lock_acquired,
+
+	TP_PROTO(void *lock, unsigned long ip),
+
+	TP_ARGS(lock, ip),
+
+	TP_STRUCT__entry(
+		__field(void *, lockdep_addr)
+		__field(unsigned long, ip)
+	),
+
+	TP_fast_assign(
+		__entry->lockdep_addr = lock;
+		__entry->ip = ip;
+	),
+
+	TP_printk("%p %pS", __entry->lockdep_addr, (void *)__entry->ip),
+
+	lock_events_regfunc, lock_events_unregfunc
+);
+
 #endif
 
 #endif /* _TRACE_LOCK_H */
@@ -964,6 +964,9 @@ static void posix_cpu_timers_init(struct task_struct *tsk)
 	INIT_LIST_HEAD(&tsk->cpu_timers[0]);
 	INIT_LIST_HEAD(&tsk->cpu_timers[1]);
 	INIT_LIST_HEAD(&tsk->cpu_timers[2]);
+#ifdef CONFIG_POSIX_CPU_TIMERS_THREAD
+	tsk->posix_timer_list = NULL;
+#endif
 }
 
 /*
@@ -0,0 +1,62 @@
+/*
+ * kernel/lock_events.c
+ *
+ * Lock tracepoints for kernels without lockdep.
+ *
+ * The spinlock, rwlock and rwsem primitives call in here through
+ * LOCK_CONTENDED() and LOCK_RELEASED() while lock_events_enabled is
+ * set, which is only the case while at least one probe is attached
+ * to one of the lock tracepoints.
+ */
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/percpu.h>
+#include <linux/irqflags.h>
+#include <linux/lockdep.h>
+
+#define CREATE_TRACE_POINTS
+#include <trace/events/lock.h>
+
+int lock_events_enabled __read_mostly;
+EXPORT_SYMBOL(lock_events_enabled);
+
+/* NB: reg/unreg are called while guarded with the tracepoints_mutex */
+static int lock_events_refcount;
+
+void lock_events_regfunc(void)
+{
+	if (!lock_events_refcount++)
+		lock_events_enabled = 1;
+}
+
+void lock_events_unregfunc(void)
+{
+	if (!--lock_events_refcount)
+		lock_events_enabled = 0;
+}
+
+/*
+ * The probes themselves take locks (the ring buffer, perf output
+ * wakeups, ...), don't let those generate events of their own:
+ */
+static DEFINE_PER_CPU(int, lock_events_recursion);
+
+#define BUILD_LOCK_EVENT(name)						\
+void __lock_event_##name(void *lock, unsigned long ip)			\
+{									\
+	unsigned long flags;						\
+	int *recursion;							\
+									\
+	raw_local_irq_save(flags);					\
+	recursion = &__get_cpu_var(lock_events_recursion);		\
+	if (!(*recursion)++)						\
+		trace_lock_##name(lock, ip);				\
+	(*recursion)--;							\
+	raw_local_irq_restore(flags);					\
+}									\
+EXPORT_SYMBOL(__lock_event_##name);
+
+BUILD_LOCK_EVENT(acquire)
+BUILD_LOCK_EVENT(contended)
+BUILD_LOCK_EVENT(acquired)
+BUILD_LOCK_EVENT(release)
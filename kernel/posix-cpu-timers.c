@@ -8,6 +8,8 @@
 #include <linux/math64.h>
 #include <asm/uaccess.h>
 #include <linux/kernel_stat.h>
+#include <linux/kthread.h>
+#include <linux/cpu.h>
 #include <trace/events/timer.h>
 
 /*
@@ -1386,25 +1388,17 @@ static inline int fastpath_timer_check(struct task_struct *tsk)
 }
 
 /*
- * This is called from the timer interrupt handler.  The irq handler has
- * already updated our counts.  We need to check if any timers fire now.
- * Interrupts are disabled.
+ * Expire the due timers of @tsk.  Interrupts are disabled.
  */
-void run_posix_cpu_timers(struct task_struct *tsk)
+static void __run_posix_cpu_timers(struct task_struct *tsk)
 {
 	LIST_HEAD(firing);
 	struct k_itimer *timer, *next;
+	unsigned long flags;
 
-	BUG_ON(!irqs_disabled());
-
-	/*
-	 * The fast path checks that there are no expired thread or thread
-	 * group timers.  If that's so, just return.
-	 */
-	if (!fastpath_timer_check(tsk))
+	/* tsk may have gone through __exit_signal() since it was checked */
+	if (!lock_task_sighand(tsk, &flags))
 		return;
-
-	spin_lock(&tsk->sighand->siglock);
 	/*
 	 * Here we take off tsk->signal->cpu_timers[N] and
 	 * tsk->cpu_timers[N] all the timers that are firing, and
@@ -1421,7 +1415,7 @@ void run_posix_cpu_timers(struct task_struct *tsk)
 	 * that gets the timer lock before we do will give it up and
 	 * spin until we've taken care of that timer below.
 	 */
-	spin_unlock(&tsk->sighand->siglock);
+	unlock_task_sighand(tsk, &flags);
 
 	/*
 	 * Now that all the timers on our list have the firing flag,
@@ -1447,6 +1441,188 @@ void run_posix_cpu_timers(struct task_struct *tsk)
 	}
 }
 
+#ifdef CONFIG_POSIX_CPU_TIMERS_THREAD
+
+/*
+ * The tick only queues the tasks which have a timer due on the
+ * posix_timer_tasklist of their CPU, chained through ->posix_timer_list
+ * and terminated by a task pointing to itself, and wakes up the
+ * posixcputmr thread of that CPU to expire them.  Each queued task holds
+ * a reference, dropped once its timers have been run.
+ */
+static DEFINE_PER_CPU(struct task_struct *, posix_timer_task);
+static DEFINE_PER_CPU(struct task_struct *, posix_timer_tasklist);
+
+static void run_posix_cpu_timers_list(struct task_struct *tsk)
+{
+	struct task_struct *next;
+
+	while (tsk) {
+		next = tsk->posix_timer_list;
+		if (next == tsk)
+			next = NULL;
+
+		local_irq_disable();
+		__run_posix_cpu_timers(tsk);
+		tsk->posix_timer_list = NULL;
+		local_irq_enable();
+		put_task_struct(tsk);
+
+		tsk = next;
+	}
+}
+
+static int posix_cpu_timers_thread(void *data)
+{
+	int cpu = (long)data;
+	struct task_struct *tsk;
+
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+
+		local_irq_disable();
+		tsk = per_cpu(posix_timer_tasklist, cpu);
+		per_cpu(posix_timer_tasklist, cpu) = NULL;
+		local_irq_enable();
+
+		if (!tsk) {
+			schedule();
+			continue;
+		}
+		__set_current_state(TASK_RUNNING);
+
+		run_posix_cpu_timers_list(tsk);
+	}
+	__set_current_state(TASK_RUNNING);
+
+	return 0;
+}
+
+/*
+ * This is called from the timer interrupt handler.  The irq handler has
+ * already updated our counts.  If a timer is due, hand the task over to
+ * the posixcputmr thread of this CPU.  Interrupts are disabled.
+ */
+void run_posix_cpu_timers(struct task_struct *tsk)
+{
+	int cpu = smp_processor_id();
+	struct task_struct *thread = per_cpu(posix_timer_task, cpu);
+
+	BUG_ON(!irqs_disabled());
+
+	/* already queued, the thread has not caught up yet */
+	if (tsk->posix_timer_list)
+		return;
+
+	if (!fastpath_timer_check(tsk))
+		return;
+
+	/* too early in boot for the thread, expire them right here */
+	if (unlikely(!thread)) {
+		__run_posix_cpu_timers(tsk);
+		return;
+	}
+
+	get_task_struct(tsk);
+	tsk->posix_timer_list = per_cpu(posix_timer_tasklist, cpu) ?: tsk;
+	per_cpu(posix_timer_tasklist, cpu) = tsk;
+
+	wake_up_process(thread);
+}
+
+static int __cpuinit posix_cpu_thread_call(struct notifier_block *nfb,
+					   unsigned long action, void *hcpu)
+{
+	int cpu = (long)hcpu;
+	struct sched_param param = { .sched_priority = MAX_RT_PRIO - 1 };
+	struct task_struct *p;
+
+	switch (action) {
+	case CPU_UP_PREPARE:
+	case CPU_UP_PREPARE_FROZEN:
+		p = kthread_create(posix_cpu_timers_thread, hcpu,
+				   "posixcputmr/%d", cpu);
+		if (IS_ERR(p))
+			return notifier_from_errno(PTR_ERR(p));
+		kthread_bind(p, cpu);
+		/* Must be high prio to avoid getting starved */
+		sched_setscheduler_nocheck(p, SCHED_FIFO, &param);
+		per_cpu(posix_timer_task, cpu) = p;
+		break;
+	case CPU_ONLINE:
+	case CPU_ONLINE_FROZEN:
+		wake_up_process(per_cpu(posix_timer_task, cpu));
+		break;
+#ifdef CONFIG_HOTPLUG_CPU
+	case CPU_UP_CANCELED:
+	case CPU_UP_CANCELED_FROZEN:
+		p = per_cpu(posix_timer_task, cpu);
+		if (!p)
+			break;
+		/* Unbind it from the offline cpu so it can run */
+		kthread_bind(p, cpumask_any(cpu_online_mask));
+		per_cpu(posix_timer_task, cpu) = NULL;
+		kthread_stop(p);
+		break;
+	case CPU_DEAD:
+	case CPU_DEAD_FROZEN:
+		p = per_cpu(posix_timer_task, cpu);
+		per_cpu(posix_timer_task, cpu) = NULL;
+		kthread_stop(p);
+
+		/* the dead cpu queues nothing anymore, flush what it left */
+		p = per_cpu(posix_timer_tasklist, cpu);
+		per_cpu(posix_timer_tasklist, cpu) = NULL;
+		run_posix_cpu_timers_list(p);
+		break;
+#endif
+	}
+	return NOTIFY_OK;
+}
+
+static struct notifier_block __cpuinitdata posix_cpu_thread_notifier = {
+	.notifier_call = posix_cpu_thread_call,
+};
+
+static int __init posix_cpu_thread_init(void)
+{
+	void *hcpu = (void *)(long)smp_processor_id();
+	int err;
+
+	/* Start one for the boot CPU */
+	err = posix_cpu_thread_call(&posix_cpu_thread_notifier,
+				    CPU_UP_PREPARE, hcpu);
+	BUG_ON(err != NOTIFY_OK);
+	posix_cpu_thread_call(&posix_cpu_thread_notifier, CPU_ONLINE, hcpu);
+	register_cpu_notifier(&posix_cpu_thread_notifier);
+
+	return 0;
+}
+early_initcall(posix_cpu_thread_init);
+
+#else /* !CONFIG_POSIX_CPU_TIMERS_THREAD */
+
+/*
+ * This is called from the timer interrupt handler.  The irq handler has
+ * already updated our counts.  We need to check if any timers fire now.
+ * Interrupts are disabled.
+ */
+void run_posix_cpu_timers(struct task_struct *tsk)
+{
+	BUG_ON(!irqs_disabled());
+
+	/*
+	 * The fast path checks that there are no expired thread or thread
+	 * group timers.  If that's so, just return.
+	 */
+	if (!fastpath_timer_check(tsk))
+		return;
+
+	__run_posix_cpu_timers(tsk);
+}
+
+#endif /* CONFIG_POSIX_CPU_TIMERS_THREAD */
+
 /*
  * Set one of the process-wide special case CPU timers.
  * The tsk->sighand->siglock must be held by the caller.
@@ -73,6 +73,7 @@ EXPORT_SYMBOL(down_write_trylock);
 void up_read(struct rw_semaphore *sem)
 {
 	rwsem_release(&sem->dep_map, 1, _RET_IP_);
+	LOCK_RELEASED(sem);
 
 	__up_read(sem);
 }
@@ -85,6 +86,7 @@ EXPORT_SYMBOL(up_read);
 void up_write(struct rw_semaphore *sem)
 {
 	rwsem_release(&sem->dep_map, 1, _RET_IP_);
+	LOCK_RELEASED(sem);
 
 	__up_write(sem);
 }
@@ -8150,6 +8150,15 @@ static int __init isolated_cpu_setup(char *str)
 
 __setup("isolcpus=", isolated_cpu_setup);
 
+/*
+ * Whether @cpu was isolated with isolcpus=; housekeeping work, which can
+ * run anywhere, is better kept off these.
+ */
+int cpu_isolated(int cpu)
+{
+	return cpumask_test_cpu(cpu, cpu_isolated_map);
+}
+
 /*
  * init_sched_build_groups takes the cpumask we wish to span, and a pointer
  * to a function which identifies what group(along with sched group) a CPU
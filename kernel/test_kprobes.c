@@ -351,6 +351,87 @@ static int test_kretprobes(void)
 }
 #endif /* CONFIG_KRETPROBES */
 
+#ifdef CONFIG_MIPS
+/*
+ * A probed branch is emulated and the instruction of its delay slot,
+ * which is no nop here, stepped out of line: both ways out of the
+ * branch must still give the right result.
+ */
+extern u32 kprobe_branch_target(u32 value);
+
+asm(
+	"	.pushsection .text\n"
+	"	.set	push\n"
+	"	.set	noreorder\n"
+	"	.globl	kprobe_branch_target\n"
+	"	.type	kprobe_branch_target, @function\n"
+	"kprobe_branch_target:\n"
+	"	beqz	$4, 1f\n"
+	"	 li	$2, 1\n"
+	"	jr	$31\n"
+	"	 addiu	$2, $2, 1\n"
+	"1:	jr	$31\n"
+	"	 nop\n"
+	"	.size	kprobe_branch_target, . - kprobe_branch_target\n"
+	"	.set	pop\n"
+	"	.popsection\n");
+
+static int branch_hits;
+
+static int kp_branch_pre_handler(struct kprobe *p, struct pt_regs *regs)
+{
+	branch_hits++;
+	return 0;
+}
+
+static struct kprobe kp_branch = {
+	.symbol_name = "kprobe_branch_target",
+	.pre_handler = kp_branch_pre_handler,
+};
+
+/* the jr of the path where the branch is not taken */
+static struct kprobe kp_branch_jr = {
+	.symbol_name = "kprobe_branch_target",
+	.offset = 8,
+	.pre_handler = kp_branch_pre_handler,
+};
+
+static int test_kprobe_branch(void)
+{
+	struct kprobe *kps[2] = {&kp_branch, &kp_branch_jr};
+	u32 taken, not_taken;
+	int ret;
+
+	ret = register_kprobes(kps, 2);
+	if (ret < 0) {
+		printk(KERN_ERR "Kprobe smoke test failed: "
+				"register_kprobes returned %d\n", ret);
+		return ret;
+	}
+
+	branch_hits = 0;
+	taken = kprobe_branch_target(0);
+	not_taken = kprobe_branch_target(rand1);
+	unregister_kprobes(kps, 2);
+
+	if (taken != 1 || not_taken != 2) {
+		printk(KERN_ERR "Kprobe smoke test failed: "
+				"probed branch returned %u and %u\n",
+				taken, not_taken);
+		handler_errors++;
+	}
+
+	if (branch_hits != 3) {
+		printk(KERN_ERR "Kprobe smoke test failed: "
+				"branch pre_handler called %d times\n",
+				branch_hits);
+		handler_errors++;
+	}
+
+	return 0;
+}
+#endif /* CONFIG_MIPS */
+
 int init_test_probes(void)
 {
 	int ret;
@@ -395,6 +476,13 @@ int init_test_probes(void)
 		errors++;
 #endif /* CONFIG_KRETPROBES */
 
+#ifdef CONFIG_MIPS
+	num_tests++;
+	ret = test_kprobe_branch();
+	if (ret < 0)
+		errors++;
+#endif /* CONFIG_MIPS */
+
 	if (errors)
 		printk(KERN_ERR "BUG: Kprobe smoke test: %d out of "
 				"%d tests failed\n", errors, num_tests);
@@ -30,6 +30,7 @@
 #include <linux/sched.h> /* for spin_unlock_irq() using preempt_count() m68k */
 #include <linux/tick.h>
 #include <linux/kthread.h>
+#include <linux/rculist.h>
 
 void timecounter_init(struct timecounter *tc,
 		      const struct cyclecounter *cc,
@@ -179,6 +180,13 @@ static int finished_booting;
 #ifdef CONFIG_CLOCKSOURCE_WATCHDOG
 static void clocksource_watchdog_work(struct work_struct *work);
 
+/*
+ * The watchdog timer reads the clocks without holding watchdog_lock, some
+ * of them are slow to read: watchdog_list and watchdog are RCU protected,
+ * and the timer only takes the lock to change the flags of a clocksource.
+ * It drops the change if watchdog_reset was bumped since it started, as
+ * its readings may belong to a watchdog which went away in between.
+ */
 static LIST_HEAD(watchdog_list);
 static struct clocksource *watchdog;
 static struct timer_list watchdog_timer;
@@ -186,6 +194,7 @@ static DECLARE_WORK(watchdog_work, clocksource_watchdog_work);
 static DEFINE_SPINLOCK(watchdog_lock);
 static cycle_t watchdog_last;
 static int watchdog_running;
+static unsigned int watchdog_reset;
 
 static int clocksource_watchdog_kthread(void *data);
 static void __clocksource_change_rating(struct clocksource *cs, int rating);
@@ -236,29 +245,76 @@ void clocksource_mark_unstable(struct clocksource *cs)
 	spin_lock_irqsave(&watchdog_lock, flags);
 	if (!(cs->flags & CLOCK_SOURCE_UNSTABLE)) {
 		if (list_empty(&cs->wd_list))
-			list_add(&cs->wd_list, &watchdog_list);
+			list_add_rcu(&cs->wd_list, &watchdog_list);
 		__clocksource_unstable(cs);
 	}
 	spin_unlock_irqrestore(&watchdog_lock, flags);
 }
 
+/*
+ * The next online CPU after @cpu to run the watchdog timer on, leaving out
+ * the isolated ones unless there is nothing else.
+ */
+static int clocksource_watchdog_next_cpu(int cpu)
+{
+	int i;
+
+	for (i = 0; i < nr_cpu_ids; i++) {
+		cpu = cpumask_next(cpu, cpu_online_mask);
+		if (cpu >= nr_cpu_ids)
+			cpu = cpumask_first(cpu_online_mask);
+		if (!cpu_isolated(cpu))
+			return cpu;
+	}
+	return cpumask_first(cpu_online_mask);
+}
+
+/*
+ * Sets @set in the flags of @cs, or marks it unstable if @set is
+ * CLOCK_SOURCE_UNSTABLE.  Nothing is changed, and 0 returned, if the
+ * watchdog was reset since @reset was sampled, as that voids the readings
+ * of the caller.
+ */
+static int clocksource_watchdog_update(struct clocksource *cs,
+				       unsigned int reset, unsigned long set,
+				       int64_t delta)
+{
+	int ret = 0;
+
+	spin_lock(&watchdog_lock);
+	if (reset != watchdog_reset || (cs->flags & CLOCK_SOURCE_UNSTABLE))
+		goto out;
+	if (set == CLOCK_SOURCE_UNSTABLE)
+		clocksource_unstable(cs, delta);
+	else
+		cs->flags |= set;
+	ret = 1;
+out:
+	spin_unlock(&watchdog_lock);
+	return ret;
+}
+
 static void clocksource_watchdog(unsigned long data)
 {
-	struct clocksource *cs;
+	struct clocksource *cs, *wd;
 	cycle_t csnow, wdnow;
 	int64_t wd_nsec, cs_nsec;
-	int next_cpu;
-
-	spin_lock(&watchdog_lock);
-	if (!watchdog_running)
+	unsigned int reset;
+	int notify = 0;
+
+	rcu_read_lock();
+	reset = ACCESS_ONCE(watchdog_reset);
+	smp_rmb();
+	wd = rcu_dereference(watchdog);
+	if (!watchdog_running || !wd)
 		goto out;
 
-	wdnow = watchdog->read(watchdog);
-	wd_nsec = clocksource_cyc2ns((wdnow - watchdog_last) & watchdog->mask,
-				     watchdog->mult, watchdog->shift);
+	wdnow = wd->read(wd);
+	wd_nsec = clocksource_cyc2ns((wdnow - watchdog_last) & wd->mask,
+				     wd->mult, wd->shift);
 	watchdog_last = wdnow;
 
-	list_for_each_entry(cs, &watchdog_list, wd_list) {
+	list_for_each_entry_rcu(cs, &watchdog_list, wd_list) {
 
 		/* Clocksource already marked unstable? */
 		if (cs->flags & CLOCK_SOURCE_UNSTABLE) {
@@ -271,8 +327,9 @@ static void clocksource_watchdog(unsigned long data)
 
 		/* Clocksource initialized ? */
 		if (!(cs->flags & CLOCK_SOURCE_WATCHDOG)) {
-			cs->flags |= CLOCK_SOURCE_WATCHDOG;
 			cs->wd_last = csnow;
+			clocksource_watchdog_update(cs, reset,
+						    CLOCK_SOURCE_WATCHDOG, 0);
 			continue;
 		}
 
@@ -281,33 +338,38 @@ static void clocksource_watchdog(unsigned long data)
 					     cs->mask, cs->mult, cs->shift);
 		cs->wd_last = csnow;
 		if (abs(cs_nsec - wd_nsec) > WATCHDOG_THRESHOLD) {
-			clocksource_unstable(cs, cs_nsec - wd_nsec);
+			clocksource_watchdog_update(cs, reset,
+						    CLOCK_SOURCE_UNSTABLE,
+						    cs_nsec - wd_nsec);
 			continue;
 		}
 
 		if (!(cs->flags & CLOCK_SOURCE_VALID_FOR_HRES) &&
 		    (cs->flags & CLOCK_SOURCE_IS_CONTINUOUS) &&
-		    (watchdog->flags & CLOCK_SOURCE_IS_CONTINUOUS)) {
-			cs->flags |= CLOCK_SOURCE_VALID_FOR_HRES;
-			/*
-			 * We just marked the clocksource as highres-capable,
-			 * notify the rest of the system as well so that we
-			 * transition into high-res mode:
-			 */
-			tick_clock_notify();
-		}
+		    (wd->flags & CLOCK_SOURCE_IS_CONTINUOUS))
+			notify |= clocksource_watchdog_update(cs, reset,
+					CLOCK_SOURCE_VALID_FOR_HRES, 0);
 	}
+out:
+	rcu_read_unlock();
+
+	/*
+	 * We just marked a clocksource as highres-capable, notify the rest
+	 * of the system as well so that we transition into high-res mode:
+	 */
+	if (notify)
+		tick_clock_notify();
 
 	/*
 	 * Cycle through CPUs to check if the CPUs stay synchronized
 	 * to each other.
 	 */
-	next_cpu = cpumask_next(raw_smp_processor_id(), cpu_online_mask);
-	if (next_cpu >= nr_cpu_ids)
-		next_cpu = cpumask_first(cpu_online_mask);
-	watchdog_timer.expires += WATCHDOG_INTERVAL;
-	add_timer_on(&watchdog_timer, next_cpu);
-out:
+	spin_lock(&watchdog_lock);
+	if (watchdog_running) {
+		watchdog_timer.expires += WATCHDOG_INTERVAL;
+		add_timer_on(&watchdog_timer, clocksource_watchdog_next_cpu(
+				     raw_smp_processor_id()));
+	}
 	spin_unlock(&watchdog_lock);
 }
 
@@ -319,7 +381,7 @@ static inline void clocksource_start_watchdog(void)
 	watchdog_timer.function = clocksource_watchdog;
 	watchdog_last = watchdog->read(watchdog);
 	watchdog_timer.expires = jiffies + WATCHDOG_INTERVAL;
-	add_timer_on(&watchdog_timer, cpumask_first(cpu_online_mask));
+	add_timer_on(&watchdog_timer, clocksource_watchdog_next_cpu(-1));
 	watchdog_running = 1;
 }
 
@@ -337,6 +399,9 @@ static inline void clocksource_reset_watchdog(void)
 
 	list_for_each_entry(cs, &watchdog_list, wd_list)
 		cs->flags &= ~CLOCK_SOURCE_WATCHDOG;
+	/* pairs with the smp_rmb() in clocksource_watchdog() */
+	smp_wmb();
+	watchdog_reset++;
 }
 
 static void clocksource_resume_watchdog(void)
@@ -367,15 +432,15 @@ static void clocksource_enqueue_watchdog(struct clocksource *cs)
 	spin_lock_irqsave(&watchdog_lock, flags);
 	if (cs->flags & CLOCK_SOURCE_MUST_VERIFY) {
 		/* cs is a clocksource to be watched. */
-		list_add(&cs->wd_list, &watchdog_list);
 		cs->flags &= ~CLOCK_SOURCE_WATCHDOG;
+		list_add_rcu(&cs->wd_list, &watchdog_list);
 	} else {
 		/* cs is a watchdog. */
 		if (cs->flags & CLOCK_SOURCE_IS_CONTINUOUS)
 			cs->flags |= CLOCK_SOURCE_VALID_FOR_HRES;
 		/* Pick the best watchdog. */
 		if (!watchdog || cs->rating > watchdog->rating) {
-			watchdog = cs;
+			rcu_assign_pointer(watchdog, cs);
 			/* Reset watchdog cycles */
 			clocksource_reset_watchdog();
 		}
@@ -387,51 +452,72 @@ static void clocksource_enqueue_watchdog(struct clocksource *cs)
 
 static void clocksource_dequeue_watchdog(struct clocksource *cs)
 {
-	struct clocksource *tmp;
+	struct clocksource *tmp, *wd;
 	unsigned long flags;
+	int watched = 0, was_watchdog = 0;
 
 	spin_lock_irqsave(&watchdog_lock, flags);
 	if (cs->flags & CLOCK_SOURCE_MUST_VERIFY) {
 		/* cs is a watched clocksource. */
-		list_del_init(&cs->wd_list);
+		list_del_rcu(&cs->wd_list);
+		watched = 1;
 	} else if (cs == watchdog) {
-		/* Reset watchdog cycles */
-		clocksource_reset_watchdog();
 		/* Current watchdog is removed. Find an alternative. */
-		watchdog = NULL;
+		wd = NULL;
 		list_for_each_entry(tmp, &clocksource_list, list) {
 			if (tmp == cs || tmp->flags & CLOCK_SOURCE_MUST_VERIFY)
 				continue;
-			if (!watchdog || tmp->rating > watchdog->rating)
-				watchdog = tmp;
+			if (!wd || tmp->rating > wd->rating)
+				wd = tmp;
 		}
+		rcu_assign_pointer(watchdog, wd);
+		/* Reset watchdog cycles */
+		clocksource_reset_watchdog();
+		was_watchdog = 1;
 	}
 	cs->flags &= ~CLOCK_SOURCE_WATCHDOG;
 	/* Check if the watchdog timer needs to be stopped. */
 	clocksource_stop_watchdog();
 	spin_unlock_irqrestore(&watchdog_lock, flags);
+
+	/* The watchdog timer may still be looking at cs */
+	if (watched || was_watchdog)
+		synchronize_rcu();
+	if (watched)
+		INIT_LIST_HEAD(&cs->wd_list);
 }
 
-static int clocksource_watchdog_kthread(void *data)
+/* Takes the next unstable clocksource off watchdog_list */
+static struct clocksource *clocksource_watchdog_unstable(void)
 {
-	struct clocksource *cs, *tmp;
+	struct clocksource *cs, *unstable = NULL;
 	unsigned long flags;
-	LIST_HEAD(unstable);
 
-	mutex_lock(&clocksource_mutex);
 	spin_lock_irqsave(&watchdog_lock, flags);
-	list_for_each_entry_safe(cs, tmp, &watchdog_list, wd_list)
+	list_for_each_entry(cs, &watchdog_list, wd_list)
 		if (cs->flags & CLOCK_SOURCE_UNSTABLE) {
-			list_del_init(&cs->wd_list);
-			list_add(&cs->wd_list, &unstable);
+			list_del_rcu(&cs->wd_list);
+			unstable = cs;
+			break;
 		}
 	/* Check if the watchdog timer needs to be stopped. */
-	clocksource_stop_watchdog();
+	if (!unstable)
+		clocksource_stop_watchdog();
 	spin_unlock_irqrestore(&watchdog_lock, flags);
 
-	/* Needs to be done outside of watchdog lock */
-	list_for_each_entry_safe(cs, tmp, &unstable, wd_list) {
-		list_del_init(&cs->wd_list);
+	return unstable;
+}
+
+static int clocksource_watchdog_kthread(void *data)
+{
+	struct clocksource *cs;
+
+	mutex_lock(&clocksource_mutex);
+	while ((cs = clocksource_watchdog_unstable()) != NULL) {
+		/* Wait for the watchdog timer to let go of the list entry */
+		synchronize_rcu();
+		INIT_LIST_HEAD(&cs->wd_list);
+		/* Needs to be done outside of watchdog lock */
 		__clocksource_change_rating(cs, 0);
 	}
 	mutex_unlock(&clocksource_mutex);
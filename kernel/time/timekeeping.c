@@ -172,12 +172,107 @@ void update_xtime_cache(u64 nsec)
 	timespec_add_ns(&xtime_cache, nsec);
 }
 
+/*
+ * What the fast readers below need to know, for those which can not wait
+ * on xtime_lock while update_wall_time() holds it: tracers, NMI handlers,
+ * the network time stamps.  It is latched, two copies are updated in turn
+ * and a reader uses the one which is not being written to.
+ *
+ * The catch is that a reader may get a time slightly older than the one
+ * a reader of the other copy got just before, when the NTP adjusted mult
+ * has changed in between.
+ */
+struct tk_read_base {
+	struct clocksource	*clock;		/* NULL while suspended */
+	cycle_t			cycle_last;
+	cycle_t			mask;
+	u32			mult;
+	int			shift;
+	u64			base_real;	/* xtime at cycle_last, in ns */
+	u64			base_mono;	/* same for the monotonic time */
+};
+
+static struct {
+	seqcount_t		seq;
+	struct tk_read_base	base[2];
+} tk_fast ____cacheline_aligned;
+
+/* must hold a write on xtime_lock, or run from stop_machine() */
+static void update_fast_timekeeper(void)
+{
+	struct tk_read_base *base = tk_fast.base;
+	struct timespec mono;
+
+	set_normalized_timespec(&mono, xtime.tv_sec + wall_to_monotonic.tv_sec,
+				xtime.tv_nsec + wall_to_monotonic.tv_nsec);
+
+	/* readers are sent to base[1] while base[0] is written to */
+	raw_write_seqcount_latch(&tk_fast.seq);
+	base->clock = timekeeping_suspended ? NULL : timekeeper.clock;
+	base->cycle_last = timekeeper.clock->cycle_last;
+	base->mask = timekeeper.clock->mask;
+	base->mult = timekeeper.mult;
+	base->shift = timekeeper.shift;
+	base->base_real = timespec_to_ns(&xtime);
+	base->base_mono = timespec_to_ns(&mono);
+
+	/* and back to base[0] */
+	raw_write_seqcount_latch(&tk_fast.seq);
+	base[1] = base[0];
+}
+
+static __always_inline u64 ktime_get_fast_ns(int real)
+{
+	struct tk_read_base *tkf;
+	cycle_t cycle_delta;
+	unsigned int seq;
+	u64 now;
+
+	do {
+		seq = raw_read_seqcount(&tk_fast.seq);
+		tkf = tk_fast.base + (seq & 1);
+		now = real ? tkf->base_real : tkf->base_mono;
+		if (likely(tkf->clock)) {
+			cycle_delta = (tkf->clock->read(tkf->clock) -
+				       tkf->cycle_last) & tkf->mask;
+			now += clocksource_cyc2ns(cycle_delta, tkf->mult,
+						  tkf->shift);
+		}
+	} while (read_seqcount_retry(&tk_fast.seq, seq));
+
+	return now;
+}
+
+/**
+ * ktime_get_mono_fast_ns - Returns the monotonic time in nanoseconds
+ *
+ * Does not wait for xtime_lock, and can be used from any context the
+ * clocksource can be read from.  See tk_fast for the catch.
+ */
+u64 notrace ktime_get_mono_fast_ns(void)
+{
+	return ktime_get_fast_ns(0);
+}
+EXPORT_SYMBOL_GPL(ktime_get_mono_fast_ns);
+
+/**
+ * ktime_get_real_fast_ns - Returns the time of day in nanoseconds
+ *
+ * The CLOCK_REALTIME counterpart of ktime_get_mono_fast_ns().
+ */
+u64 notrace ktime_get_real_fast_ns(void)
+{
+	return ktime_get_fast_ns(1);
+}
+EXPORT_SYMBOL_GPL(ktime_get_real_fast_ns);
+
 /* must hold xtime_lock */
 void timekeeping_leap_insert(int leapsecond)
 {
 	xtime.tv_sec += leapsecond;
 	wall_to_monotonic.tv_sec -= leapsecond;
 	update_vsyscall(&xtime, timekeeper.clock, timekeeper.mult);
+	update_fast_timekeeper();
 }
 
 #ifdef CONFIG_GENERIC_TIME
@@ -338,6 +433,7 @@ int do_settimeofday(struct timespec *tv)
 	ntp_clear();
 
 	update_vsyscall(&xtime, timekeeper.clock, timekeeper.mult);
+	update_fast_timekeeper();
 
 	write_sequnlock_irqrestore(&xtime_lock, flags);
 
@@ -367,6 +463,7 @@ static int change_clocksource(void *data)
 		if (old->disable)
 			old->disable(old);
 	}
+	update_fast_timekeeper();
 	return 0;
 }
 
@@ -562,6 +659,7 @@ void __init timekeeping_init(void)
 	update_xtime_cache(0);
 	total_sleep_time.tv_sec = 0;
 	total_sleep_time.tv_nsec = 0;
+	update_fast_timekeeper();
 	write_sequnlock_irqrestore(&xtime_lock, flags);
 }
 
@@ -598,6 +696,7 @@ static int timekeeping_resume(struct sys_device *dev)
 	timekeeper.clock->cycle_last = timekeeper.clock->read(timekeeper.clock);
 	timekeeper.ntp_error = 0;
 	timekeeping_suspended = 0;
+	update_fast_timekeeper();
 	write_sequnlock_irqrestore(&xtime_lock, flags);
 
 	touch_softlockup_watchdog();
@@ -619,6 +718,8 @@ static int timekeeping_suspend(struct sys_device *dev, pm_message_t state)
 	write_seqlock_irqsave(&xtime_lock, flags);
 	timekeeping_forward_now();
 	timekeeping_suspended = 1;
+	/* the fast readers stay at the time of the suspend */
+	update_fast_timekeeper();
 	write_sequnlock_irqrestore(&xtime_lock, flags);
 
 	clockevents_notify(CLOCK_EVT_NOTIFY_SUSPEND, NULL);
@@ -858,6 +959,7 @@ void update_wall_time(void)
 
 	/* check to see if there is a new clocksource to use */
 	update_vsyscall(&xtime, timekeeper.clock, timekeeper.mult);
+	update_fast_timekeeper();
 }
 
 /**
@@ -333,6 +333,7 @@ static struct {
 } trace_clocks[] = {
 	{ trace_clock_local,	"local" },
 	{ trace_clock_global,	"global" },
+	{ trace_clock_mono,	"mono" },
 };
 
 int trace_clock_id;
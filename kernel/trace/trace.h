@@ -39,6 +39,7 @@ enum trace_type {
 	TRACE_KMEM_FREE,
 	TRACE_BLK,
 	TRACE_KSYM,
+	TRACE_HWLAT,
 
 	__TRACE_LAST_TYPE,
 };
@@ -235,6 +236,7 @@ extern void __ftrace_bad_type(void);
 		IF_ASSIGN(var, ent, struct kmemtrace_free_entry,	\
 			  TRACE_KMEM_FREE);	\
 		IF_ASSIGN(var, ent, struct ksym_trace_entry, TRACE_KSYM);\
+		IF_ASSIGN(var, ent, struct hwlat_entry, TRACE_HWLAT);	\
 		__ftrace_bad_type();					\
 	} while (0)
 
@@ -394,6 +396,8 @@ int is_tracing_stopped(void);
 
 extern int process_new_ksym_entry(char *ksymname, int op, unsigned long addr);
 
+extern u64 hwlat_set_threshold(u64 threshold);
+
 extern unsigned long nsecs_to_usecs(unsigned long nsecs);
 
 #ifdef CONFIG_TRACER_MAX_TRACE
@@ -468,6 +472,8 @@ extern int trace_selftest_startup_branch(struct tracer *trace,
 					 struct trace_array *tr);
 extern int trace_selftest_startup_hw_branches(struct tracer *trace,
 					      struct trace_array *tr);
+extern int trace_selftest_startup_hwlat(struct tracer *trace,
+					 struct trace_array *tr);
 extern int trace_selftest_startup_ksym(struct tracer *trace,
 					 struct trace_array *tr);
 #endif /* CONFIG_FTRACE_STARTUP_TEST */
@@ -113,3 +113,15 @@ u64 notrace trace_clock_global(void)
 
 	return now;
 }
+
+/*
+ * trace_clock_mono(): CLOCK_MONOTONIC, read without waiting for the
+ * timekeeping updates.
+ *
+ * Slower than the clocks above as it reads the clocksource, but its
+ * time stamps can be compared with the ones taken elsewhere.
+ */
+u64 notrace trace_clock_mono(void)
+{
+	return ktime_get_mono_fast_ns();
+}
@@ -380,3 +380,21 @@ FTRACE_ENTRY(ksym_trace, ksym_trace_entry,
 		(void *)__entry->ip, (unsigned int)__entry->type,
 		(void *)__entry->addr,  __entry->cmd)
 );
+
+FTRACE_ENTRY(hwlat, hwlat_entry,
+
+	TRACE_HWLAT,
+
+	F_STRUCT(
+		__field(	u64,			duration	)
+		__field(	u64,			outer_duration	)
+		__field(	u64,			count		)
+		__field(	unsigned int,		seqnum		)
+	),
+
+	F_printk("cnt:%u\tinner/outer(ns): %llu/%llu\tsamples:%llu",
+		 __entry->seqnum,
+		 __entry->duration,
+		 __entry->outer_duration,
+		 __entry->count)
+);
@@ -0,0 +1,395 @@
+/*
+ * trace_hwlat.c - hardware/firmware latency detector
+ *
+ * A kernel thread repeatedly disables interrupts for "width" microseconds
+ * out of every "window" microseconds and reads trace_clock_local()
+ * back-to-back.  Since nothing in the kernel can run on this CPU while
+ * the thread spins, any gap between two consecutive clock reads that
+ * exceeds "threshold" must have been caused by the platform: SMIs,
+ * firmware emulation traps (e.g. the CS5536 VSA handling MSR and legacy
+ * device accesses), bus stalls and the like.
+ *
+ * Each gap above the threshold is stored in the ring buffer together
+ * with the gap seen between two sampling iterations (the "outer" gap)
+ * and the number of samples taken in that window.
+ *
+ * The tunables live in <debugfs>/tracing/hwlat_detector/:
+ *
+ *   window	- sampling period in usecs
+ *   width	- usecs of each period spent sampling with irqs off
+ *   threshold	- minimum gap in usecs that is recorded
+ *   max	- largest gap in usecs seen so far (write 0 to reset)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#include <linux/trace_clock.h>
+#include <linux/uaccess.h>
+#include <linux/debugfs.h>
+#include <linux/delay.h>
+#include <linux/kthread.h>
+#include <linux/module.h>
+#include <linux/ftrace.h>
+#include <linux/sched.h>
+#include <linux/fs.h>
+
+#include "trace_output.h"
+#include "trace.h"
+
+#define DEFAULT_SAMPLE_WINDOW	1000000		/* 1s */
+#define DEFAULT_SAMPLE_WIDTH	500000		/* 0.5s */
+#define DEFAULT_LAT_THRESHOLD	10		/* 10us */
+
+static struct trace_array	*hwlat_trace __read_mostly;
+static struct task_struct	*hwlat_kthread;
+static DEFINE_MUTEX(hwlat_data_lock);
+
+static struct hwlat_data {
+	u64		window;		/* usecs */
+	u64		width;		/* usecs */
+	u64		threshold;	/* usecs */
+	u64		max;		/* usecs */
+	unsigned int	seqnum;
+} hwlat_data = {
+	.window		= DEFAULT_SAMPLE_WINDOW,
+	.width		= DEFAULT_SAMPLE_WIDTH,
+	.threshold	= DEFAULT_LAT_THRESHOLD,
+};
+
+static void hwlat_record(u64 duration, u64 outer_duration, u64 count)
+{
+	struct ring_buffer *buffer = hwlat_trace->buffer;
+	struct ring_buffer_event *event;
+	struct hwlat_entry *entry;
+	int pc = preempt_count();
+
+	event = trace_buffer_lock_reserve(buffer, TRACE_HWLAT,
+					  sizeof(*entry), 0, pc);
+	if (!event)
+		return;
+
+	entry			= ring_buffer_event_data(event);
+	entry->seqnum		= hwlat_data.seqnum;
+	entry->duration		= duration;
+	entry->outer_duration	= outer_duration;
+	entry->count		= count;
+
+	trace_buffer_unlock_commit(buffer, event, 0, pc);
+}
+
+/*
+ * The sampling loop is timed by trace_clock_local() alone.  Without a high
+ * resolution sched_clock() that is jiffies based, and on UP jiffies do not
+ * move with interrupts off, so the loop would never end.  Only sample if
+ * the clock follows a calibrated delay with interrupts off.
+ */
+#define HWLAT_CLOCK_CHECK_US	100
+
+static int hwlat_clock_usable(void)
+{
+	unsigned long flags;
+	u64 t1, t2;
+
+	local_irq_save(flags);
+	t1 = trace_clock_local();
+	udelay(HWLAT_CLOCK_CHECK_US);
+	t2 = trace_clock_local();
+	local_irq_restore(flags);
+
+	return t2 - t1 >= HWLAT_CLOCK_CHECK_US * NSEC_PER_USEC / 2;
+}
+
+/*
+ * Spin for one "width" with interrupts off, looking for the largest gap
+ * between two back-to-back clock reads (inner) and between the end of
+ * one iteration and the start of the next (outer).
+ */
+static void hwlat_get_sample(void)
+{
+	u64 start, t1, t2, last_t2 = 0;
+	u64 inner, outer, max_inner = 0, max_outer = 0;
+	u64 width, threshold, count = 0;
+
+	mutex_lock(&hwlat_data_lock);
+	width = hwlat_data.width * NSEC_PER_USEC;
+	threshold = hwlat_data.threshold * NSEC_PER_USEC;
+	mutex_unlock(&hwlat_data_lock);
+
+	local_irq_disable();
+
+	start = trace_clock_local();
+	do {
+		t1 = trace_clock_local();
+		t2 = trace_clock_local();
+
+		if (last_t2) {
+			outer = t1 - last_t2;
+			if (outer > max_outer)
+				max_outer = outer;
+		}
+		last_t2 = t2;
+
+		inner = t2 - t1;
+		if (inner > max_inner)
+			max_inner = inner;
+
+		count++;
+		/*
+		 * An iteration takes well over a nanosecond, so this only
+		 * ends the loop should the clock stop advancing after all.
+		 */
+	} while (t2 - start <= width && count < width);
+
+	local_irq_enable();
+
+	if (max_inner <= threshold && max_outer <= threshold)
+		return;
+
+	mutex_lock(&hwlat_data_lock);
+	hwlat_data.seqnum++;
+	inner = div_u64(max(max_inner, max_outer), NSEC_PER_USEC);
+	if (inner > hwlat_data.max)
+		hwlat_data.max = inner;
+	mutex_unlock(&hwlat_data_lock);
+
+	hwlat_record(max_inner, max_outer, count);
+}
+
+static int hwlat_kthread_fn(void *unused)
+{
+	u64 interval;
+
+	while (!kthread_should_stop()) {
+		hwlat_get_sample();
+
+		mutex_lock(&hwlat_data_lock);
+		interval = hwlat_data.window - hwlat_data.width;
+		mutex_unlock(&hwlat_data_lock);
+
+		/* Always give the rest of the system at least a jiffy */
+		if (interval < USEC_PER_SEC / HZ)
+			interval = USEC_PER_SEC / HZ;
+
+		schedule_timeout_interruptible(usecs_to_jiffies(interval));
+	}
+
+	return 0;
+}
+
+static int hwlat_start_kthread(void)
+{
+	struct task_struct *kthread;
+
+	kthread = kthread_run(hwlat_kthread_fn, NULL, "hwlatd");
+	if (IS_ERR(kthread)) {
+		pr_err("hwlat_detector: could not start sampling thread\n");
+		return PTR_ERR(kthread);
+	}
+	hwlat_kthread = kthread;
+
+	return 0;
+}
+
+static void hwlat_stop_kthread(void)
+{
+	if (!hwlat_kthread)
+		return;
+	kthread_stop(hwlat_kthread);
+	hwlat_kthread = NULL;
+}
+
+static int hwlat_trace_init(struct trace_array *tr)
+{
+	if (!hwlat_clock_usable()) {
+		pr_err("hwlat_detector: the trace clock does not advance with "
+		       "interrupts off, refusing to start\n");
+		return -ENODEV;
+	}
+
+	hwlat_trace = tr;
+	tracing_reset_online_cpus(tr);
+
+	mutex_lock(&hwlat_data_lock);
+	hwlat_data.seqnum = 0;
+	hwlat_data.max = 0;
+	mutex_unlock(&hwlat_data_lock);
+
+	return hwlat_start_kthread();
+}
+
+static void hwlat_trace_reset(struct trace_array *tr)
+{
+	hwlat_stop_kthread();
+}
+
+static void hwlat_trace_start(struct trace_array *tr)
+{
+	if (!hwlat_kthread)
+		hwlat_start_kthread();
+}
+
+static void hwlat_trace_stop(struct trace_array *tr)
+{
+	hwlat_stop_kthread();
+}
+
+static void hwlat_print_header(struct seq_file *m)
+{
+	seq_puts(m, "#                              _-----=> seqnum\n");
+	seq_puts(m, "#      TIMESTAMP         CPU  /   inner(ns)   outer(ns)"
+		    "      samples\n");
+	seq_puts(m, "#          |              |   |      |           |"
+		    "            |\n");
+}
+
+static enum print_line_t hwlat_print_line(struct trace_iterator *iter)
+{
+	struct trace_entry *entry = iter->ent;
+	struct trace_seq *s = &iter->seq;
+	struct hwlat_entry *field;
+	unsigned long long t;
+	unsigned long secs, usec_rem;
+	int ret;
+
+	if (entry->type != TRACE_HWLAT)
+		return TRACE_TYPE_UNHANDLED;
+
+	trace_assign_type(field, entry);
+
+	t = ns2usecs(iter->ts);
+	usec_rem = do_div(t, USEC_PER_SEC);
+	secs = (unsigned long)t;
+
+	ret = trace_seq_printf(s, "%12lu.%06lu  [%03d] %-4u %11llu %11llu %12llu\n",
+			       secs, usec_rem, iter->cpu, field->seqnum,
+			       field->duration, field->outer_duration,
+			       field->count);
+	if (!ret)
+		return TRACE_TYPE_PARTIAL_LINE;
+
+	return TRACE_TYPE_HANDLED;
+}
+
+struct tracer hwlat_tracer __read_mostly =
+{
+	.name		= "hwlat",
+	.init		= hwlat_trace_init,
+	.reset		= hwlat_trace_reset,
+	.start		= hwlat_trace_start,
+	.stop		= hwlat_trace_stop,
+#ifdef CONFIG_FTRACE_SELFTEST
+	.selftest	= trace_selftest_startup_hwlat,
+#endif
+	.print_header	= hwlat_print_header,
+	.print_line	= hwlat_print_line,
+};
+
+/*
+ * Set the latency threshold in usecs, returning the previous one.
+ * Used by the startup selftest to force every sample to be recorded.
+ */
+u64 hwlat_set_threshold(u64 threshold)
+{
+	u64 old;
+
+	mutex_lock(&hwlat_data_lock);
+	old = hwlat_data.threshold;
+	hwlat_data.threshold = threshold;
+	mutex_unlock(&hwlat_data_lock);
+
+	return old;
+}
+
+static ssize_t hwlat_read(struct file *filp, char __user *ubuf,
+			  size_t cnt, loff_t *ppos)
+{
+	u64 *entry = filp->private_data;
+	char buf[32];
+	u64 val;
+	int r;
+
+	mutex_lock(&hwlat_data_lock);
+	val = *entry;
+	mutex_unlock(&hwlat_data_lock);
+
+	r = snprintf(buf, sizeof(buf), "%llu\n", (unsigned long long)val);
+
+	return simple_read_from_buffer(ubuf, cnt, ppos, buf, r);
+}
+
+static ssize_t hwlat_write(struct file *filp, const char __user *ubuf,
+			   size_t cnt, loff_t *ppos)
+{
+	u64 *entry = filp->private_data;
+	char buf[32];
+	unsigned long long val;
+	int ret = 0;
+
+	if (cnt >= sizeof(buf))
+		return -EINVAL;
+
+	if (copy_from_user(&buf, ubuf, cnt))
+		return -EFAULT;
+
+	buf[cnt] = 0;
+
+	if (strict_strtoull(strstrip(buf), 10, &val))
+		return -EINVAL;
+
+	mutex_lock(&hwlat_data_lock);
+	/* The sampling width must leave room in the window to breathe */
+	if (entry == &hwlat_data.width) {
+		if (!val || val >= hwlat_data.window)
+			ret = -EINVAL;
+	} else if (entry == &hwlat_data.window) {
+		if (val <= hwlat_data.width)
+			ret = -EINVAL;
+	}
+	if (!ret)
+		*entry = val;
+	mutex_unlock(&hwlat_data_lock);
+
+	if (ret)
+		return ret;
+
+	*ppos += cnt;
+
+	return cnt;
+}
+
+static const struct file_operations hwlat_fops = {
+	.open		= tracing_open_generic,
+	.read		= hwlat_read,
+	.write		= hwlat_write,
+};
+
+__init static int init_hwlat_trace(void)
+{
+	struct dentry *d_tracer;
+	struct dentry *d_hwlat;
+
+	d_tracer = tracing_init_dentry();
+	if (!d_tracer)
+		goto out;
+
+	d_hwlat = debugfs_create_dir("hwlat_detector", d_tracer);
+	if (!d_hwlat) {
+		pr_warning("Could not create debugfs directory "
+			   "'hwlat_detector'\n");
+		goto out;
+	}
+
+	trace_create_file("window", 0644, d_hwlat,
+			  &hwlat_data.window, &hwlat_fops);
+	trace_create_file("width", 0644, d_hwlat,
+			  &hwlat_data.width, &hwlat_fops);
+	trace_create_file("threshold", 0644, d_hwlat,
+			  &hwlat_data.threshold, &hwlat_fops);
+	trace_create_file("max", 0644, d_hwlat,
+			  &hwlat_data.max, &hwlat_fops);
+
+out:
+	return register_tracer(&hwlat_tracer);
+}
+device_initcall(init_hwlat_trace);
@@ -18,6 +18,7 @@ static inline int trace_valid_entry(struct trace_entry *entry)
 	case TRACE_GRAPH_RET:
 	case TRACE_HW_BRANCHES:
 	case TRACE_KSYM:
+	case TRACE_HWLAT:
 		return 1;
 	}
 	return 0;
@@ -810,6 +811,45 @@ trace_selftest_startup_hw_branches(struct tracer *trace,
 }
 #endif /* CONFIG_HW_BRANCH_TRACER */
 
+#ifdef CONFIG_HWLAT_TRACER
+int
+trace_selftest_startup_hwlat(struct tracer *trace, struct trace_array *tr)
+{
+	unsigned long count;
+	u64 old_threshold;
+	int ret;
+
+	/* With a zero threshold every sampling window gets recorded */
+	old_threshold = hwlat_set_threshold(0);
+
+	ret = tracer_init(trace, tr);
+	if (ret) {
+		warn_failed_init_tracer(trace, ret);
+		goto out;
+	}
+
+	/* The default window is one second, wait for the first sample */
+	msleep(1100);
+
+	/* stop the tracing. */
+	tracing_stop();
+	/* check the trace buffer */
+	ret = trace_test_buffer(tr, &count);
+	trace->reset(tr);
+	tracing_start();
+
+	if (!ret && !count) {
+		printk(KERN_CONT ".. no entries found ..");
+		ret = -1;
+	}
+
+out:
+	hwlat_set_threshold(old_threshold);
+
+	return ret;
+}
+#endif /* CONFIG_HWLAT_TRACER */
+
 #ifdef CONFIG_KSYM_TRACER
 static int ksym_selftest_dummy;
 
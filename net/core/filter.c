@@ -64,6 +64,69 @@ static inline void *load_pointer(struct sk_buff *skb, int k,
 	}
 }
 
+/*
+ * Ancillary data, which are impossible (or very difficult) to get parsing
+ * packet contents.  Returns 0 and the value in *res, or -1 if the filter
+ * has to return 0.
+ */
+static int load_ancillary(struct sk_buff *skb, int k, u32 A, u32 X, u32 *res)
+{
+	switch (k-SKF_AD_OFF) {
+	case SKF_AD_PROTOCOL:
+		*res = ntohs(skb->protocol);
+		return 0;
+	case SKF_AD_PKTTYPE:
+		*res = skb->pkt_type;
+		return 0;
+	case SKF_AD_IFINDEX:
+		*res = skb->dev->ifindex;
+		return 0;
+	case SKF_AD_MARK:
+		*res = skb->mark;
+		return 0;
+	case SKF_AD_QUEUE:
+		*res = skb->queue_mapping;
+		return 0;
+	case SKF_AD_NLATTR: {
+		struct nlattr *nla;
+
+		if (skb_is_nonlinear(skb))
+			return -1;
+		if (A > skb->len - sizeof(struct nlattr))
+			return -1;
+
+		nla = nla_find((struct nlattr *)&skb->data[A],
+			       skb->len - A, X);
+		if (nla)
+			*res = (void *)nla - (void *)skb->data;
+		else
+			*res = 0;
+		return 0;
+	}
+	case SKF_AD_NLATTR_NEST: {
+		struct nlattr *nla;
+
+		if (skb_is_nonlinear(skb))
+			return -1;
+		if (A > skb->len - sizeof(struct nlattr))
+			return -1;
+
+		nla = (struct nlattr *)&skb->data[A];
+		if (nla->nla_len > A - skb->len)
+			return -1;
+
+		nla = nla_find_nested(nla, X);
+		if (nla)
+			*res = (void *)nla - (void *)skb->data;
+		else
+			*res = 0;
+		return 0;
+	}
+	default:
+		return -1;
+	}
+}
+
 /**
  *	sk_filter - run a packet through a socket filter
  *	@sk: sock associated with &sk_buff
@@ -88,8 +151,7 @@ int sk_filter(struct sock *sk, struct sk_buff *skb)
 	rcu_read_lock_bh();
 	filter = rcu_dereference(sk->sk_filter);
 	if (filter) {
-		unsigned int pkt_len = sk_run_filter(skb, filter->insns,
-				filter->len);
+		unsigned int pkt_len = SK_RUN_FILTER(filter, skb);
 		err = pkt_len ? pskb_trim(skb, pkt_len) : -EPERM;
 	}
 	rcu_read_unlock_bh();
@@ -293,65 +355,54 @@ load_b:
 		 * Handle ancillary data, which are impossible
 		 * (or very difficult) to get parsing packet contents.
 		 */
-		switch (k-SKF_AD_OFF) {
-		case SKF_AD_PROTOCOL:
-			A = ntohs(skb->protocol);
-			continue;
-		case SKF_AD_PKTTYPE:
-			A = skb->pkt_type;
-			continue;
-		case SKF_AD_IFINDEX:
-			A = skb->dev->ifindex;
-			continue;
-		case SKF_AD_MARK:
-			A = skb->mark;
-			continue;
-		case SKF_AD_QUEUE:
-			A = skb->queue_mapping;
-			continue;
-		case SKF_AD_NLATTR: {
-			struct nlattr *nla;
-
-			if (skb_is_nonlinear(skb))
-				return 0;
-			if (A > skb->len - sizeof(struct nlattr))
-				return 0;
-
-			nla = nla_find((struct nlattr *)&skb->data[A],
-				       skb->len - A, X);
-			if (nla)
-				A = (void *)nla - (void *)skb->data;
-			else
-				A = 0;
-			continue;
-		}
-		case SKF_AD_NLATTR_NEST: {
-			struct nlattr *nla;
+		if (load_ancillary(skb, k, A, X, &tmp))
+			return 0;
+		A = tmp;
+	}
 
-			if (skb_is_nonlinear(skb))
-				return 0;
-			if (A > skb->len - sizeof(struct nlattr))
-				return 0;
+	return 0;
+}
+EXPORT_SYMBOL(sk_run_filter);
 
-			nla = (struct nlattr *)&skb->data[A];
-			if (nla->nla_len > A - skb->len)
-				return 0;
+#ifdef CONFIG_BPF_JIT
+/**
+ *	sk_filter_load_slow - slow path of the loads of the filter JITs
+ *	@skb: buffer the filter is run on
+ *	@k: offset of the load, negative ones included
+ *	@size: 1, 2 or 4 bytes
+ *	@A: accumulator
+ *	@X: index register
+ *	@res: where the value loaded goes
+ *
+ * Loads outside of the linear data of the skb, and the ancillary data,
+ * the same way sk_run_filter() does it.  Returns 0, or -1 if the filter
+ * has to return 0.
+ */
+int sk_filter_load_slow(struct sk_buff *skb, int k, unsigned int size,
+			u32 A, u32 X, u32 *res)
+{
+	void *ptr;
+	u32 tmp;
 
-			nla = nla_find_nested(nla, X);
-			if (nla)
-				A = (void *)nla - (void *)skb->data;
-			else
-				A = 0;
-			continue;
-		}
-		default:
-			return 0;
-		}
+	ptr = load_pointer(skb, k, size, &tmp);
+	if (ptr == NULL)
+		return load_ancillary(skb, k, A, X, res);
+
+	switch (size) {
+	case 4:
+		*res = get_unaligned_be32(ptr);
+		break;
+	case 2:
+		*res = get_unaligned_be16(ptr);
+		break;
+	default:
+		*res = *(u8 *)ptr;
+		break;
 	}
 
 	return 0;
 }
-EXPORT_SYMBOL(sk_run_filter);
+#endif
 
 /**
  *	sk_chk_filter - verify socket filter code
@@ -513,6 +564,7 @@ int sk_attach_filter(struct sock_fprog *fprog, struct sock *sk)
 
 	atomic_set(&fp->refcnt, 1);
 	fp->len = fprog->len;
+	fp->bpf_func = sk_run_filter;
 
 	err = sk_chk_filter(fp->insns, fp->len);
 	if (err) {
@@ -520,6 +572,8 @@ int sk_attach_filter(struct sock_fprog *fprog, struct sock *sk)
 		return err;
 	}
 
+	bpf_jit_compile(fp);
+
 	rcu_read_lock_bh();
 	old_fp = rcu_dereference(sk->sk_filter);
 	rcu_assign_pointer(sk->sk_filter, fp);
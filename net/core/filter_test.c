@@ -0,0 +1,341 @@
+/*
+ * filter_test.c - runs socket filters through both the BPF interpreter
+ * and the JIT, and checks that they agree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * Each filter is run on the same packet twice, once with all of it in the
+ * linear data of the skb and once with most of it in a page fragment, so
+ * that both the inline loads of the JIT and its slow path get exercised.
+ */
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <linux/in.h>
+#include <linux/mm.h>
+#include <linux/netdevice.h>
+#include <linux/skbuff.h>
+#include <linux/slab.h>
+#include <linux/filter.h>
+#include <net/net_namespace.h>
+
+/* a DHCP request, as broadcast by a client */
+static const u8 test_packet[] = {
+	/* ethernet */
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x16,
+	0x3e, 0x00, 0x00, 0x01, 0x08, 0x00,
+	/* IPv4, 192.168.0.1 > 192.168.0.2 */
+	0x45, 0x00, 0x00, 0x32, 0x00, 0x01, 0x00, 0x00,
+	0x40, 0x11, 0x00, 0x00, 0xc0, 0xa8, 0x00, 0x01,
+	0xc0, 0xa8, 0x00, 0x02,
+	/* UDP, 68 > 67 */
+	0x00, 0x44, 0x00, 0x43, 0x00, 0x1e, 0x00, 0x00,
+	/* payload */
+	0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+	0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10,
+	0x11, 0x12, 0x13, 0x14, 0x15, 0x16,
+};
+
+/* where the page fragment starts in the nonlinear skb */
+#define TEST_HEADLEN	20
+
+static struct sock_filter ret_k[] = {
+	BPF_STMT(BPF_RET|BPF_K, 0xffff),
+};
+
+/* tcpdump -dd ip */
+static struct sock_filter ip[] = {
+	BPF_STMT(BPF_LD|BPF_H|BPF_ABS, 12),
+	BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, ETH_P_IP, 0, 1),
+	BPF_STMT(BPF_RET|BPF_K, 0xffff),
+	BPF_STMT(BPF_RET|BPF_K, 0),
+};
+
+/* the IPv4 part of tcpdump -dd udp port 67 */
+static struct sock_filter udp_port[] = {
+	BPF_STMT(BPF_LD|BPF_H|BPF_ABS, 12),
+	BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, ETH_P_IP, 0, 10),
+	BPF_STMT(BPF_LD|BPF_B|BPF_ABS, 23),
+	BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, IPPROTO_UDP, 0, 8),
+	BPF_STMT(BPF_LD|BPF_H|BPF_ABS, 20),
+	BPF_JUMP(BPF_JMP|BPF_JSET|BPF_K, 0x1fff, 6, 0),
+	BPF_STMT(BPF_LDX|BPF_B|BPF_MSH, 14),
+	BPF_STMT(BPF_LD|BPF_H|BPF_IND, 14),
+	BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 67, 2, 0),
+	BPF_STMT(BPF_LD|BPF_H|BPF_IND, 16),
+	BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 67, 0, 1),
+	BPF_STMT(BPF_RET|BPF_K, 0xffff),
+	BPF_STMT(BPF_RET|BPF_K, 0),
+};
+
+static struct sock_filter alu[] = {
+	BPF_STMT(BPF_LD|BPF_W|BPF_ABS, 26),
+	BPF_STMT(BPF_ALU|BPF_ADD|BPF_K, 0x12345678),
+	BPF_STMT(BPF_ALU|BPF_MUL|BPF_K, 3),
+	BPF_STMT(BPF_MISC|BPF_TAX, 0),
+	BPF_STMT(BPF_LD|BPF_W|BPF_ABS, 30),
+	BPF_STMT(BPF_ALU|BPF_SUB|BPF_X, 0),
+	BPF_STMT(BPF_ALU|BPF_DIV|BPF_K, 7),
+	BPF_STMT(BPF_ALU|BPF_OR|BPF_K, 0x80000000),
+	BPF_STMT(BPF_ALU|BPF_RSH|BPF_K, 3),
+	BPF_STMT(BPF_ALU|BPF_LSH|BPF_K, 1),
+	BPF_STMT(BPF_ALU|BPF_AND|BPF_K, 0xfff0fff0),
+	BPF_STMT(BPF_ALU|BPF_NEG, 0),
+	BPF_STMT(BPF_ALU|BPF_ADD|BPF_K, -5),
+	BPF_STMT(BPF_ALU|BPF_SUB|BPF_K, 100000),
+	BPF_STMT(BPF_ALU|BPF_DIV|BPF_K, 16),
+	BPF_STMT(BPF_LDX|BPF_IMM, 13),
+	BPF_STMT(BPF_ALU|BPF_MUL|BPF_X, 0),
+	BPF_STMT(BPF_ALU|BPF_DIV|BPF_X, 0),
+	BPF_STMT(BPF_ALU|BPF_ADD|BPF_X, 0),
+	BPF_STMT(BPF_ALU|BPF_AND|BPF_X, 0),
+	BPF_STMT(BPF_ALU|BPF_OR|BPF_K, 0x8000),
+	BPF_STMT(BPF_ALU|BPF_OR|BPF_X, 0),
+	BPF_STMT(BPF_LDX|BPF_IMM, 5),
+	BPF_STMT(BPF_ALU|BPF_LSH|BPF_X, 0),
+	BPF_STMT(BPF_LDX|BPF_IMM, 9),
+	BPF_STMT(BPF_ALU|BPF_RSH|BPF_X, 0),
+	BPF_STMT(BPF_RET|BPF_A, 0),
+};
+
+static struct sock_filter div_x0[] = {
+	BPF_STMT(BPF_LDX|BPF_IMM, 0),
+	BPF_STMT(BPF_LD|BPF_IMM, 100),
+	BPF_STMT(BPF_ALU|BPF_DIV|BPF_X, 0),
+	BPF_STMT(BPF_RET|BPF_A, 0),
+};
+
+static struct sock_filter mem[] = {
+	BPF_STMT(BPF_LD|BPF_IMM, 1),
+	BPF_STMT(BPF_ST, 0),
+	BPF_STMT(BPF_LD|BPF_IMM, 2),
+	BPF_STMT(BPF_ST, BPF_MEMWORDS - 1),
+	BPF_STMT(BPF_LDX|BPF_MEM, 0),
+	BPF_STMT(BPF_LD|BPF_MEM, BPF_MEMWORDS - 1),
+	BPF_STMT(BPF_ALU|BPF_ADD|BPF_X, 0),
+	BPF_STMT(BPF_STX, 3),
+	BPF_STMT(BPF_MISC|BPF_TAX, 0),
+	BPF_STMT(BPF_LD|BPF_MEM, 3),
+	BPF_STMT(BPF_ALU|BPF_ADD|BPF_X, 0),
+	BPF_STMT(BPF_MISC|BPF_TXA, 0),
+	BPF_STMT(BPF_RET|BPF_A, 0),
+};
+
+static struct sock_filter jumps[] = {
+	BPF_STMT(BPF_LD|BPF_IMM, 0x80000000),
+	BPF_JUMP(BPF_JMP|BPF_JGT|BPF_K, 0x7fffffff, 0, 6),
+	BPF_JUMP(BPF_JMP|BPF_JGE|BPF_K, 0x80000001, 5, 0),
+	BPF_STMT(BPF_LDX|BPF_IMM, 0x80000000),
+	BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_X, 0, 0, 3),
+	BPF_JUMP(BPF_JMP|BPF_JSET|BPF_K, 0x80000000, 0, 2),
+	BPF_JUMP(BPF_JMP|BPF_JGT|BPF_X, 0, 1, 0),
+	BPF_STMT(BPF_JMP|BPF_JA, 1),
+	BPF_STMT(BPF_RET|BPF_K, 1),
+	BPF_STMT(BPF_RET|BPF_K, 2),
+};
+
+static struct sock_filter unaligned[] = {
+	BPF_STMT(BPF_LD|BPF_W|BPF_ABS, 15),
+	BPF_STMT(BPF_MISC|BPF_TAX, 0),
+	BPF_STMT(BPF_LD|BPF_H|BPF_ABS, 17),
+	BPF_STMT(BPF_ALU|BPF_ADD|BPF_X, 0),
+	BPF_STMT(BPF_MISC|BPF_TAX, 0),
+	BPF_STMT(BPF_LDX|BPF_IMM, 3),
+	BPF_STMT(BPF_LD|BPF_W|BPF_IND, 30),
+	BPF_STMT(BPF_RET|BPF_A, 0),
+};
+
+static struct sock_filter len[] = {
+	BPF_STMT(BPF_LD|BPF_W|BPF_LEN, 0),
+	BPF_STMT(BPF_LDX|BPF_W|BPF_LEN, 0),
+	BPF_STMT(BPF_ALU|BPF_ADD|BPF_X, 0),
+	BPF_STMT(BPF_RET|BPF_A, 0),
+};
+
+static struct sock_filter oob_abs[] = {
+	BPF_STMT(BPF_LD|BPF_B|BPF_ABS, 40000),
+	BPF_STMT(BPF_RET|BPF_K, 1),
+};
+
+static struct sock_filter oob_ind[] = {
+	BPF_STMT(BPF_LDX|BPF_IMM, 60),
+	BPF_STMT(BPF_LD|BPF_H|BPF_IND, 4),
+	BPF_STMT(BPF_RET|BPF_K, 1),
+};
+
+static struct sock_filter net_off[] = {
+	BPF_STMT(BPF_LD|BPF_W|BPF_ABS, SKF_NET_OFF + 12),
+	BPF_STMT(BPF_MISC|BPF_TAX, 0),
+	BPF_STMT(BPF_LD|BPF_B|BPF_ABS, SKF_LL_OFF + 6),
+	BPF_STMT(BPF_ALU|BPF_ADD|BPF_X, 0),
+	BPF_STMT(BPF_RET|BPF_A, 0),
+};
+
+static struct sock_filter ancillary[] = {
+	BPF_STMT(BPF_LD|BPF_H|BPF_ABS, SKF_AD_OFF + SKF_AD_PROTOCOL),
+	BPF_STMT(BPF_MISC|BPF_TAX, 0),
+	BPF_STMT(BPF_LD|BPF_B|BPF_ABS, SKF_AD_OFF + SKF_AD_PKTTYPE),
+	BPF_STMT(BPF_ALU|BPF_ADD|BPF_X, 0),
+	BPF_STMT(BPF_MISC|BPF_TAX, 0),
+	BPF_STMT(BPF_LD|BPF_W|BPF_ABS, SKF_AD_OFF + SKF_AD_MARK),
+	BPF_STMT(BPF_ALU|BPF_ADD|BPF_X, 0),
+	BPF_STMT(BPF_MISC|BPF_TAX, 0),
+	BPF_STMT(BPF_LD|BPF_W|BPF_ABS, SKF_AD_OFF + SKF_AD_QUEUE),
+	BPF_STMT(BPF_ALU|BPF_ADD|BPF_X, 0),
+	BPF_STMT(BPF_MISC|BPF_TAX, 0),
+	BPF_STMT(BPF_LD|BPF_W|BPF_ABS, SKF_AD_OFF + SKF_AD_IFINDEX),
+	BPF_STMT(BPF_ALU|BPF_ADD|BPF_X, 0),
+	BPF_STMT(BPF_RET|BPF_A, 0),
+};
+
+/* the ancillary data are reachable through X too... */
+static struct sock_filter ancillary_ind[] = {
+	BPF_STMT(BPF_LDX|BPF_IMM, SKF_AD_OFF),
+	BPF_STMT(BPF_LD|BPF_H|BPF_IND, SKF_AD_PROTOCOL),
+	BPF_STMT(BPF_RET|BPF_A, 0),
+};
+
+/* ...but not through MSH, which makes the filter return 0 */
+static struct sock_filter ancillary_msh[] = {
+	BPF_STMT(BPF_LDX|BPF_B|BPF_MSH, SKF_AD_OFF + SKF_AD_PROTOCOL),
+	BPF_STMT(BPF_RET|BPF_K, 1),
+};
+
+#define TEST_FILTER(f)	{ #f, f, ARRAY_SIZE(f) }
+
+static const struct {
+	const char *name;
+	struct sock_filter *insns;
+	unsigned int len;
+} test_filters[] = {
+	TEST_FILTER(ret_k),
+	TEST_FILTER(ip),
+	TEST_FILTER(udp_port),
+	TEST_FILTER(alu),
+	TEST_FILTER(div_x0),
+	TEST_FILTER(mem),
+	TEST_FILTER(jumps),
+	TEST_FILTER(unaligned),
+	TEST_FILTER(len),
+	TEST_FILTER(oob_abs),
+	TEST_FILTER(oob_ind),
+	TEST_FILTER(net_off),
+	TEST_FILTER(ancillary),
+	TEST_FILTER(ancillary_ind),
+	TEST_FILTER(ancillary_msh),
+};
+
+/* the test packet, with what does not fit in @headlen in a page fragment */
+static struct sk_buff *test_skb(unsigned int headlen)
+{
+	unsigned int rest = sizeof(test_packet) - headlen;
+	struct sk_buff *skb;
+	struct page *page;
+
+	skb = alloc_skb(headlen, GFP_KERNEL);
+	if (!skb)
+		return NULL;
+	memcpy(skb_put(skb, headlen), test_packet, headlen);
+
+	if (rest) {
+		page = alloc_page(GFP_KERNEL);
+		if (!page) {
+			kfree_skb(skb);
+			return NULL;
+		}
+		memcpy(page_address(page), test_packet + headlen, rest);
+		skb_fill_page_desc(skb, 0, page, 0, rest);
+		skb->len += rest;
+		skb->data_len += rest;
+		skb->truesize += rest;
+	}
+
+	skb_reset_mac_header(skb);
+	skb_set_network_header(skb, ETH_HLEN);
+	skb->protocol = htons(ETH_P_IP);
+	skb->pkt_type = PACKET_BROADCAST;
+	skb->mark = 0x12345678;
+	skb_set_queue_mapping(skb, 3);
+	skb->dev = init_net.loopback_dev;
+
+	return skb;
+}
+
+static int __init bpf_jit_selftest(void)
+{
+	struct sk_buff *skb[2];
+	int i, j, jited = 0, errors = 0;
+
+	skb[0] = test_skb(sizeof(test_packet));
+	skb[1] = test_skb(TEST_HEADLEN);
+	if (!skb[0] || !skb[1]) {
+		pr_err("BPF JIT selftest: no memory for the packets\n");
+		goto out;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(test_filters); i++) {
+		unsigned int flen = test_filters[i].len;
+		struct sk_filter *fp;
+		int enable;
+
+		fp = kmalloc(sizeof(*fp) + flen * sizeof(struct sock_filter),
+			     GFP_KERNEL);
+		if (!fp) {
+			errors++;
+			continue;
+		}
+		memcpy(fp->insns, test_filters[i].insns,
+		       flen * sizeof(struct sock_filter));
+		atomic_set(&fp->refcnt, 1);
+		fp->len = flen;
+		fp->bpf_func = sk_run_filter;
+
+		if (sk_chk_filter(fp->insns, fp->len)) {
+			pr_err("BPF JIT selftest: %s: rejected by sk_chk_filter\n",
+			       test_filters[i].name);
+			errors++;
+			kfree(fp);
+			continue;
+		}
+
+		enable = bpf_jit_enable;
+		bpf_jit_enable = 1;
+		bpf_jit_compile(fp);
+		bpf_jit_enable = enable;
+
+		if (fp->bpf_func != sk_run_filter)
+			jited++;
+
+		for (j = 0; j < ARRAY_SIZE(skb); j++) {
+			unsigned int want, got;
+
+			want = sk_run_filter(skb[j], fp->insns, fp->len);
+			got = SK_RUN_FILTER(fp, skb[j]);
+			if (got != want) {
+				pr_err("BPF JIT selftest: %s: %s skb: "
+				       "got %#x instead of %#x\n",
+				       test_filters[i].name,
+				       j ? "nonlinear" : "linear", got, want);
+				errors++;
+			}
+		}
+
+		bpf_jit_free(fp);
+		kfree(fp);
+	}
+
+	if (errors)
+		pr_err("BUG: BPF JIT selftest: %d error(s)\n", errors);
+	else
+		pr_info("BPF JIT selftest passed, %d of %zu filters compiled\n",
+			jited, ARRAY_SIZE(test_filters));
+out:
+	kfree_skb(skb[0]);
+	kfree_skb(skb[1]);
+	return 0;
+}
+late_initcall(bpf_jit_selftest);
@@ -0,0 +1,163 @@
+/*
+ *
+ * futex-hash.c
+ *
+ * hash: Stress the futex hash table
+ *
+ * Many threads, each with its own set of futexes, issue FUTEX_WAIT on
+ * a value that never matches. The syscall returns EWOULDBLOCK straight
+ * away, so what is measured is the cost of hashing the futex key and
+ * taking the hash bucket lock.
+ *
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "../builtin.h"
+#include "bench.h"
+#include "futex.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+static int nthreads;
+static int nfutexes = 1024;
+static int runtime = 10;	/* seconds */
+
+static volatile int done;
+static int threads_starting;
+static pthread_mutex_t thread_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t thread_parent = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t thread_worker = PTHREAD_COND_INITIALIZER;
+
+struct worker {
+	pthread_t		thread;
+	u_int32_t		*futex;
+	unsigned long		ops;
+};
+
+static const struct option options[] = {
+	OPT_INTEGER('t', "threads", &nthreads,
+		    "Number of threads (default: number of CPUs)"),
+	OPT_INTEGER('f', "futexes", &nfutexes,
+		    "Number of futexes per thread"),
+	OPT_INTEGER('r', "runtime", &runtime,
+		    "Runtime in seconds"),
+	OPT_END()
+};
+
+static const char * const bench_futex_hash_usage[] = {
+	"perf bench futex hash <options>",
+	NULL
+};
+
+static void *worker_fn(void *arg)
+{
+	struct worker *w = arg;
+	unsigned long ops = 0;
+	int i;
+
+	pthread_mutex_lock(&thread_lock);
+	if (!--threads_starting)
+		pthread_cond_signal(&thread_parent);
+	pthread_cond_wait(&thread_worker, &thread_lock);
+	pthread_mutex_unlock(&thread_lock);
+
+	do {
+		for (i = 0; i < nfutexes; i++, ops++) {
+			/* *futex is 0, so this never blocks */
+			futex_wait(&w->futex[i], 1234, NULL);
+		}
+	} while (!done);
+
+	w->ops = ops;
+	return NULL;
+}
+
+int bench_futex_hash(int argc, const char **argv,
+		     const char *prefix __used)
+{
+	struct timeval start, stop, diff;
+	unsigned long long total = 0, usecs;
+	struct worker *workers;
+	int i;
+
+	argc = parse_options(argc, argv, options, bench_futex_hash_usage, 0);
+	if (argc)
+		usage_with_options(bench_futex_hash_usage, options);
+
+	if (nthreads <= 0)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nfutexes <= 0 || runtime <= 0)
+		usage_with_options(bench_futex_hash_usage, options);
+
+	workers = zalloc(sizeof(*workers) * nthreads);
+	if (!workers)
+		die("cannot allocate %d workers\n", nthreads);
+
+	threads_starting = nthreads;
+	for (i = 0; i < nthreads; i++) {
+		workers[i].futex = zalloc(sizeof(u_int32_t) * nfutexes);
+		if (!workers[i].futex)
+			die("cannot allocate %d futexes\n", nfutexes);
+		if (pthread_create(&workers[i].thread, NULL,
+				   worker_fn, &workers[i]))
+			die("pthread_create failed: %s\n", strerror(errno));
+	}
+
+	pthread_mutex_lock(&thread_lock);
+	while (threads_starting)
+		pthread_cond_wait(&thread_parent, &thread_lock);
+	gettimeofday(&start, NULL);
+	pthread_cond_broadcast(&thread_worker);
+	pthread_mutex_unlock(&thread_lock);
+
+	sleep(runtime);
+	done = 1;
+
+	for (i = 0; i < nthreads; i++) {
+		pthread_join(workers[i].thread, NULL);
+		total += workers[i].ops;
+	}
+	gettimeofday(&stop, NULL);
+	timersub(&stop, &start, &diff);
+	usecs = timeval_usecs(&diff);
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf("# %d threads, %d futexes per thread, %d secs\n\n",
+		       nthreads, nfutexes, runtime);
+
+		for (i = 0; i < nthreads; i++)
+			printf(" [thread %3d] %14.0lf ops/sec\n", i,
+			       (double)workers[i].ops * 1000000.0 /
+			       (double)usecs);
+
+		printf("\n %14.0lf ops/sec (total)\n",
+		       (double)total * 1000000.0 / (double)usecs);
+		printf(" %14.3lf usecs/op (per thread)\n",
+		       (double)usecs * nthreads / (double)total);
+		break;
+
+	case BENCH_FORMAT_SIMPLE:
+		printf("%.0lf\n", (double)total * 1000000.0 / (double)usecs);
+		break;
+
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+		break;
+	}
+
+	for (i = 0; i < nthreads; i++)
+		free(workers[i].futex);
+	free(workers);
+
+	return 0;
+}
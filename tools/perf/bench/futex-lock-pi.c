@@ -0,0 +1,164 @@
+/*
+ *
+ * futex-lock-pi.c
+ *
+ * lock-pi: Measure FUTEX_LOCK_PI/FUTEX_UNLOCK_PI contention
+ *
+ * A number of threads acquire and release the same PI futex in a loop,
+ * always entering the kernel, so that the rtmutex based slow path and
+ * the lock handoff between owners are what gets measured.
+ *
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "../builtin.h"
+#include "bench.h"
+#include "futex.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+static int nthreads;
+static int runtime = 10;	/* seconds */
+static int hold_usecs;
+
+static u_int32_t futex1;
+
+static volatile int done;
+static int threads_starting;
+static pthread_mutex_t thread_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t thread_parent = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t thread_worker = PTHREAD_COND_INITIALIZER;
+
+struct worker {
+	pthread_t		thread;
+	unsigned long		ops;
+	unsigned long		errors;
+};
+
+static const struct option options[] = {
+	OPT_INTEGER('t', "threads", &nthreads,
+		    "Number of threads (default: number of CPUs)"),
+	OPT_INTEGER('r', "runtime", &runtime,
+		    "Runtime in seconds"),
+	OPT_INTEGER('H', "hold", &hold_usecs,
+		    "Usecs to hold the lock for (default: 0)"),
+	OPT_END()
+};
+
+static const char * const bench_futex_lock_pi_usage[] = {
+	"perf bench futex lock-pi <options>",
+	NULL
+};
+
+static void *worker_fn(void *arg)
+{
+	struct worker *w = arg;
+
+	pthread_mutex_lock(&thread_lock);
+	if (!--threads_starting)
+		pthread_cond_signal(&thread_parent);
+	pthread_cond_wait(&thread_worker, &thread_lock);
+	pthread_mutex_unlock(&thread_lock);
+
+	do {
+		if (futex_lock_pi(&futex1, NULL)) {
+			w->errors++;
+			continue;
+		}
+
+		if (hold_usecs)
+			usleep(hold_usecs);
+
+		if (futex_unlock_pi(&futex1))
+			w->errors++;
+		w->ops++;
+	} while (!done);
+
+	return NULL;
+}
+
+int bench_futex_lock_pi(int argc, const char **argv,
+			const char *prefix __used)
+{
+	struct timeval start, stop, diff;
+	unsigned long long total = 0, errors = 0, usecs;
+	struct worker *workers;
+	int i;
+
+	argc = parse_options(argc, argv, options,
+			     bench_futex_lock_pi_usage, 0);
+	if (argc)
+		usage_with_options(bench_futex_lock_pi_usage, options);
+
+	if (nthreads <= 0)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (runtime <= 0 || hold_usecs < 0)
+		usage_with_options(bench_futex_lock_pi_usage, options);
+
+	workers = zalloc(sizeof(*workers) * nthreads);
+	if (!workers)
+		die("cannot allocate %d workers\n", nthreads);
+
+	threads_starting = nthreads;
+	for (i = 0; i < nthreads; i++)
+		if (pthread_create(&workers[i].thread, NULL,
+				   worker_fn, &workers[i]))
+			die("pthread_create failed: %s\n", strerror(errno));
+
+	pthread_mutex_lock(&thread_lock);
+	while (threads_starting)
+		pthread_cond_wait(&thread_parent, &thread_lock);
+	gettimeofday(&start, NULL);
+	pthread_cond_broadcast(&thread_worker);
+	pthread_mutex_unlock(&thread_lock);
+
+	sleep(runtime);
+	done = 1;
+
+	for (i = 0; i < nthreads; i++) {
+		pthread_join(workers[i].thread, NULL);
+		total += workers[i].ops;
+		errors += workers[i].errors;
+	}
+	gettimeofday(&stop, NULL);
+	timersub(&stop, &start, &diff);
+	usecs = timeval_usecs(&diff);
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf("# %d threads contending for PI futex %p, %d secs\n\n",
+		       nthreads, &futex1, runtime);
+
+		for (i = 0; i < nthreads; i++)
+			printf(" [thread %3d] %14.0lf ops/sec\n", i,
+			       (double)workers[i].ops * 1000000.0 /
+			       (double)usecs);
+
+		printf("\n %14.0lf ops/sec (total)\n",
+		       (double)total * 1000000.0 / (double)usecs);
+		printf(" %14.3lf usecs/op\n", (double)usecs / (double)total);
+		if (errors)
+			printf(" %14llu failed lock/unlock calls\n", errors);
+		break;
+
+	case BENCH_FORMAT_SIMPLE:
+		printf("%.0lf\n", (double)total * 1000000.0 / (double)usecs);
+		break;
+
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+		break;
+	}
+
+	free(workers);
+	return 0;
+}
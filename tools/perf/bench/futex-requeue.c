@@ -0,0 +1,173 @@
+/*
+ *
+ * futex-requeue.c
+ *
+ * requeue: Measure FUTEX_CMP_REQUEUE
+ *
+ * This is what a pthread_cond_broadcast() boils down to: the threads
+ * blocked on the condvar futex are moved over to the mutex futex
+ * without being woken up, so that they do not all stampede on the
+ * mutex. Only the requeueing is timed.
+ *
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "../builtin.h"
+#include "bench.h"
+#include "futex.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+static int nthreads;
+static int nr_requeue = 1;
+static int repeat = 10;
+
+static u_int32_t futex1, futex2;
+
+static int threads_starting;
+static pthread_mutex_t thread_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t thread_parent = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t thread_worker = PTHREAD_COND_INITIALIZER;
+
+static const struct option options[] = {
+	OPT_INTEGER('t', "threads", &nthreads,
+		    "Number of waiting threads (default: number of CPUs)"),
+	OPT_INTEGER('q', "nrequeue", &nr_requeue,
+		    "Number of threads to requeue per FUTEX_CMP_REQUEUE call"),
+	OPT_INTEGER('r', "repeat", &repeat,
+		    "Number of times to repeat the test"),
+	OPT_END()
+};
+
+static const char * const bench_futex_requeue_usage[] = {
+	"perf bench futex requeue <options>",
+	NULL
+};
+
+static void *waiter_fn(void *arg __used)
+{
+	pthread_mutex_lock(&thread_lock);
+	if (!--threads_starting)
+		pthread_cond_signal(&thread_parent);
+	pthread_cond_wait(&thread_worker, &thread_lock);
+	pthread_mutex_unlock(&thread_lock);
+
+	futex_wait(&futex1, 0, NULL);
+	return NULL;
+}
+
+static void block_threads(pthread_t *w)
+{
+	int i;
+
+	threads_starting = nthreads;
+	for (i = 0; i < nthreads; i++)
+		if (pthread_create(&w[i], NULL, waiter_fn, NULL))
+			die("pthread_create failed: %s\n", strerror(errno));
+
+	pthread_mutex_lock(&thread_lock);
+	while (threads_starting)
+		pthread_cond_wait(&thread_parent, &thread_lock);
+	pthread_cond_broadcast(&thread_worker);
+	pthread_mutex_unlock(&thread_lock);
+
+	/* give the waiters a chance to actually block in the kernel */
+	usleep(100000);
+}
+
+int bench_futex_requeue(int argc, const char **argv,
+			const char *prefix __used)
+{
+	struct timeval start, stop, diff;
+	unsigned long long usecs, total_usecs = 0;
+	unsigned long calls, total_calls = 0;
+	int i, j, ret, moved, woken;
+	pthread_t *waiters;
+
+	argc = parse_options(argc, argv, options,
+			     bench_futex_requeue_usage, 0);
+	if (argc)
+		usage_with_options(bench_futex_requeue_usage, options);
+
+	if (nthreads <= 0)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nr_requeue <= 0 || repeat <= 0)
+		usage_with_options(bench_futex_requeue_usage, options);
+
+	waiters = zalloc(sizeof(*waiters) * nthreads);
+	if (!waiters)
+		die("cannot allocate %d threads\n", nthreads);
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# %d threads waiting on futex %p,"
+		       " requeueing %d at a time to futex %p\n\n",
+		       nthreads, &futex1, nr_requeue, &futex2);
+
+	for (j = 0; j < repeat; j++) {
+		block_threads(waiters);
+
+		moved = 0;
+		calls = 0;
+		gettimeofday(&start, NULL);
+		while (moved < nthreads) {
+			ret = futex_cmp_requeue(&futex1, 0, &futex2,
+						0, nr_requeue);
+			if (ret < 0)
+				die("FUTEX_CMP_REQUEUE failed: %s\n",
+				    strerror(errno));
+			moved += ret;
+			calls++;
+		}
+		gettimeofday(&stop, NULL);
+		timersub(&stop, &start, &diff);
+
+		usecs = timeval_usecs(&diff);
+		total_usecs += usecs;
+		total_calls += calls;
+
+		if (bench_format == BENCH_FORMAT_DEFAULT)
+			printf(" [run %3d] requeued %d of %d threads in"
+			       " %llu usecs (%lu calls)\n", j + 1, moved,
+			       nthreads, usecs, calls);
+
+		/* now let everybody go from the second futex */
+		woken = 0;
+		while (woken < nthreads)
+			woken += futex_wake(&futex2, nthreads);
+
+		for (i = 0; i < nthreads; i++)
+			pthread_join(waiters[i], NULL);
+	}
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf("\n %14.3lf usecs to requeue %d threads (avg)\n",
+		       (double)total_usecs / repeat, nthreads);
+		printf(" %14.3lf usecs/op\n",
+		       (double)total_usecs / total_calls);
+		printf(" %14.0lf ops/sec\n",
+		       total_usecs ? (double)total_calls * 1000000.0 /
+		       (double)total_usecs : 0.0);
+		break;
+
+	case BENCH_FORMAT_SIMPLE:
+		printf("%.3lf\n", (double)total_usecs / repeat);
+		break;
+
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+		break;
+	}
+
+	free(waiters);
+	return 0;
+}
@@ -0,0 +1,201 @@
+/*
+ *
+ * futex-wake-parallel.c
+ *
+ * wake-parallel: Measure concurrent FUTEX_WAKE
+ *
+ * Like "wake", but the blocked threads are woken up by several waker
+ * threads at the same time, each responsible for its own share of the
+ * waiters. This exposes contention on the futex hash bucket lock
+ * between wakers.
+ *
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "../builtin.h"
+#include "bench.h"
+#include "futex.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+static int nthreads;
+static int nwakers = 1;
+static int repeat = 10;
+
+static u_int32_t futex1;
+
+static int threads_starting;
+static pthread_mutex_t thread_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t thread_parent = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t thread_worker = PTHREAD_COND_INITIALIZER;
+
+struct waker {
+	pthread_t		thread;
+	int			nr_wake;
+	unsigned long long	usecs;
+	unsigned long		calls;
+};
+
+static const struct option options[] = {
+	OPT_INTEGER('t', "threads", &nthreads,
+		    "Number of waiting threads (default: number of CPUs)"),
+	OPT_INTEGER('w', "nwakers", &nwakers,
+		    "Number of concurrent waker threads"),
+	OPT_INTEGER('r', "repeat", &repeat,
+		    "Number of times to repeat the test"),
+	OPT_END()
+};
+
+static const char * const bench_futex_wake_parallel_usage[] = {
+	"perf bench futex wake-parallel <options>",
+	NULL
+};
+
+static void wait_for_start(void)
+{
+	pthread_mutex_lock(&thread_lock);
+	if (!--threads_starting)
+		pthread_cond_signal(&thread_parent);
+	pthread_cond_wait(&thread_worker, &thread_lock);
+	pthread_mutex_unlock(&thread_lock);
+}
+
+/* Let the started threads go and prepare for the next batch of n */
+static void release_threads(int n)
+{
+	pthread_mutex_lock(&thread_lock);
+	while (threads_starting)
+		pthread_cond_wait(&thread_parent, &thread_lock);
+	pthread_cond_broadcast(&thread_worker);
+	threads_starting = n;
+	pthread_mutex_unlock(&thread_lock);
+}
+
+static void *waiter_fn(void *arg __used)
+{
+	wait_for_start();
+	futex_wait(&futex1, 0, NULL);
+	return NULL;
+}
+
+static void *waker_fn(void *arg)
+{
+	struct waker *w = arg;
+	struct timeval start, stop, diff;
+	int woken = 0;
+
+	wait_for_start();
+
+	gettimeofday(&start, NULL);
+	while (woken < w->nr_wake) {
+		woken += futex_wake(&futex1, w->nr_wake - woken);
+		w->calls++;
+	}
+	gettimeofday(&stop, NULL);
+	timersub(&stop, &start, &diff);
+	w->usecs = timeval_usecs(&diff);
+
+	return NULL;
+}
+
+int bench_futex_wake_parallel(int argc, const char **argv,
+			      const char *prefix __used)
+{
+	unsigned long long run_usecs, total_usecs = 0;
+	unsigned long total_calls = 0;
+	struct waker *wakers;
+	pthread_t *waiters;
+	int i, j;
+
+	argc = parse_options(argc, argv, options,
+			     bench_futex_wake_parallel_usage, 0);
+	if (argc)
+		usage_with_options(bench_futex_wake_parallel_usage, options);
+
+	if (nthreads <= 0)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nwakers <= 0 || nwakers > nthreads || repeat <= 0)
+		usage_with_options(bench_futex_wake_parallel_usage, options);
+
+	waiters = zalloc(sizeof(*waiters) * nthreads);
+	wakers = zalloc(sizeof(*wakers) * nwakers);
+	if (!waiters || !wakers)
+		die("cannot allocate thread descriptors\n");
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# %d threads waiting on futex %p, %d waker threads\n\n",
+		       nthreads, &futex1, nwakers);
+
+	for (j = 0; j < repeat; j++) {
+		threads_starting = nthreads;
+		for (i = 0; i < nthreads; i++)
+			if (pthread_create(&waiters[i], NULL, waiter_fn, NULL))
+				die("pthread_create failed: %s\n",
+				    strerror(errno));
+		release_threads(nwakers);
+
+		/* give the waiters a chance to actually block in the kernel */
+		usleep(100000);
+
+		for (i = 0; i < nwakers; i++) {
+			/* the first waker picks up the remainder */
+			wakers[i].nr_wake = nthreads / nwakers +
+				(i ? 0 : nthreads % nwakers);
+			wakers[i].calls = 0;
+			if (pthread_create(&wakers[i].thread, NULL,
+					   waker_fn, &wakers[i]))
+				die("pthread_create failed: %s\n",
+				    strerror(errno));
+		}
+		release_threads(0);
+
+		run_usecs = 0;
+		for (i = 0; i < nwakers; i++) {
+			pthread_join(wakers[i].thread, NULL);
+			if (wakers[i].usecs > run_usecs)
+				run_usecs = wakers[i].usecs;
+			total_calls += wakers[i].calls;
+		}
+		total_usecs += run_usecs;
+
+		if (bench_format == BENCH_FORMAT_DEFAULT)
+			printf(" [run %3d] woke up %d threads in %llu usecs\n",
+			       j + 1, nthreads, run_usecs);
+
+		for (i = 0; i < nthreads; i++)
+			pthread_join(waiters[i], NULL);
+	}
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf("\n %14.3lf usecs to wake %d threads (avg)\n",
+		       (double)total_usecs / repeat, nthreads);
+		printf(" %14.3lf usecs/op\n",
+		       (double)total_usecs * nwakers / total_calls);
+		printf(" %14.0lf ops/sec\n",
+		       total_usecs ? (double)total_calls * 1000000.0 /
+		       (double)total_usecs : 0.0);
+		break;
+
+	case BENCH_FORMAT_SIMPLE:
+		printf("%.3lf\n", (double)total_usecs / repeat);
+		break;
+
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+		break;
+	}
+
+	free(wakers);
+	free(waiters);
+	return 0;
+}
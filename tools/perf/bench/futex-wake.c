@@ -0,0 +1,159 @@
+/*
+ *
+ * futex-wake.c
+ *
+ * wake: Measure FUTEX_WAKE
+ *
+ * A number of threads block on a single futex, then the main thread
+ * wakes them all up, nr_wake at a time, and measures how long it took.
+ *
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "../builtin.h"
+#include "bench.h"
+#include "futex.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+static int nthreads;
+static int nr_wake = 1;
+static int repeat = 10;
+
+static u_int32_t futex1;
+
+static int threads_starting;
+static pthread_mutex_t thread_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t thread_parent = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t thread_worker = PTHREAD_COND_INITIALIZER;
+
+static const struct option options[] = {
+	OPT_INTEGER('t', "threads", &nthreads,
+		    "Number of waiting threads (default: number of CPUs)"),
+	OPT_INTEGER('w', "nwakes", &nr_wake,
+		    "Number of threads to wake per FUTEX_WAKE call"),
+	OPT_INTEGER('r', "repeat", &repeat,
+		    "Number of times to repeat the test"),
+	OPT_END()
+};
+
+static const char * const bench_futex_wake_usage[] = {
+	"perf bench futex wake <options>",
+	NULL
+};
+
+static void *waiter_fn(void *arg __used)
+{
+	pthread_mutex_lock(&thread_lock);
+	if (!--threads_starting)
+		pthread_cond_signal(&thread_parent);
+	pthread_cond_wait(&thread_worker, &thread_lock);
+	pthread_mutex_unlock(&thread_lock);
+
+	futex_wait(&futex1, 0, NULL);
+	return NULL;
+}
+
+static void block_threads(pthread_t *w)
+{
+	int i;
+
+	threads_starting = nthreads;
+	for (i = 0; i < nthreads; i++)
+		if (pthread_create(&w[i], NULL, waiter_fn, NULL))
+			die("pthread_create failed: %s\n", strerror(errno));
+
+	pthread_mutex_lock(&thread_lock);
+	while (threads_starting)
+		pthread_cond_wait(&thread_parent, &thread_lock);
+	pthread_cond_broadcast(&thread_worker);
+	pthread_mutex_unlock(&thread_lock);
+
+	/* give the waiters a chance to actually block in the kernel */
+	usleep(100000);
+}
+
+int bench_futex_wake(int argc, const char **argv,
+		     const char *prefix __used)
+{
+	struct timeval start, stop, diff;
+	unsigned long long usecs, total_usecs = 0;
+	unsigned long calls, total_calls = 0;
+	int i, j, woken;
+	pthread_t *waiters;
+
+	argc = parse_options(argc, argv, options, bench_futex_wake_usage, 0);
+	if (argc)
+		usage_with_options(bench_futex_wake_usage, options);
+
+	if (nthreads <= 0)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nr_wake <= 0 || repeat <= 0)
+		usage_with_options(bench_futex_wake_usage, options);
+
+	waiters = zalloc(sizeof(*waiters) * nthreads);
+	if (!waiters)
+		die("cannot allocate %d threads\n", nthreads);
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# %d threads waiting on futex %p, waking %d at a time\n\n",
+		       nthreads, &futex1, nr_wake);
+
+	for (j = 0; j < repeat; j++) {
+		block_threads(waiters);
+
+		woken = 0;
+		calls = 0;
+		gettimeofday(&start, NULL);
+		while (woken < nthreads) {
+			woken += futex_wake(&futex1, nr_wake);
+			calls++;
+		}
+		gettimeofday(&stop, NULL);
+		timersub(&stop, &start, &diff);
+
+		usecs = timeval_usecs(&diff);
+		total_usecs += usecs;
+		total_calls += calls;
+
+		if (bench_format == BENCH_FORMAT_DEFAULT)
+			printf(" [run %3d] woke up %d of %d threads in %llu usecs"
+			       " (%lu calls)\n", j + 1, woken, nthreads,
+			       usecs, calls);
+
+		for (i = 0; i < nthreads; i++)
+			pthread_join(waiters[i], NULL);
+	}
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf("\n %14.3lf usecs to wake %d threads (avg)\n",
+		       (double)total_usecs / repeat, nthreads);
+		printf(" %14.3lf usecs/op\n",
+		       (double)total_usecs / total_calls);
+		printf(" %14.0lf ops/sec\n",
+		       total_usecs ? (double)total_calls * 1000000.0 /
+		       (double)total_usecs : 0.0);
+		break;
+
+	case BENCH_FORMAT_SIMPLE:
+		printf("%.3lf\n", (double)total_usecs / repeat);
+		break;
+
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+		break;
+	}
+
+	free(waiters);
+	return 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * futex.h
+ *
+ * Glibc does not provide wrappers for the futex syscall, so the futex
+ * benchmarks use these thin inline ones.
+ */
+#ifndef _FUTEX_H
+#define _FUTEX_H
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <linux/futex.h>
+
+/* Every benchmark uses process private futexes, like pthread does */
+#define FUTEX_PRIVATE(op)	((op) | FUTEX_PRIVATE_FLAG)
+
+static inline int
+sys_futex(u_int32_t *uaddr, int op, int val,
+	  const struct timespec *timeout, u_int32_t *uaddr2, int val3)
+{
+	return syscall(SYS_futex, uaddr, FUTEX_PRIVATE(op), val, timeout,
+		       uaddr2, val3);
+}
+
+/* Block while *uaddr == val */
+static inline int
+futex_wait(u_int32_t *uaddr, int val, const struct timespec *timeout)
+{
+	return sys_futex(uaddr, FUTEX_WAIT, val, timeout, NULL, 0);
+}
+
+/* Wake up to nr_wake tasks blocked on uaddr */
+static inline int
+futex_wake(u_int32_t *uaddr, int nr_wake)
+{
+	return sys_futex(uaddr, FUTEX_WAKE, nr_wake, NULL, NULL, 0);
+}
+
+/*
+ * Wake up to nr_wake tasks blocked on uaddr and move up to nr_requeue
+ * of the remaining ones to uaddr2, provided *uaddr still equals val.
+ */
+static inline int
+futex_cmp_requeue(u_int32_t *uaddr, int val, u_int32_t *uaddr2,
+		  int nr_wake, int nr_requeue)
+{
+	return sys_futex(uaddr, FUTEX_CMP_REQUEUE, nr_wake,
+			 (struct timespec *)(long)nr_requeue, uaddr2, val);
+}
+
+/* Acquire a PI futex, always going through the kernel */
+static inline int
+futex_lock_pi(u_int32_t *uaddr, const struct timespec *timeout)
+{
+	return sys_futex(uaddr, FUTEX_LOCK_PI, 0, timeout, NULL, 0);
+}
+
+static inline int
+futex_unlock_pi(u_int32_t *uaddr)
+{
+	return sys_futex(uaddr, FUTEX_UNLOCK_PI, 0, NULL, NULL, 0);
+}
+
+static inline unsigned long long timeval_usecs(struct timeval *tv)
+{
+	return (unsigned long long)tv->tv_sec * 1000000ULL + tv->tv_usec;
+}
+
+#endif /* _FUTEX_H */
@@ -0,0 +1,172 @@
+/*
+ * mem-tlb.c
+ *
+ * tlb: Chase pointers across pages to measure the cost of TLB misses
+ *
+ * Every page of the buffer holds the offset of the next page to visit,
+ * in a random order, so every load depends on the previous one and, once
+ * the buffer spans more than the TLB maps, nearly every load takes a TLB
+ * refill.  Running it once with 4kB/16kB pages and once with --huge shows
+ * what huge pages save.
+ */
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "../util/string.h"
+#include "../util/header.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <errno.h>
+
+static const char	*length_str	= "64MB";
+static int		loops		= 16;
+static int		use_huge	= 0;
+
+static const struct option options[] = {
+	OPT_STRING('l', "length", &length_str, "64MB",
+		    "Specify length of memory to walk. "
+		    "available unit: B, MB, GB (upper and lower)"),
+	OPT_INTEGER('L', "loops", &loops,
+		    "Specify number of walks over all the pages"),
+	OPT_BOOLEAN('H', "huge", &use_huge,
+		    "Use huge pages (MAP_HUGETLB) for the buffer"),
+	OPT_END()
+};
+
+static const char * const bench_mem_tlb_usage[] = {
+	"perf bench mem tlb <options>",
+	NULL
+};
+
+/*
+ * Link the pages into one cycle in a random order: each page stores the
+ * byte offset of the page that follows it in order[].
+ */
+static void link_pages(char *buf, size_t nr_pages, size_t page_size)
+{
+	size_t *order;
+	size_t i;
+
+	order = malloc(nr_pages * sizeof(*order));
+	if (!order)
+		die("memory allocation failed\n");
+
+	for (i = 0; i < nr_pages; i++)
+		order[i] = i;
+
+	srand(1);
+	for (i = nr_pages - 1; i > 0; i--) {
+		size_t j = (size_t)rand() % (i + 1);
+		size_t tmp = order[i];
+
+		order[i] = order[j];
+		order[j] = tmp;
+	}
+
+	for (i = 0; i < nr_pages; i++)
+		*(size_t *)(buf + order[i] * page_size) =
+			order[(i + 1) % nr_pages] * page_size;
+
+	free(order);
+}
+
+static size_t walk_pages(char *buf, u64 nr)
+{
+	size_t off = 0;
+
+	while (nr--)
+		off = *(volatile size_t *)(buf + off);
+
+	return off;
+}
+
+int bench_mem_tlb(int argc, const char **argv,
+		  const char *prefix __used)
+{
+	struct timeval tv_start, tv_end, tv_diff;
+	size_t length, page_size, nr_pages;
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+	double nsecs;
+	char *buf;
+	u64 nr;
+
+	argc = parse_options(argc, argv, options, bench_mem_tlb_usage, 0);
+
+	length = (size_t)perf_atoll((char *)length_str);
+	if ((s64)length <= 0) {
+		fprintf(stderr, "Invalid length:%s\n", length_str);
+		return 1;
+	}
+	if (loops <= 0) {
+		fprintf(stderr, "Invalid number of loops:%d\n", loops);
+		return 1;
+	}
+
+	/*
+	 * Touch one word per base page either way: with huge pages, the
+	 * walk then stays inside a few TLB entries.
+	 */
+	page_size = sysconf(_SC_PAGESIZE);
+	if (use_huge) {
+#ifdef MAP_HUGETLB
+		flags |= MAP_HUGETLB;
+#else
+		die("MAP_HUGETLB is not supported by the C library\n");
+#endif
+	}
+
+	nr_pages = length / page_size;
+	if (nr_pages < 2) {
+		fprintf(stderr, "Length %s is less than two pages\n",
+			length_str);
+		return 1;
+	}
+
+	buf = mmap(NULL, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (buf == MAP_FAILED)
+		die("mmap failed: %s%s\n", strerror(errno),
+		    use_huge ? " - are huge pages reserved in "
+			       "/proc/sys/vm/nr_hugepages?" : "");
+
+	/* This also faults all the pages in, outside the measurement */
+	link_pages(buf, nr_pages, page_size);
+
+	if (bench_format == BENCH_FORMAT_DEFAULT) {
+		printf("# Walking %lu pages of %lu Bytes, %d times%s ...\n\n",
+		       (unsigned long)nr_pages, (unsigned long)page_size,
+		       loops, use_huge ? ", in huge pages" : "");
+	}
+
+	nr = (u64)nr_pages * loops;
+
+	BUG_ON(gettimeofday(&tv_start, NULL));
+	walk_pages(buf, nr);
+	BUG_ON(gettimeofday(&tv_end, NULL));
+
+	timersub(&tv_end, &tv_start, &tv_diff);
+	nsecs = ((double)tv_diff.tv_sec * 1000000000.0 +
+		 (double)tv_diff.tv_usec * 1000.0) / (double)nr;
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf(" %14lf nsecs/access\n", nsecs);
+		break;
+	case BENCH_FORMAT_SIMPLE:
+		printf("%lf\n", nsecs);
+		break;
+	default:
+		/* reaching this means there's some disaster: */
+		die("unknown format: %d\n", bench_format);
+		break;
+	}
+
+	munmap(buf, length);
+
+	return 0;
+}
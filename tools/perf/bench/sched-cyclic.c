@@ -0,0 +1,317 @@
+/*
+ *
+ * sched-cyclic.c
+ *
+ * cyclic: Benchmark for timer wakeup latency
+ *
+ * Modelled after cyclictest from rt-tests by Thomas Gleixner:
+ * one SCHED_FIFO thread per CPU sleeps until an absolute deadline with
+ * clock_nanosleep(TIMER_ABSTIME) and measures how late it woke up.
+ *
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "../util/debugfs.h"
+#include "../builtin.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#define NSEC_PER_USEC		1000ULL
+
+#define HIST_BUCKETS		100	/* in usecs, last one is overflow */
+
+static int nr_threads;
+static int priority = 80;
+static int interval = 1000;	/* usecs */
+static int loops = 10000;
+static int breaktrace;		/* usecs, 0 == never */
+static int show_hist;
+
+static int tracing_on_fd = -1;
+static volatile int done;
+
+struct cyclic_thread {
+	pthread_t		thread;
+	int			cpu;
+	int			err;
+	unsigned long		cycles;
+	unsigned long long	min;
+	unsigned long long	max;
+	unsigned long long	sum;
+	unsigned long		hist[HIST_BUCKETS];
+};
+
+static struct cyclic_thread *threads;
+
+static const struct option options[] = {
+	OPT_INTEGER('t', "threads", &nr_threads,
+		    "Number of measurement threads (default: one per CPU)"),
+	OPT_INTEGER('p', "prio", &priority,
+		    "SCHED_FIFO priority of the measurement threads"),
+	OPT_INTEGER('i', "interval", &interval,
+		    "Wakeup interval in usecs"),
+	OPT_INTEGER('l', "loops", &loops,
+		    "Number of wakeups per thread"),
+	OPT_INTEGER('b', "breaktrace", &breaktrace,
+		    "Stop tracing when a latency above this many usecs is seen"),
+	OPT_BOOLEAN('H', "histogram", &show_hist,
+		    "Print the histogram of wakeup latencies"),
+	OPT_END()
+};
+
+static const char * const bench_sched_cyclic_usage[] = {
+	"perf bench sched cyclic <options>",
+	NULL
+};
+
+static inline unsigned long long ts_to_ns(struct timespec *ts)
+{
+	return (unsigned long long)ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+static inline void ts_add_ns(struct timespec *ts, long long ns)
+{
+	ts->tv_nsec += ns;
+	while (ts->tv_nsec >= (long)NSEC_PER_SEC) {
+		ts->tv_nsec -= (long)NSEC_PER_SEC;
+		ts->tv_sec++;
+	}
+}
+
+static void open_tracing_on(void)
+{
+	const char *debugfs;
+	char path[MAX_PATH+1];
+
+	debugfs = debugfs_find_mountpoint();
+	if (!debugfs) {
+		fprintf(stderr, "debugfs is not mounted, ignoring --breaktrace\n");
+		return;
+	}
+
+	snprintf(path, sizeof(path), "%s/tracing/tracing_on", debugfs);
+	tracing_on_fd = open(path, O_WRONLY);
+	if (tracing_on_fd < 0)
+		fprintf(stderr, "cannot open %s: %s, ignoring --breaktrace\n",
+			path, strerror(errno));
+}
+
+static void stop_tracing(void)
+{
+	int ret;
+
+	if (tracing_on_fd < 0)
+		return;
+	/* keep the trace right at the point where the latency happened */
+	ret = write(tracing_on_fd, "0", 1);
+	if (ret != 1)
+		fprintf(stderr, "cannot stop tracing: %s\n", strerror(errno));
+}
+
+static void *cyclic_thread_fn(void *arg)
+{
+	struct cyclic_thread *t = arg;
+	struct sched_param param = { .sched_priority = priority };
+	struct timespec next, now;
+	unsigned long long lat;
+	cpu_set_t mask;
+	int i, ret;
+
+	CPU_ZERO(&mask);
+	CPU_SET(t->cpu, &mask);
+	if (sched_setaffinity(0, sizeof(mask), &mask))
+		fprintf(stderr, "cannot bind thread to CPU%d: %s\n",
+			t->cpu, strerror(errno));
+
+	/* the pthread calls return the error instead of setting errno */
+	ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+	if (ret) {
+		t->err = ret;
+		return NULL;
+	}
+
+	t->min = ~0ULL;
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	ts_add_ns(&next, interval * NSEC_PER_USEC);
+
+	for (i = 0; i < loops && !done; i++) {
+		/* so does clock_nanosleep(), which is simply restarted */
+		do {
+			ret = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+					      &next, NULL);
+		} while (ret == EINTR);
+		if (ret) {
+			t->err = ret;
+			break;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		lat = ts_to_ns(&now) - ts_to_ns(&next);
+		if (ts_to_ns(&now) < ts_to_ns(&next))
+			lat = 0;
+
+		if (lat < t->min)
+			t->min = lat;
+		if (lat > t->max)
+			t->max = lat;
+		t->sum += lat;
+		t->cycles++;
+
+		lat /= NSEC_PER_USEC;
+		t->hist[lat < HIST_BUCKETS ? lat : HIST_BUCKETS - 1]++;
+
+		if (breaktrace && lat >= (unsigned long long)breaktrace) {
+			stop_tracing();
+			done = 1;
+		}
+
+		ts_add_ns(&next, interval * NSEC_PER_USEC);
+	}
+
+	return NULL;
+}
+
+static void print_hist(void)
+{
+	int i, j;
+
+	printf("\n# Histogram (usecs: count per thread)\n");
+	for (i = 0; i < HIST_BUCKETS; i++) {
+		unsigned long sum = 0;
+
+		for (j = 0; j < nr_threads; j++)
+			sum += threads[j].hist[i];
+		if (!sum)
+			continue;
+
+		printf("%s%03d", i == HIST_BUCKETS - 1 ? ">=" : "  ", i);
+		for (j = 0; j < nr_threads; j++)
+			printf(" %8lu", threads[j].hist[i]);
+		printf("\n");
+	}
+}
+
+int bench_sched_cyclic(int argc, const char **argv,
+		       const char *prefix __used)
+{
+	unsigned long long min = ~0ULL, max = 0, sum = 0;
+	unsigned long cycles = 0;
+	int i, nr_cpus, err = 0;
+
+	argc = parse_options(argc, argv, options,
+			     bench_sched_cyclic_usage, 0);
+	if (argc)
+		usage_with_options(bench_sched_cyclic_usage, options);
+
+	nr_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nr_threads <= 0)
+		nr_threads = nr_cpus;
+	if (interval <= 0 || loops <= 0 ||
+	    priority < sched_get_priority_min(SCHED_FIFO) ||
+	    priority > sched_get_priority_max(SCHED_FIFO))
+		usage_with_options(bench_sched_cyclic_usage, options);
+
+	if (breaktrace)
+		open_tracing_on();
+
+	/* page faults are latencies we do not want to measure */
+	if (mlockall(MCL_CURRENT | MCL_FUTURE))
+		fprintf(stderr, "warning: mlockall failed: %s\n",
+			strerror(errno));
+
+	threads = zalloc(sizeof(*threads) * nr_threads);
+	if (!threads)
+		die("cannot allocate %d thread descriptors\n", nr_threads);
+
+	for (i = 0; i < nr_threads; i++) {
+		threads[i].cpu = i % nr_cpus;
+		err = pthread_create(&threads[i].thread, NULL,
+				     cyclic_thread_fn, &threads[i]);
+		if (err)
+			die("pthread_create failed: %s\n", strerror(err));
+	}
+
+	for (i = 0; i < nr_threads; i++) {
+		pthread_join(threads[i].thread, NULL);
+		if (threads[i].err)
+			err = threads[i].err;
+		if (!threads[i].cycles)
+			continue;
+		if (threads[i].min < min)
+			min = threads[i].min;
+		if (threads[i].max > max)
+			max = threads[i].max;
+		sum += threads[i].sum;
+		cycles += threads[i].cycles;
+	}
+
+	if (err) {
+		fprintf(stderr, "measurement thread failed: %s%s\n",
+			strerror(err), err == EPERM ?
+			" (SCHED_FIFO needs root or CAP_SYS_NICE)" : "");
+		return 1;
+	}
+
+	if (!cycles)
+		min = 0;
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf("# %d threads, priority %d, interval %d usecs,"
+		       " %d loops\n\n", nr_threads, priority, interval, loops);
+
+		for (i = 0; i < nr_threads; i++) {
+			struct cyclic_thread *t = &threads[i];
+
+			printf(" T:%2d CPU:%2d C:%8lu Min:%7llu Avg:%7llu"
+			       " Max:%7llu\n", i, t->cpu, t->cycles,
+			       t->cycles ? t->min / NSEC_PER_USEC : 0,
+			       t->cycles ? t->sum / t->cycles / NSEC_PER_USEC : 0,
+			       t->max / NSEC_PER_USEC);
+		}
+
+		printf("\n %14s: %llu [usec]\n", "Min latency",
+		       min / NSEC_PER_USEC);
+		printf(" %14s: %llu [usec]\n", "Avg latency",
+		       cycles ? sum / cycles / NSEC_PER_USEC : 0);
+		printf(" %14s: %llu [usec]\n", "Max latency",
+		       max / NSEC_PER_USEC);
+
+		if (done)
+			printf("\n# Stopped: latency above %d usecs,"
+			       " tracing stopped\n", breaktrace);
+
+		if (show_hist)
+			print_hist();
+		break;
+
+	case BENCH_FORMAT_SIMPLE:
+		printf("%llu %llu %llu\n", min / NSEC_PER_USEC,
+		       cycles ? sum / cycles / NSEC_PER_USEC : 0,
+		       max / NSEC_PER_USEC);
+		break;
+
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+		break;
+	}
+
+	free(threads);
+	if (tracing_on_fd >= 0)
+		close(tracing_on_fd);
+
+	return 0;
+}
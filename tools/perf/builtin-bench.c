@@ -13,6 +13,7 @@
  * Available subsystem list:
  *  sched ... scheduler and IPC mechanism
  *  mem   ... memory access performance
+ *  futex ... futex performance
  *
  */
 
@@ -30,6 +31,8 @@ struct bench_suite {
 	const char *name;
 	const char *summary;
 	int (*fn)(int, const char **, const char *);
+	/* not run by "all": needs privileges or runs for long */
+	int skip_all;
 };
 						\
 /* sentinel: easy for help */
@@ -42,6 +45,10 @@ static struct bench_suite sched_suites[] = {
 	{ "pipe",
 	  "Flood of communication over pipe() between two processes",
 	  bench_sched_pipe      },
+	{ "cyclic",
+	  "Timer wakeup latency of SCHED_FIFO threads (cyclictest)",
+	  bench_sched_cyclic,
+	  1                     },
 	suite_all,
 	{ NULL,
 	  NULL,
@@ -52,6 +59,31 @@ static struct bench_suite mem_suites[] = {
 	{ "memcpy",
 	  "Simple memory copy in various ways",
 	  bench_mem_memcpy },
+	{ "tlb",
+	  "Pointer chase across pages to measure TLB misses",
+	  bench_mem_tlb },
+	suite_all,
+	{ NULL,
+	  NULL,
+	  NULL             }
+};
+
+static struct bench_suite futex_suites[] = {
+	{ "hash",
+	  "Futex hashing of many futexes from many threads",
+	  bench_futex_hash },
+	{ "wake",
+	  "Wake up N threads blocked on a futex",
+	  bench_futex_wake },
+	{ "wake-parallel",
+	  "Wake up N threads from several waker threads at once",
+	  bench_futex_wake_parallel },
+	{ "requeue",
+	  "Requeue N threads from one futex to another (broadcast)",
+	  bench_futex_requeue },
+	{ "lock-pi",
+	  "Contention on a PI futex (FUTEX_LOCK_PI/FUTEX_UNLOCK_PI)",
+	  bench_futex_lock_pi },
 	suite_all,
 	{ NULL,
 	  NULL,
@@ -71,6 +103,9 @@ static struct bench_subsys subsystems[] = {
 	{ "mem",
 	  "memory access performance",
 	  mem_suites },
+	{ "futex",
+	  "futex stressing",
+	  futex_suites },
 	{ "all",		/* sentinel: easy for help */
 	  "test all subsystem (pseudo subsystem)",
 	  NULL },
@@ -153,6 +188,9 @@ static void all_suite(struct bench_subsys *subsys)	  /* FROM HERE */
 	 * will be helpful
 	 */
 	for (i = 0; suites[i].fn; i++) {
+		if (suites[i].skip_all)
+			continue;
+
 		printf("# Running %s/%s benchmark...\n",
 		       subsys->name,
 		       suites[i].name);
@@ -0,0 +1,634 @@
+#include "builtin.h"
+#include "perf.h"
+
+#include "util/util.h"
+#include "util/cache.h"
+#include "util/symbol.h"
+#include "util/thread.h"
+#include "util/header.h"
+#include "util/session.h"
+
+#include "util/parse-options.h"
+#include "util/trace-event.h"
+
+#include "util/debug.h"
+
+#include <linux/rbtree.h>
+
+static char const		*input_name = "perf.data";
+
+static char const		*sort_key = "wait_total";
+static int			caller_flag;
+static int			nr_lines = -1;
+static int			raw_ip;
+
+#define LOCK_HASH_BITS		12
+#define LOCK_HASH_SIZE		(1 << LOCK_HASH_BITS)
+#define lock_hashfn(addr)	\
+	((unsigned long)((addr) >> 4) & (LOCK_HASH_SIZE - 1))
+
+/* one per lock instance, keyed by lock (or lockdep map) address */
+struct lock_stat {
+	struct lock_stat	*next;
+	struct rb_node		node;
+
+	u64			addr;
+	char			*name;
+
+	unsigned long		nr_acquired;
+	unsigned long		nr_contended;
+	unsigned long		nr_released;
+
+	u64			wait_time_total;
+	u64			wait_time_max;
+
+	u64			hold_time_total;
+	u64			hold_time_max;
+};
+
+/* where a lock was contended from */
+struct callsite_stat {
+	struct callsite_stat	*next;
+	struct rb_node		node;
+
+	struct lock_stat	*ls;
+	u64			ip;
+
+	unsigned long		nr_contended;
+	u64			wait_time_total;
+	u64			wait_time_max;
+};
+
+/* what a task is doing with a lock right now */
+struct lock_seq {
+	struct lock_seq		*next;
+
+	u64			addr;
+	int			tid;
+
+	u64			acquire_time;
+	u64			contended_time;
+	u64			contended_ip;
+	u64			acquired_time;
+};
+
+static struct lock_stat		*lock_hash[LOCK_HASH_SIZE];
+static struct callsite_stat	*callsite_hash[LOCK_HASH_SIZE];
+static struct lock_seq		*seq_hash[LOCK_HASH_SIZE];
+
+static unsigned long		nr_lock_events;
+static unsigned long		nr_unmatched;
+
+static struct lock_stat *lock_stat_findnew(u64 addr, const char *name)
+{
+	struct lock_stat **head = &lock_hash[lock_hashfn(addr)];
+	struct lock_stat *ls;
+
+	for (ls = *head; ls; ls = ls->next)
+		if (ls->addr == addr)
+			goto found;
+
+	ls = zalloc(sizeof(*ls));
+	if (!ls)
+		die("No memory");
+	ls->addr = addr;
+	ls->next = *head;
+	*head = ls;
+found:
+	if (!ls->name && name && *name) {
+		ls->name = strdup(name);
+		if (!ls->name)
+			die("No memory");
+	}
+	return ls;
+}
+
+static struct callsite_stat *callsite_findnew(struct lock_stat *ls, u64 ip)
+{
+	struct callsite_stat **head;
+	struct callsite_stat *cs;
+
+	head = &callsite_hash[lock_hashfn(ls->addr ^ ip)];
+	for (cs = *head; cs; cs = cs->next)
+		if (cs->ls == ls && cs->ip == ip)
+			return cs;
+
+	cs = zalloc(sizeof(*cs));
+	if (!cs)
+		die("No memory");
+	cs->ls = ls;
+	cs->ip = ip;
+	cs->next = *head;
+	*head = cs;
+	return cs;
+}
+
+static struct lock_seq *lock_seq_findnew(u64 addr, int tid)
+{
+	struct lock_seq **head = &seq_hash[lock_hashfn(addr ^ tid)];
+	struct lock_seq *seq;
+
+	for (seq = *head; seq; seq = seq->next)
+		if (seq->addr == addr && seq->tid == tid)
+			return seq;
+
+	seq = zalloc(sizeof(*seq));
+	if (!seq)
+		die("No memory");
+	seq->addr = addr;
+	seq->tid = tid;
+	seq->next = *head;
+	*head = seq;
+	return seq;
+}
+
+/*
+ * The lockdep flavour of the events carries the lock class name as a
+ * dynamic string, the lockdep-less one only has the lock address.
+ */
+static const char *lock_event_name(struct event *event, void *data)
+{
+	unsigned long long loc = raw_field_value(event, "name", data);
+
+	if (!(loc & 0xffff))
+		return NULL;
+
+	return (char *)data + (loc & 0xffff);
+}
+
+static void
+process_lock_acquire_event(struct lock_stat *ls __used, struct lock_seq *seq,
+			   u64 ip __used, u64 timestamp)
+{
+	seq->acquire_time = timestamp;
+	seq->contended_time = 0;
+	seq->acquired_time = 0;
+}
+
+static void
+process_lock_contended_event(struct lock_stat *ls, struct lock_seq *seq,
+			     u64 ip, u64 timestamp)
+{
+	ls->nr_contended++;
+	seq->contended_time = timestamp;
+	seq->contended_ip = ip;
+}
+
+static void
+process_lock_acquired_event(struct lock_stat *ls, struct lock_seq *seq,
+			    u64 ip __used, u64 timestamp)
+{
+	struct callsite_stat *cs;
+	u64 wait;
+
+	ls->nr_acquired++;
+	seq->acquired_time = timestamp;
+
+	if (!seq->contended_time)
+		return;
+
+	if (timestamp < seq->contended_time) {
+		nr_unmatched++;
+		seq->contended_time = 0;
+		return;
+	}
+
+	wait = timestamp - seq->contended_time;
+	seq->contended_time = 0;
+
+	ls->wait_time_total += wait;
+	if (wait > ls->wait_time_max)
+		ls->wait_time_max = wait;
+
+	cs = callsite_findnew(ls, seq->contended_ip);
+	cs->nr_contended++;
+	cs->wait_time_total += wait;
+	if (wait > cs->wait_time_max)
+		cs->wait_time_max = wait;
+}
+
+static void
+process_lock_release_event(struct lock_stat *ls, struct lock_seq *seq,
+			   u64 ip __used, u64 timestamp)
+{
+	u64 start, hold;
+
+	/*
+	 * Without lock statistics lockdep does not emit lock_acquired,
+	 * fall back to the acquire attempt in that case.
+	 */
+	start = seq->acquired_time ? seq->acquired_time : seq->acquire_time;
+	seq->acquire_time = 0;
+	seq->acquired_time = 0;
+
+	if (!start || timestamp < start) {
+		nr_unmatched++;
+		return;
+	}
+
+	hold = timestamp - start;
+	ls->nr_released++;
+	ls->hold_time_total += hold;
+	if (hold > ls->hold_time_max)
+		ls->hold_time_max = hold;
+}
+
+struct lock_event_handler {
+	const char	*name;
+	void		(*handler)(struct lock_stat *ls, struct lock_seq *seq,
+				   u64 ip, u64 timestamp);
+};
+
+static struct lock_event_handler lock_event_handlers[] = {
+	{ "lock_acquire",	process_lock_acquire_event	},
+	{ "lock_contended",	process_lock_contended_event	},
+	{ "lock_acquired",	process_lock_acquired_event	},
+	{ "lock_release",	process_lock_release_event	},
+};
+
+static void
+process_raw_event(event_t *raw_event __used, void *data,
+		  int cpu __used, u64 timestamp, int tid)
+{
+	struct event *event;
+	struct lock_stat *ls;
+	struct lock_seq *seq;
+	unsigned int i;
+	u64 addr, ip;
+	int type;
+
+	type = trace_parse_common_type(data);
+	event = trace_find_event(type);
+	if (!event)
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(lock_event_handlers); i++)
+		if (!strcmp(event->name, lock_event_handlers[i].name))
+			break;
+	if (i == ARRAY_SIZE(lock_event_handlers))
+		return;
+
+	addr = raw_field_value(event, "lockdep_addr", data);
+	ip = raw_field_value(event, "ip", data);
+
+	ls = lock_stat_findnew(addr, lock_event_name(event, data));
+	seq = lock_seq_findnew(addr, tid);
+
+	nr_lock_events++;
+	lock_event_handlers[i].handler(ls, seq, ip, timestamp);
+}
+
+static int process_sample_event(event_t *event, struct perf_session *session)
+{
+	struct sample_data data;
+
+	memset(&data, 0, sizeof(data));
+	data.time = -1;
+	data.cpu = -1;
+	data.period = 1;
+
+	event__parse_sample(event, session->sample_type, &data);
+
+	dump_printf("(IP, %d): %d/%d: %p period: %Ld\n",
+		event->header.misc,
+		data.pid, data.tid,
+		(void *)(long)data.ip,
+		(long long)data.period);
+
+	process_raw_event(event, data.raw_data, data.cpu,
+			  data.time, data.tid);
+
+	return 0;
+}
+
+static int sample_type_check(struct perf_session *session)
+{
+	if (!(session->sample_type & PERF_SAMPLE_RAW)) {
+		fprintf(stderr,
+			"No trace sample to read. Did you call perf record "
+			"without -R?");
+		return -1;
+	}
+
+	return 0;
+}
+
+static struct perf_event_ops event_ops = {
+	.process_sample_event	= process_sample_event,
+	.process_comm_event	= event__process_comm,
+	.sample_type_check	= sample_type_check,
+};
+
+typedef int (*lock_cmp_fn_t)(struct lock_stat *, struct lock_stat *);
+
+#define LOCK_CMP(field)							\
+static int lock_cmp_##field(struct lock_stat *l, struct lock_stat *r)	\
+{									\
+	if (l->field < r->field)					\
+		return -1;						\
+	else if (l->field > r->field)					\
+		return 1;						\
+	return 0;							\
+}
+
+LOCK_CMP(nr_acquired)
+LOCK_CMP(nr_contended)
+LOCK_CMP(wait_time_total)
+LOCK_CMP(wait_time_max)
+LOCK_CMP(hold_time_total)
+LOCK_CMP(hold_time_max)
+
+static int lock_cmp_avg_wait(struct lock_stat *l, struct lock_stat *r)
+{
+	u64 lavg = l->nr_contended ? l->wait_time_total / l->nr_contended : 0;
+	u64 ravg = r->nr_contended ? r->wait_time_total / r->nr_contended : 0;
+
+	if (lavg < ravg)
+		return -1;
+	else if (lavg > ravg)
+		return 1;
+	return 0;
+}
+
+struct lock_sort_key {
+	const char	*name;
+	lock_cmp_fn_t	cmp;
+};
+
+static struct lock_sort_key lock_sort_keys[] = {
+	{ "acquired",	lock_cmp_nr_acquired		},
+	{ "contended",	lock_cmp_nr_contended		},
+	{ "wait_total",	lock_cmp_wait_time_total	},
+	{ "wait_max",	lock_cmp_wait_time_max		},
+	{ "wait_avg",	lock_cmp_avg_wait		},
+	{ "hold_total",	lock_cmp_hold_time_total	},
+	{ "hold_max",	lock_cmp_hold_time_max		},
+};
+
+static lock_cmp_fn_t lock_cmp;
+
+static struct rb_root		sorted_locks;
+static struct rb_root		sorted_callsites;
+
+static void insert_lock(struct lock_stat *ls)
+{
+	struct rb_node **new = &sorted_locks.rb_node;
+	struct rb_node *parent = NULL;
+
+	while (*new) {
+		struct lock_stat *this = rb_entry(*new, struct lock_stat, node);
+
+		parent = *new;
+		/* biggest first */
+		if (lock_cmp(ls, this) > 0)
+			new = &parent->rb_left;
+		else
+			new = &parent->rb_right;
+	}
+
+	rb_link_node(&ls->node, parent, new);
+	rb_insert_color(&ls->node, &sorted_locks);
+}
+
+static void insert_callsite(struct callsite_stat *cs)
+{
+	struct rb_node **new = &sorted_callsites.rb_node;
+	struct rb_node *parent = NULL;
+
+	while (*new) {
+		struct callsite_stat *this;
+
+		this = rb_entry(*new, struct callsite_stat, node);
+		parent = *new;
+		if (cs->wait_time_total > this->wait_time_total)
+			new = &parent->rb_left;
+		else
+			new = &parent->rb_right;
+	}
+
+	rb_link_node(&cs->node, parent, new);
+	rb_insert_color(&cs->node, &sorted_callsites);
+}
+
+static void sort_result(void)
+{
+	struct callsite_stat *cs;
+	struct lock_stat *ls;
+	int i;
+
+	for (i = 0; i < LOCK_HASH_SIZE; i++) {
+		for (ls = lock_hash[i]; ls; ls = ls->next)
+			insert_lock(ls);
+		for (cs = callsite_hash[i]; cs; cs = cs->next)
+			insert_callsite(cs);
+	}
+}
+
+static const char *lock_name(struct lock_stat *ls, char *buf, size_t size)
+{
+	if (ls->name)
+		return ls->name;
+
+	snprintf(buf, size, "%#Lx", ls->addr);
+	return buf;
+}
+
+static void print_locks(void)
+{
+	struct rb_node *next;
+	int n_lines = nr_lines;
+	char buf[64];
+
+	printf("%.127s\n", graph_dotted_line);
+	printf(" %-32s | %10s | %10s | %12s | %12s | %12s | %12s | %12s\n",
+	       "Lock", "acquired", "contended", "wait total",
+	       "wait avg", "wait max", "hold total", "hold max");
+	printf(" %-32s | %10s | %10s | %12s | %12s | %12s | %12s | %12s\n",
+	       "", "", "", "(usecs)", "(usecs)", "(usecs)",
+	       "(usecs)", "(usecs)");
+	printf("%.127s\n", graph_dotted_line);
+
+	next = rb_first(&sorted_locks);
+	while (next && n_lines--) {
+		struct lock_stat *ls = rb_entry(next, struct lock_stat, node);
+
+		printf(" %-32.32s | %10lu | %10lu | %12.3f | %12.3f | %12.3f |"
+		       " %12.3f | %12.3f\n",
+		       lock_name(ls, buf, sizeof(buf)),
+		       ls->nr_acquired, ls->nr_contended,
+		       (double)ls->wait_time_total / 1e3,
+		       ls->nr_contended ? (double)ls->wait_time_total /
+					  ls->nr_contended / 1e3 : 0.0,
+		       (double)ls->wait_time_max / 1e3,
+		       (double)ls->hold_time_total / 1e3,
+		       (double)ls->hold_time_max / 1e3);
+
+		next = rb_next(next);
+	}
+
+	if (next)
+		printf(" ...\n");
+
+	printf("%.127s\n", graph_dotted_line);
+}
+
+static void print_callsites(struct perf_session *session)
+{
+	struct rb_node *next;
+	int n_lines = nr_lines;
+	char buf[BUFSIZ], lbuf[64];
+
+	printf("\n%.127s\n", graph_dotted_line);
+	printf(" %-48s | %-32s | %10s | %12s | %12s\n",
+	       "Callsite", "Lock", "contended", "wait total", "wait max");
+	printf("%.127s\n", graph_dotted_line);
+
+	next = rb_first(&sorted_callsites);
+	while (next && n_lines--) {
+		struct callsite_stat *cs;
+		struct symbol *sym = NULL;
+
+		cs = rb_entry(next, struct callsite_stat, node);
+		if (!raw_ip)
+			sym = map_groups__find_function(&session->kmaps,
+							session, cs->ip, NULL);
+		if (sym != NULL)
+			snprintf(buf, sizeof(buf), "%s+%Lx", sym->name,
+				 cs->ip - sym->start);
+		else
+			snprintf(buf, sizeof(buf), "%#Lx", cs->ip);
+
+		printf(" %-48.48s | %-32.32s | %10lu | %12.3f | %12.3f\n",
+		       buf, lock_name(cs->ls, lbuf, sizeof(lbuf)),
+		       cs->nr_contended,
+		       (double)cs->wait_time_total / 1e3,
+		       (double)cs->wait_time_max / 1e3);
+
+		next = rb_next(next);
+	}
+
+	if (next)
+		printf(" ...\n");
+
+	printf("%.127s\n", graph_dotted_line);
+}
+
+static void print_result(struct perf_session *session)
+{
+	print_locks();
+	if (caller_flag)
+		print_callsites(session);
+
+	printf("\nSUMMARY\n=======\n");
+	printf("Total lock events: %lu\n", nr_lock_events);
+	if (nr_unmatched)
+		printf("Unmatched events:  %lu\n", nr_unmatched);
+}
+
+static int __cmd_report(void)
+{
+	int err;
+	struct perf_session *session = perf_session__new(input_name, O_RDONLY, 0);
+	if (session == NULL)
+		return -ENOMEM;
+
+	setup_pager();
+	err = perf_session__process_events(session, &event_ops);
+	if (err != 0)
+		goto out_delete;
+	sort_result();
+	print_result(session);
+out_delete:
+	perf_session__delete(session);
+	return err;
+}
+
+static const char * const lock_usage[] = {
+	"perf lock [<options>] {record|report}",
+	NULL
+};
+
+static const struct option lock_options[] = {
+	OPT_STRING('i', "input", &input_name, "file",
+		   "input file name"),
+	OPT_STRING('k', "key", &sort_key, "key",
+		   "sort locks by key: acquired, contended, wait_total,"
+		   " wait_max, wait_avg, hold_total, hold_max"),
+	OPT_BOOLEAN('c', "caller", &caller_flag,
+		    "show per-callsite contention statistics"),
+	OPT_INTEGER('l', "line", &nr_lines,
+		    "show n lines"),
+	OPT_BOOLEAN(0, "raw-ip", &raw_ip, "show raw ip instead of symbol"),
+	OPT_END()
+};
+
+static void setup_sorting(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(lock_sort_keys); i++) {
+		if (!strcmp(lock_sort_keys[i].name, sort_key)) {
+			lock_cmp = lock_sort_keys[i].cmp;
+			return;
+		}
+	}
+
+	error("Unknown sort key: %s\n", sort_key);
+	usage_with_options(lock_usage, lock_options);
+}
+
+static const char *record_args[] = {
+	"record",
+	"-a",
+	"-R",
+	"-f",
+	"-m", "1024",
+	"-c", "1",
+	"-e", "lock:lock_acquire:r",
+	"-e", "lock:lock_acquired:r",
+	"-e", "lock:lock_contended:r",
+	"-e", "lock:lock_release:r",
+};
+
+static int __cmd_record(int argc, const char **argv)
+{
+	unsigned int rec_argc, i, j;
+	const char **rec_argv;
+
+	rec_argc = ARRAY_SIZE(record_args) + argc - 1;
+	rec_argv = calloc(rec_argc + 1, sizeof(char *));
+
+	for (i = 0; i < ARRAY_SIZE(record_args); i++)
+		rec_argv[i] = strdup(record_args[i]);
+
+	for (j = 1; j < (unsigned int)argc; j++, i++)
+		rec_argv[i] = argv[j];
+
+	return cmd_record(i, rec_argv, NULL);
+}
+
+int cmd_lock(int argc, const char **argv, const char *prefix __used)
+{
+	argc = parse_options(argc, argv, lock_options, lock_usage,
+			     PARSE_OPT_STOP_AT_NON_OPTION);
+	if (!argc)
+		usage_with_options(lock_usage, lock_options);
+
+	symbol__init();
+
+	if (!strncmp(argv[0], "rec", 3)) {
+		return __cmd_record(argc, argv);
+	} else if (!strncmp(argv[0], "rep", 3)) {
+		if (argc > 1) {
+			argc = parse_options(argc, argv, lock_options,
+					     lock_usage, 0);
+			if (argc)
+				usage_with_options(lock_usage, lock_options);
+		}
+		setup_sorting();
+		return __cmd_report();
+	} else
+		usage_with_options(lock_usage, lock_options);
+
+	return 0;
+}
@@ -1795,9 +1795,321 @@ static void __cmd_replay(void)
 		run_one_test();
 }
 
+/*
+ * timehist: for every context switch, show how long the task that is
+ * switched out waited before it got the CPU (wait time), how much of
+ * that it spent runnable but not running (scheduling delay) and how
+ * long it then ran. Everything is computed in a single pass over the
+ * events, only keeping a small amount of state per task and per CPU.
+ */
+#define TIMEHIST_HASH_BITS	10
+#define TIMEHIST_HASH_SIZE	(1 << TIMEHIST_HASH_BITS)
+
+struct timehist_task {
+	struct timehist_task	*next;
+	u32			pid;
+	char			comm[COMM_LEN];
+
+	u64			sched_in_time;	/* 0 if not running */
+	u64			sched_out_time;	/* last switch out */
+	u64			ready_time;	/* woken up or preempted */
+	u64			cur_wait;
+	u64			cur_delay;
+
+	unsigned long		nr_switches;
+	u64			total_run;
+	u64			total_wait;
+	u64			total_delay;
+	u64			max_delay;
+	u64			max_delay_at;
+};
+
+struct timehist_cpu {
+	unsigned long		nr_switches;
+	u64			idle_start;	/* 0 if not idle */
+	unsigned long		nr_idle;
+	u64			total_idle;
+	u64			max_idle;
+	u64			max_idle_at;
+};
+
+static struct timehist_task	*timehist_hash[TIMEHIST_HASH_SIZE];
+static unsigned long		timehist_nr_tasks;
+static struct timehist_cpu	timehist_cpus[MAX_CPUS];
+static int			timehist_max_cpu = -1;
+static u64			timehist_first_time;
+static u64			timehist_last_time;
+
+static int			timehist_summary_only;
+static int			timehist_with_summary;
+static int			timehist_pid = -1;
+
+static struct timehist_task *timehist_findnew(u32 pid, const char *comm)
+{
+	struct timehist_task **head, *task;
+
+	head = &timehist_hash[pid & (TIMEHIST_HASH_SIZE - 1)];
+	for (task = *head; task; task = task->next) {
+		if (task->pid == pid)
+			goto out;
+	}
+
+	task = zalloc(sizeof(*task));
+	if (!task)
+		die("out of memory for timehist task %d\n", pid);
+	task->pid = pid;
+	task->next = *head;
+	*head = task;
+	timehist_nr_tasks++;
+out:
+	if (comm)
+		strncpy(task->comm, comm, COMM_LEN - 1);
+	return task;
+}
+
+static void timehist_header(void)
+{
+	printf("%15s %6s  %-30s  %9s  %9s  %9s\n",
+	       "time", "cpu", "task name", "wait time", "sch delay",
+	       "run time");
+	printf("%15s %6s  %-30s  %9s  %9s  %9s\n",
+	       "", "", "[pid]", "(msec)", "(msec)", "(msec)");
+	printf("--------------- ------  ------------------------------"
+	       "  ---------  ---------  ---------\n");
+}
+
+static void timehist_print_event(u64 timestamp, int cpu, const char *comm,
+				 u32 pid, u64 wait, u64 delay, u64 run)
+{
+	char name[COMM_LEN + 16];
+
+	if (timehist_summary_only)
+		return;
+	if (timehist_pid != -1 && (u32)timehist_pid != pid)
+		return;
+
+	snprintf(name, sizeof(name), "%s[%d]", comm, pid);
+	printf("%15.6f [%04d]  %-30s  %9.3f  %9.3f  %9.3f\n",
+	       (double)timestamp / 1e9, cpu, name,
+	       (double)wait / 1e6, (double)delay / 1e6, (double)run / 1e6);
+}
+
+static void
+timehist_wakeup_event(struct trace_wakeup_event *wakeup_event,
+		      struct perf_session *session __used,
+		      struct event *event __used,
+		      int cpu __used,
+		      u64 timestamp,
+		      struct thread *thread __used)
+{
+	struct timehist_task *task;
+
+	if (!wakeup_event->pid)
+		return;
+
+	task = timehist_findnew(wakeup_event->pid, wakeup_event->comm);
+
+	/* a running or already runnable task does not become ready again */
+	if (!task->sched_in_time && !task->ready_time)
+		task->ready_time = timestamp;
+}
+
+/*
+ * The events of different CPUs are not strictly ordered, so the start of
+ * an interval may come after its end.  Such a sample is counted as an
+ * unordered timestamp and left out, instead of wrapping around.
+ */
+static int timehist_delta(u64 timestamp, u64 start, u64 *delta)
+{
+	*delta = 0;
+	if (!start)
+		return 0;
+
+	nr_timestamps++;
+	if (timestamp < start) {
+		nr_unordered_timestamps++;
+		return 0;
+	}
+
+	*delta = timestamp - start;
+	return 1;
+}
+
+static void
+timehist_switch_event(struct trace_switch_event *switch_event,
+		      struct perf_session *session __used,
+		      struct event *event __used,
+		      int this_cpu,
+		      u64 timestamp,
+		      struct thread *thread __used)
+{
+	struct timehist_task *prev, *next;
+	struct timehist_cpu *cpu;
+	u64 run, idle;
+
+	if (this_cpu >= MAX_CPUS || this_cpu < 0)
+		return;
+
+	if (!timehist_first_time)
+		timehist_first_time = timestamp;
+	if (timestamp > timehist_last_time)
+		timehist_last_time = timestamp;
+
+	if (this_cpu > timehist_max_cpu)
+		timehist_max_cpu = this_cpu;
+	cpu = &timehist_cpus[this_cpu];
+	cpu->nr_switches++;
+
+	/* account the task going out */
+	if (!switch_event->prev_pid) {
+		if (timehist_delta(timestamp, cpu->idle_start, &idle)) {
+			cpu->nr_idle++;
+			cpu->total_idle += idle;
+			if (idle > cpu->max_idle) {
+				cpu->max_idle = idle;
+				cpu->max_idle_at = timestamp;
+			}
+			timehist_print_event(timestamp, this_cpu, "<idle>", 0,
+					     0, 0, idle);
+		}
+		cpu->idle_start = 0;
+	} else {
+		prev = timehist_findnew(switch_event->prev_pid,
+					switch_event->prev_comm);
+
+		/* we did not see it being switched in: start of the trace */
+		if (timehist_delta(timestamp, prev->sched_in_time, &run)) {
+			prev->nr_switches++;
+			prev->total_run += run;
+			prev->total_wait += prev->cur_wait;
+			prev->total_delay += prev->cur_delay;
+			if (prev->cur_delay > prev->max_delay) {
+				prev->max_delay = prev->cur_delay;
+				prev->max_delay_at = prev->sched_in_time;
+			}
+			timehist_print_event(timestamp, this_cpu, prev->comm,
+					     prev->pid, prev->cur_wait,
+					     prev->cur_delay, run);
+		}
+
+		prev->sched_in_time = 0;
+		prev->sched_out_time = timestamp;
+		prev->cur_wait = 0;
+		prev->cur_delay = 0;
+		/* preempted: it stays runnable, so the delay starts now */
+		prev->ready_time = switch_event->prev_state ? 0 : timestamp;
+	}
+
+	/* and the one coming in */
+	if (!switch_event->next_pid) {
+		cpu->idle_start = timestamp;
+		return;
+	}
+
+	next = timehist_findnew(switch_event->next_pid,
+				switch_event->next_comm);
+	next->sched_in_time = timestamp;
+	timehist_delta(timestamp, next->sched_out_time, &next->cur_wait);
+	timehist_delta(timestamp, next->ready_time, &next->cur_delay);
+	next->ready_time = 0;
+}
+
+static struct trace_sched_handler timehist_ops  = {
+	.wakeup_event		= timehist_wakeup_event,
+	.switch_event		= timehist_switch_event,
+};
+
+static int timehist_task_cmp(const void *a, const void *b)
+{
+	const struct timehist_task *l = *(struct timehist_task * const *)a;
+	const struct timehist_task *r = *(struct timehist_task * const *)b;
+
+	if (l->total_run == r->total_run)
+		return l->pid - r->pid;
+	return l->total_run < r->total_run ? 1 : -1;
+}
+
+static void timehist_print_summary(void)
+{
+	struct timehist_task **sorted, *task;
+	u64 span = timehist_last_time - timehist_first_time;
+	unsigned long i, n = 0;
+	int cpu;
+
+	sorted = calloc(timehist_nr_tasks + 1, sizeof(*sorted));
+	if (!sorted)
+		die("out of memory for timehist summary\n");
+
+	for (i = 0; i < TIMEHIST_HASH_SIZE; i++)
+		for (task = timehist_hash[i]; task; task = task->next)
+			if (task->nr_switches)
+				sorted[n++] = task;
+	qsort(sorted, n, sizeof(*sorted), timehist_task_cmp);
+
+	printf("\nRuntime summary\n");
+	printf("%30s  %8s  %11s  %11s  %11s  %11s  %13s\n",
+	       "comm[pid]", "switches", "run (ms)", "wait (ms)",
+	       "avg delay", "max delay", "max delay at");
+	printf("----------------------------------------------------------"
+	       "------------------------------------------------------\n");
+
+	for (i = 0; i < n; i++) {
+		char name[COMM_LEN + 16];
+
+		task = sorted[i];
+		snprintf(name, sizeof(name), "%s[%d]", task->comm, task->pid);
+		printf("%30s  %8lu  %11.3f  %11.3f  %11.3f  %11.3f  %13.6f\n",
+		       name, task->nr_switches,
+		       (double)task->total_run / 1e6,
+		       (double)task->total_wait / 1e6,
+		       (double)task->total_delay / task->nr_switches / 1e6,
+		       (double)task->max_delay / 1e6,
+		       (double)task->max_delay_at / 1e9);
+	}
+	free(sorted);
+
+	printf("\nCPU summary (trace span %.3f ms)\n", (double)span / 1e6);
+	printf("%6s  %8s  %8s  %11s  %7s  %11s  %11s  %13s\n",
+	       "cpu", "switches", "idles", "idle (ms)", "idle %",
+	       "avg idle", "max idle", "max idle at");
+	printf("----------------------------------------------------------"
+	       "------------------------------------------\n");
+
+	for (cpu = 0; cpu <= timehist_max_cpu; cpu++) {
+		struct timehist_cpu *c = &timehist_cpus[cpu];
+
+		if (!c->nr_switches)
+			continue;
+
+		printf("%6d  %8lu  %8lu  %11.3f  %6.2f%%  %11.3f  %11.3f  %13.6f\n",
+		       cpu, c->nr_switches, c->nr_idle,
+		       (double)c->total_idle / 1e6,
+		       span ? (double)c->total_idle * 100.0 / span : 0.0,
+		       c->nr_idle ? (double)c->total_idle / c->nr_idle / 1e6 : 0.0,
+		       (double)c->max_idle / 1e6,
+		       (double)c->max_idle_at / 1e9);
+	}
+}
+
+static void __cmd_timehist(void)
+{
+	setup_pager();
+
+	if (!timehist_summary_only)
+		timehist_header();
+
+	read_events();
+
+	if (timehist_summary_only || timehist_with_summary)
+		timehist_print_summary();
+
+	print_bad_events();
+	printf("\n");
+}
+
 
 static const char * const sched_usage[] = {
-	"perf sched [<options>] {record|latency|map|replay|trace}",
+	"perf sched [<options>] {record|latency|map|replay|timehist|trace}",
 	NULL
 };
 
@@ -1843,6 +2155,27 @@ static const struct option replay_options[] = {
 	OPT_END()
 };
 
+static const char * const timehist_usage[] = {
+	"perf sched timehist [<options>]",
+	NULL
+};
+
+static const struct option timehist_options[] = {
+	OPT_BOOLEAN('s', "summary", &timehist_summary_only,
+		    "show only the per-task and per-CPU summaries"),
+	OPT_BOOLEAN('S', "with-summary", &timehist_with_summary,
+		    "show the summaries after the events"),
+	OPT_INTEGER('p', "pid", &timehist_pid,
+		    "only show events of this pid"),
+	OPT_INTEGER('C', "CPU", &profile_cpu,
+		    "CPU to profile on"),
+	OPT_BOOLEAN('v', "verbose", &verbose,
+		    "be more verbose (show symbol address, etc)"),
+	OPT_BOOLEAN('D', "dump-raw-trace", &dump_trace,
+		    "dump raw trace in ASCII"),
+	OPT_END()
+};
+
 static void setup_sorting(void)
 {
 	char *tmp, *tok, *str = strdup(sort_order);
@@ -1935,6 +2268,16 @@ int cmd_sched(int argc, const char **argv, const char *prefix __used)
 				usage_with_options(replay_usage, replay_options);
 		}
 		__cmd_replay();
+	} else if (!strncmp(argv[0], "time", 4)) {
+		trace_handler = &timehist_ops;
+		if (argc > 1) {
+			argc = parse_options(argc, argv, timehist_options,
+					     timehist_usage, 0);
+			if (argc)
+				usage_with_options(timehist_usage,
+						   timehist_options);
+		}
+		__cmd_timehist();
 	} else {
 		usage_with_options(sched_usage, sched_options);
 	}
@@ -83,10 +83,49 @@ const char *x86_64_regs_table[X86_64_MAX_REGS] = {
 	"%r15",
 };
 
+#define MIPS_MAX_REGS 32
+const char *mips_regs_table[MIPS_MAX_REGS] = {
+	"%r0",
+	"%r1",
+	"%r2",
+	"%r3",
+	"%r4",
+	"%r5",
+	"%r6",
+	"%r7",
+	"%r8",
+	"%r9",
+	"%r10",
+	"%r11",
+	"%r12",
+	"%r13",
+	"%r14",
+	"%r15",
+	"%r16",
+	"%r17",
+	"%r18",
+	"%r19",
+	"%r20",
+	"%r21",
+	"%r22",
+	"%r23",
+	"%r24",
+	"%r25",
+	"%r26",
+	"%r27",
+	"%r28",
+	"%r29",
+	"%r30",
+	"%r31",
+};
+
 /* TODO: switching by dwarf address size */
 #ifdef __x86_64__
 #define ARCH_MAX_REGS X86_64_MAX_REGS
 #define arch_regs_table x86_64_regs_table
+#elif defined(__mips__)
+#define ARCH_MAX_REGS MIPS_MAX_REGS
+#define arch_regs_table mips_regs_table
 #else
 #define ARCH_MAX_REGS X86_32_MAX_REGS
 #define arch_regs_table x86_32_regs_table
@@ -95,7 +134,7 @@ const char *x86_64_regs_table[X86_64_MAX_REGS] = {
 /* Return architecture dependent register string (for kprobe-tracer) */
 static const char *get_arch_regstr(unsigned int n)
 {
-	return (n <= ARCH_MAX_REGS) ? arch_regs_table[n] : NULL;
+	return (n < ARCH_MAX_REGS) ? arch_regs_table[n] : NULL;
 }
 
 /*